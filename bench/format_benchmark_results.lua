@@ -4,6 +4,7 @@ local io = require 'io'
 local math = require 'math'
 
 local result = {}
+local sizes = {}
 local all_nums = {}
 
 local variant_type = nil
@@ -38,6 +39,13 @@ while line do
 
     -- print('matched a num_variants: ', num_variants)
 
+  elseif (line:find('  sizeof%(variant%) = ')) then
+    local match = line:match('%d+$')
+    assert(match)
+
+    if not sizes[variant_type] then sizes[variant_type] = {} end
+    sizes[variant_type][num_variants] = match
+
   elseif (line:find('average nanoseconds per visit:')) then
     time = line:match('average nanoseconds per visit: (.+)$')
     assert(time)
@@ -88,3 +96,31 @@ for vname, vtab in pairs(result) do
   end
   io.write(line .. '|\n')
 end
+
+-- Second table: sizeof(variant) in bytes, for each variant type and number of types
+
+io.write('\n')
+
+line = start_column('sizeof (bytes)')
+
+for k, _ in pairs(all_nums) do
+  line = add_entry(line, k)
+end
+
+io.write(line .. '|\n')
+
+line = start_column(string.rep('-', 28))
+
+for k, _ in pairs(all_nums) do
+  line = add_entry(line, '---------')
+end
+
+io.write(line .. '|\n')
+
+for vname, vtab in pairs(sizes) do
+  line = start_column('`' .. vname .. '`')
+  for k, _ in pairs(all_nums) do
+    line = add_entry(line, vtab[k])
+  end
+  io.write(line .. '|\n')
+end
@@ -99,6 +99,33 @@ set_type(dummy_variant_t<variant_template, N> & v, uint32_t idx) {
   funcs[idx % N](v);
 }
 
+// Skewed distribution of types.
+// If ZIPF_EXPONENT is defined, the type with index i is drawn with probability
+// proportional to 1 / (i + 1)^ZIPF_EXPONENT, instead of uniformly.
+// (The exponent must be a non-negative integer.)
+#ifdef ZIPF_EXPONENT
+
+constexpr uint32_t
+zipf_power(uint32_t base, uint32_t exponent) {
+  return exponent == 0 ? 1 : base * zipf_power(base, exponent - 1);
+}
+
+// Integral weight of the type with index i.
+constexpr uint32_t
+zipf_weight(uint32_t i) {
+  return 1000000u / zipf_power(i + 1, ZIPF_EXPONENT);
+}
+
+template <typename index_list>
+struct zipf_distribution;
+
+template <uint32_t... is>
+struct zipf_distribution<ilist<is...>> {
+  static std::discrete_distribution<uint32_t> make() { return {zipf_weight(is)...}; }
+};
+
+#endif // ZIPF_EXPONENT
+
 // Bench task, sets up a sequence of variant instances, and runs a task.
 
 template <template <class...> class variant_template, uint32_t num_variants, uint32_t seq_length>
@@ -125,10 +152,17 @@ struct bench_task {
       seed -= (seed >> 3);
     }*/
     std::mt19937 rng{seed};
+#ifdef ZIPF_EXPONENT
+    auto dist = zipf_distribution<Count_t<num_variants>>::make();
+    for (var_t & v : sequence_) {
+      set_type<variant_template, num_variants>(v, dist(rng));
+    }
+#else
     for (var_t & v : sequence_) {
       uint32_t x = static_cast<uint32_t>(rng());
       set_type<variant_template, num_variants>(v, x);
     }
+#endif
   }
 
   template <typename AV>
@@ -22,8 +22,14 @@ run_benchmark(const char * variant_name, const uint32_t seed) {
   using BenchTask_t = bench_task<var_t, num_variants, seq_length>;
   BenchTask_t task{seed};
 
-  std::fprintf(stdout, "%s:\n  num_variants = %u\n  seq_length = %u\n  repeat_num = %u\n\n",
-               variant_name, num_variants, seq_length, repeat_num);
+  std::fprintf(stdout, "%s:\n  num_variants = %u\n  seq_length = %u\n  repeat_num = %u\n"
+                       "  sizeof(variant) = %u\n",
+               variant_name, num_variants, seq_length, repeat_num,
+               static_cast<unsigned>(sizeof(typename BenchTask_t::var_t)));
+#ifdef ZIPF_EXPONENT
+  std::fprintf(stdout, "  distribution = zipf, exponent %u\n", ZIPF_EXPONENT);
+#endif
+  std::fprintf(stdout, "\n");
 
   benchmark::DoNotOptimize(task);
 
@@ -6,15 +6,68 @@ static constexpr uint32_t seq_length{SEQ_LENGTH};
 static constexpr uint32_t repeat_num{REPEAT_NUM};
 static constexpr uint32_t rng_seed{RNG_SEED};
 
+#define STRINGIFY_IMPL(X) #X
+#define STRINGIFY(X) STRINGIFY_IMPL(X)
+
+// Define DISPATCH_STRATEGY to one of the tags in `strict_variant::dispatch`
+// to measure that strategy, rather than the default one.
+//
+// With ZIPF_EXPONENT, define ZIPF_WEIGHTED to use `dispatch::weighted` with
+// the same weights as the distribution, or ZIPF_HOT to use
+// `dispatch::hot_types` with the most common type.
+#if defined(ZIPF_WEIGHTED)
+
+template <typename index_list>
+struct zipf_strategy;
+
+template <uint32_t... is>
+struct zipf_strategy<benchmark::ilist<is...>> {
+  using type = strict_variant::dispatch::weighted<benchmark::zipf_weight(is)...>;
+};
+
+using strategy_t = zipf_strategy<benchmark::Count_t<num_variants>>::type;
+#define STRATEGY_NAME "weighted"
+
+#elif defined(ZIPF_HOT)
+
+using strategy_t = strict_variant::dispatch::hot_types<0>;
+#define STRATEGY_NAME "hot_types<0>"
+
+#elif defined(DISPATCH_STRATEGY)
+
+using strategy_t = strict_variant::dispatch::DISPATCH_STRATEGY;
+#define STRATEGY_NAME STRINGIFY(DISPATCH_STRATEGY)
+
+#else
+
+using strategy_t = strict_variant::dispatch::automatic;
+
+#endif
+
+#ifdef ZIPF_EXPONENT
+#define DISTRIBUTION_NAME "zipf"
+#endif
+
+#if defined(STRATEGY_NAME) && defined(DISTRIBUTION_NAME)
+#define VARIANT_NAME "strict_variant::variant (" STRATEGY_NAME ", " DISTRIBUTION_NAME ")"
+#elif defined(STRATEGY_NAME)
+#define VARIANT_NAME "strict_variant::variant (" STRATEGY_NAME ")"
+#elif defined(DISTRIBUTION_NAME)
+#define VARIANT_NAME "strict_variant::variant (" DISTRIBUTION_NAME ")"
+#else
+#define VARIANT_NAME "strict_variant::variant"
+#endif
+
 struct visitor_applier {
   template <typename T>
   uint32_t operator()(T && t) const {
-    return strict_variant::apply_visitor(benchmark::visitor{}, std::forward<T>(t));
+    return strict_variant::apply_visitor_with<strategy_t>(benchmark::visitor{},
+                                                          std::forward<T>(t));
   }
 };
 
 int
 main() {
   benchmark::run_benchmark<strict_variant::variant, num_variants, seq_length, repeat_num,
-                           visitor_applier>("strict_variant::variant", rng_seed);
+                           visitor_applier>(VARIANT_NAME, rng_seed);
 }
@@ -0,0 +1,148 @@
+#include "bench_api.hpp"
+#include <strict_variant/atomic_variant.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***
+ * Measures threads sharing one variant, an `atomic_variant` or a variant
+ * behind a `std::mutex`. The variants fit in one word, two words, or four
+ * words, so that `atomic_variant` uses a `std::atomic` word, a double-width
+ * compare-and-swap if it is built with `-mcx16` (and a seqlock if not), or
+ * a seqlock.
+ *
+ * Each of `num_threads` threads performs REPEAT_NUM * 100 operations. In the
+ * "read" task they are all loads, in the "mixed" task one in eight is an
+ * update, and in the "write" task they are all updates. An update adds one
+ * to the value, with a compare-and-swap loop or under the lock.
+ */
+
+static constexpr uint32_t num_ops{REPEAT_NUM * 100};
+static constexpr uint32_t num_threads{4};
+
+struct triple64 {
+  int64_t x;
+  int64_t y;
+  int64_t z;
+};
+
+using small_t = strict_variant::variant<int32_t, float>;
+using medium_t = strict_variant::variant<int64_t, double>;
+using large_t = strict_variant::variant<int64_t, triple64>;
+
+// The first type of each variant is the integer which is updated
+template <typename V>
+int64_t
+value_of(const V & v) {
+  return v.which() == 0 ? static_cast<int64_t>(*v.template get<0>()) : 0;
+}
+
+template <typename V>
+V
+next(const V & v) {
+  V result;
+  result.template emplace<0>(value_of(v) + 1);
+  return result;
+}
+
+template <typename V>
+struct atomic_of;
+
+template <typename... Ts>
+struct atomic_of<strict_variant::variant<Ts...>> {
+  using type = strict_variant::atomic_variant<Ts...>;
+};
+
+template <typename V>
+struct atomic_shared {
+  typename atomic_of<V>::type value;
+
+  V load() const { return value.load(); }
+
+  void update() {
+    V expected = value.load();
+    while (!value.compare_exchange_weak(expected, next(expected))) {}
+  }
+};
+
+template <typename V>
+struct locked_shared {
+  mutable std::mutex mutex;
+  V value;
+
+  V load() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return value;
+  }
+
+  void update() {
+    std::lock_guard<std::mutex> lock{mutex};
+    value = next(value);
+  }
+};
+
+template <typename Shared>
+void
+report(const char * shared_name, const char * size_name, const char * task_name,
+       uint32_t update_period) {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  Shared shared;
+
+  auto const start = clock_t::now();
+  benchmark::ClobberMemory();
+
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&shared, update_period]() {
+      int64_t total = 0;
+      for (uint32_t i = 0; i < num_ops; ++i) {
+        if (update_period && i % update_period == 0) {
+          shared.update();
+        } else {
+          total += value_of(shared.load());
+        }
+      }
+      benchmark::DoNotOptimize(total);
+    });
+  }
+  for (std::thread & t : threads) {
+    t.join();
+  }
+
+  benchmark::ClobberMemory();
+  auto const end = clock_t::now();
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  std::fprintf(stdout, "%s, %s:\n  task = %s\n  num_threads = %u\n  num_ops = %u\n\n",
+               shared_name, size_name, task_name, num_threads, num_ops);
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "average nanoseconds per operation: %f\n\n\n",
+               (static_cast<double>(us) / (static_cast<double>(num_ops) * num_threads)) * 1000);
+}
+
+template <typename V>
+void
+run(const char * size_name) {
+  report<atomic_shared<V>>("atomic_variant", size_name, "read", 0);
+  report<locked_shared<V>>("std::mutex + variant", size_name, "read", 0);
+  report<atomic_shared<V>>("atomic_variant", size_name, "mixed", 8);
+  report<locked_shared<V>>("std::mutex + variant", size_name, "mixed", 8);
+  report<atomic_shared<V>>("atomic_variant", size_name, "write", 1);
+  report<locked_shared<V>>("std::mutex + variant", size_name, "write", 1);
+}
+
+int
+main() {
+  using medium_atomic_t = atomic_of<medium_t>::type;
+  std::fprintf(stdout, "two words lock-free: %d\n\n\n",
+               static_cast<int>(medium_atomic_t::is_always_lock_free));
+  run<small_t>("one word");
+  run<medium_t>("two words");
+  run<large_t>("four words");
+}
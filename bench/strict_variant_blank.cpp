@@ -0,0 +1,134 @@
+#include "bench_api.hpp"
+#include <strict_variant/variant.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/***
+ * Measures growing a `std::vector` of variants, one of whose types has a
+ * throwing move, one element at a time.
+ *
+ * `easy_variant<std::string, legacy>` wraps `legacy` in a `recursive_wrapper`,
+ * and moving it is a value move, which may throw. So the vector copies every
+ * element when it reallocates. With `blank`, the wrapper is moved by pointer,
+ * the variant is nothrow move constructible, and the vector moves instead.
+ * `variant<blank, std::string, legacy>` holds `legacy` in place, and is not
+ * nothrow move constructible either.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM / 10};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+// A type from code which is not noexcept-correct
+struct legacy {
+  std::string name;
+  int id;
+
+  legacy(std::string n, int i)
+    : name(std::move(n))
+    , id(i) {}
+  legacy(const legacy &) = default;
+  legacy(legacy && other)
+    : name(std::move(other.name))
+    , id(other.id) {}
+  legacy & operator=(const legacy &) = default;
+  legacy & operator=(legacy && other) {
+    name = std::move(other.name);
+    id = other.id;
+    return *this;
+  }
+};
+
+using boxed_t = strict_variant::easy_variant<std::string, legacy>;
+using boxed_blank_t = strict_variant::easy_variant<strict_variant::blank, std::string, legacy>;
+using inline_blank_t = strict_variant::variant<strict_variant::blank, std::string, legacy>;
+
+static_assert(!std::is_nothrow_move_constructible<boxed_t>::value, "Expected a throwing move");
+static_assert(std::is_nothrow_move_constructible<boxed_blank_t>::value,
+              "Expected a nothrow move");
+static_assert(!std::is_nothrow_move_constructible<inline_blank_t>::value,
+              "Expected a throwing move");
+
+// Strings are long enough not to fit in the small string buffer
+template <typename V>
+std::vector<V>
+make_sequence(uint32_t seed) {
+  std::mt19937 rng{seed};
+  std::vector<V> result;
+  result.reserve(seq_length);
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    const uint32_t x = static_cast<uint32_t>(rng());
+    std::string s = "a string of some length, number " + std::to_string(x);
+    if (x % 2) {
+      result.emplace_back(std::move(s));
+    } else {
+      result.emplace_back(legacy{std::move(s), static_cast<int>(x)});
+    }
+  }
+  return result;
+}
+
+template <typename Task>
+void
+report(const char * variant_name, const char * task_name, unsigned size, Task && task) {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  auto const start = clock_t::now();
+  benchmark::ClobberMemory();
+
+  for (uint32_t count{repeat_num}; count; --count) {
+    task();
+  }
+
+  benchmark::ClobberMemory();
+  auto const end = clock_t::now();
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  std::fprintf(stdout, "%s:\n  task = %s\n  seq_length = %u\n  repeat_num = %u\n"
+                       "  sizeof(variant) = %u\n\n",
+               variant_name, task_name, seq_length, repeat_num, size);
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "average nanoseconds per element: %f\n\n\n",
+               (static_cast<double>(us) / (seq_length * repeat_num)) * 1000);
+}
+
+template <typename V>
+void
+run_all(const char * variant_name) {
+  const std::vector<V> seq = make_sequence<V>(rng_seed);
+  const unsigned size = sizeof(V);
+
+  // Copy each element into a reserved vector, the cost without reallocation
+  report(variant_name, "vector fill, reserved", size, [&seq]() {
+    std::vector<V> filled;
+    filled.reserve(seq.size());
+    for (const V & v : seq) {
+      filled.push_back(v);
+    }
+    benchmark::DoNotOptimize(filled.data());
+    benchmark::ClobberMemory();
+  });
+
+  // Grow a vector one element at a time, without reserving
+  report(variant_name, "vector growth", size, [&seq]() {
+    std::vector<V> grown;
+    for (const V & v : seq) {
+      grown.push_back(v);
+    }
+    benchmark::DoNotOptimize(grown.data());
+    benchmark::ClobberMemory();
+  });
+}
+
+int
+main() {
+  run_all<boxed_t>("strict_variant::easy_variant<std::string, legacy>");
+  run_all<boxed_blank_t>("strict_variant::easy_variant<blank, std::string, legacy>");
+  run_all<inline_blank_t>("strict_variant::variant<blank, std::string, legacy>");
+}
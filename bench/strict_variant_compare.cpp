@@ -0,0 +1,159 @@
+#include "bench_api.hpp"
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_compare.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/***
+ * Measures sorting and deduplicating a sequence of variants of six numeric
+ * types, with the comparisons which `variant_compare.hpp` and `variant.hpp`
+ * used to define, which dispatch on both variants, and with the current ones,
+ * which dispatch once after checking that the `which` values are equal.
+ *
+ * Each task starts from a copy of the same random sequence, and the values
+ * are drawn from a small range, so that there are many duplicates.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM / 10};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+using var_t = strict_variant::variant<int32_t, uint32_t, int64_t, uint64_t, float, double>;
+
+// variant_comparator before: visit the first, then `get<T>` the second
+struct legacy_less {
+  struct helper {
+    const var_t & first;
+    const var_t & other;
+
+    template <typename T>
+    bool operator()(const T & t) const {
+      if (const T * o = strict_variant::get<T>(&other)) { return t < *o; }
+      return first.which() < other.which();
+    }
+  };
+
+  bool operator()(const var_t & a, const var_t & b) const {
+    return strict_variant::apply_visitor(helper{a, b}, a);
+  }
+};
+
+// operator== before: check the `which` values, then visit both
+struct legacy_equal {
+  template <typename T>
+  struct second_visitor {
+    const T & l;
+
+    bool operator()(const T & r) const { return l == r; }
+    template <typename U>
+    bool operator()(const U &) const {
+      return false;
+    }
+  };
+
+  struct first_visitor {
+    const var_t & rhs;
+
+    template <typename T>
+    bool operator()(const T & l) const {
+      return strict_variant::apply_visitor(second_visitor<T>{l}, rhs);
+    }
+  };
+
+  bool operator()(const var_t & a, const var_t & b) const {
+    return a.which() == b.which() && strict_variant::apply_visitor(first_visitor{b}, a);
+  }
+};
+
+struct three_way_less {
+  bool operator()(const var_t & a, const var_t & b) const {
+    return strict_variant::three_way_compare(a, b) < 0;
+  }
+};
+
+struct current_equal {
+  bool operator()(const var_t & a, const var_t & b) const { return a == b; }
+};
+
+std::vector<var_t>
+make_sequence() {
+  std::mt19937 rng{rng_seed};
+  std::vector<var_t> result;
+  result.reserve(seq_length);
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    const uint32_t x = static_cast<uint32_t>(rng());
+    const uint32_t v = (x >> 3) % 64;
+    switch (x % 6) {
+      case 0: result.emplace_back(static_cast<int32_t>(v)); break;
+      case 1: result.emplace_back(static_cast<uint32_t>(v)); break;
+      case 2: result.emplace_back(static_cast<int64_t>(v)); break;
+      case 3: result.emplace_back(static_cast<uint64_t>(v)); break;
+      case 4: result.emplace_back(static_cast<float>(v)); break;
+      default: result.emplace_back(static_cast<double>(v)); break;
+    }
+  }
+  return result;
+}
+
+template <typename Task>
+void
+report(const char * comparison_name, const char * task_name, Task && task) {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  auto const start = clock_t::now();
+  benchmark::ClobberMemory();
+
+  for (uint32_t count{repeat_num}; count; --count) {
+    task();
+  }
+
+  benchmark::ClobberMemory();
+  auto const end = clock_t::now();
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  std::fprintf(stdout, "%s:\n  task = %s\n  seq_length = %u\n  repeat_num = %u\n\n",
+               comparison_name, task_name, seq_length, repeat_num);
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "average nanoseconds per element: %f\n\n\n",
+               (static_cast<double>(us) / (seq_length * repeat_num)) * 1000);
+}
+
+template <typename Less>
+void
+run_sort(const char * comparison_name, const std::vector<var_t> & seq) {
+  report(comparison_name, "sort", [&seq]() {
+    std::vector<var_t> v(seq);
+    std::sort(v.begin(), v.end(), Less{});
+    benchmark::DoNotOptimize(v.data());
+  });
+}
+
+template <typename Equal>
+void
+run_unique(const char * comparison_name, const std::vector<var_t> & sorted) {
+  report(comparison_name, "unique", [&sorted]() {
+    std::vector<var_t> v(sorted);
+    auto it = std::unique(v.begin(), v.end(), Equal{});
+    benchmark::DoNotOptimize(it);
+  });
+}
+
+int
+main() {
+  const std::vector<var_t> seq = make_sequence();
+
+  run_sort<legacy_less>("visit and get", seq);
+  run_sort<strict_variant::variant_comparator<var_t>>("variant_comparator", seq);
+  run_sort<three_way_less>("three_way_compare", seq);
+
+  std::vector<var_t> sorted(seq);
+  std::sort(sorted.begin(), sorted.end(), strict_variant::variant_comparator<var_t>{});
+
+  run_unique<legacy_equal>("visit both", sorted);
+  run_unique<current_equal>("operator==", sorted);
+}
@@ -0,0 +1,135 @@
+#include "bench_api.hpp"
+#include <strict_variant/variant.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+/***
+ * Measures the cost of copying and reallocating `std::vector`s of variants,
+ * comparing a set of trivially copyable value types against the same set where
+ * one type has a (trivial in effect, but user-provided) copy ctor. The latter
+ * forces the variant to dispatch on `which` for every element.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+struct point {
+  int x;
+  int y;
+};
+
+struct nontrivial_point {
+  int x;
+  int y;
+
+  nontrivial_point(int _x, int _y) noexcept
+    : x(_x)
+    , y(_y) {}
+  nontrivial_point(const nontrivial_point & o) noexcept
+    : x(o.x)
+    , y(o.y) {}
+  nontrivial_point & operator=(const nontrivial_point & o) noexcept {
+    x = o.x;
+    y = o.y;
+    return *this;
+  }
+};
+
+using trivial_var_t = strict_variant::variant<int, double, point>;
+using nontrivial_var_t = strict_variant::variant<int, double, nontrivial_point>;
+
+static_assert(std::is_trivially_copyable<trivial_var_t>::value, "Expected a trivial variant");
+static_assert(!std::is_trivially_copyable<nontrivial_var_t>::value,
+              "Expected a non-trivial variant");
+
+template <typename P, typename V>
+std::vector<V>
+make_sequence(uint32_t seed) {
+  std::mt19937 rng{seed};
+  std::vector<V> result;
+  result.reserve(seq_length);
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    int x = static_cast<int>(rng());
+    switch (x % 3) {
+      case 0:
+        result.emplace_back(x);
+        break;
+      case 1:
+        result.emplace_back(static_cast<double>(x));
+        break;
+      default:
+        result.emplace_back(P{x, -x});
+        break;
+    }
+  }
+  return result;
+}
+
+template <typename Task>
+void
+report(const char * variant_name, const char * task_name, unsigned size, Task && task) {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  auto const start = clock_t::now();
+  benchmark::ClobberMemory();
+
+  for (uint32_t count{repeat_num}; count; --count) {
+    task();
+  }
+
+  benchmark::ClobberMemory();
+  auto const end = clock_t::now();
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  std::fprintf(stdout, "%s:\n  task = %s\n  seq_length = %u\n  repeat_num = %u\n"
+                       "  sizeof(variant) = %u\n\n",
+               variant_name, task_name, seq_length, repeat_num, size);
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "average nanoseconds per element: %f\n\n\n",
+               (static_cast<double>(us) / (seq_length * repeat_num)) * 1000);
+}
+
+template <typename P, typename V>
+void
+run_all(const char * variant_name) {
+  const std::vector<V> seq = make_sequence<P, V>(rng_seed);
+  const unsigned size = sizeof(V);
+
+  // Copy-construct a whole vector
+  report(variant_name, "vector copy", size, [&seq]() {
+    std::vector<V> copy(seq);
+    benchmark::DoNotOptimize(copy.data());
+    benchmark::ClobberMemory();
+  });
+
+  // Grow a vector one element at a time, without reserving
+  report(variant_name, "vector growth", size, [&seq]() {
+    std::vector<V> grown;
+    for (const V & v : seq) {
+      grown.push_back(v);
+    }
+    benchmark::DoNotOptimize(grown.data());
+    benchmark::ClobberMemory();
+  });
+
+  // Copy-assign over an existing vector
+  std::vector<V> dest(seq.size());
+  report(variant_name, "vector assign", size, [&seq, &dest]() {
+    std::copy(seq.begin(), seq.end(), dest.begin());
+    benchmark::DoNotOptimize(dest.data());
+    benchmark::ClobberMemory();
+  });
+}
+
+int
+main() {
+  run_all<point, trivial_var_t>("strict_variant::variant (trivially copyable)");
+  run_all<nontrivial_point, nontrivial_var_t>("strict_variant::variant (non-trivial copy)");
+}
@@ -0,0 +1,152 @@
+#include "bench_api.hpp"
+#include <strict_variant/iterative_wrapper.hpp>
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/***
+ * Builds, copies and destroys chains (lists) and wide trees of variants, with
+ * `recursive_wrapper` and with `iterative_wrapper`.
+ *
+ * A chain of `long_chain` nodes overflows the stack when it is destroyed
+ * recursively, so `recursive_wrapper` is only measured on the shorter chain.
+ * The tree has fanout 8 and depth 6, about 300000 nodes, so that recursion is
+ * shallow for both.
+ *
+ * The variants have `blank`, so that building a chain moves it by pointer.
+ */
+
+static constexpr uint32_t short_chain{SEQ_LENGTH};
+static constexpr uint32_t long_chain{100 * SEQ_LENGTH};
+static constexpr uint32_t fanout{8};
+static constexpr uint32_t tree_depth{6};
+static constexpr uint32_t repeat_num{REPEAT_NUM / 100};
+
+template <template <typename> class W>
+struct cons;
+
+template <template <typename> class W>
+using list = strict_variant::variant<strict_variant::blank, uint32_t, W<cons<W>>>;
+
+template <template <typename> class W>
+struct cons {
+  uint32_t head;
+  list<W> tail;
+};
+
+template <template <typename> class W>
+struct node;
+
+template <template <typename> class W>
+using tree = strict_variant::variant<strict_variant::blank, uint32_t, W<node<W>>>;
+
+template <template <typename> class W>
+struct node {
+  std::vector<tree<W>> children;
+};
+
+template <template <typename> class W>
+list<W>
+make_list(uint32_t length) {
+  list<W> result{0u};
+  for (uint32_t i = 1; i < length; ++i) {
+    list<W> next{cons<W>{i, std::move(result)}};
+    result = std::move(next);
+  }
+  return result;
+}
+
+template <template <typename> class W>
+tree<W>
+make_tree(uint32_t depth) {
+  node<W> n;
+  n.children.reserve(fanout);
+  for (uint32_t i = 0; i < fanout; ++i) {
+    if (depth) {
+      n.children.emplace_back(make_tree<W>(depth - 1));
+    } else {
+      n.children.emplace_back(i);
+    }
+  }
+  return tree<W>{std::move(n)};
+}
+
+template <typename Task>
+void
+report(const char * variant_name, const char * task_name, uint32_t nodes, Task && task) {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  auto const start = clock_t::now();
+  benchmark::ClobberMemory();
+
+  for (uint32_t count{repeat_num}; count; --count) {
+    task();
+  }
+
+  benchmark::ClobberMemory();
+  auto const end = clock_t::now();
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  std::fprintf(stdout, "%s:\n  task = %s\n  nodes = %u\n  repeat_num = %u\n\n", variant_name,
+               task_name, nodes, repeat_num);
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "average nanoseconds per node: %f\n\n\n",
+               (static_cast<double>(us) / (static_cast<double>(nodes) * repeat_num)) * 1000);
+}
+
+template <template <typename> class W>
+void
+run_chain(const char * variant_name, const char * build_name, const char * copy_name,
+          uint32_t length) {
+  report(variant_name, build_name, length, [length]() {
+    list<W> l = make_list<W>(length);
+    benchmark::DoNotOptimize(&l);
+  });
+
+  const list<W> l = make_list<W>(length);
+  report(variant_name, copy_name, length, [&l]() {
+    list<W> copy{l};
+    benchmark::DoNotOptimize(&copy);
+  });
+}
+
+template <template <typename> class W>
+void
+run_tree(const char * variant_name) {
+  uint32_t nodes = 0;
+  for (uint32_t level = 1, i = 0; i <= tree_depth; ++i) {
+    nodes += level;
+    level *= fanout;
+  }
+
+  report(variant_name, "tree: build and destroy", nodes, []() {
+    tree<W> t = make_tree<W>(tree_depth);
+    benchmark::DoNotOptimize(&t);
+  });
+
+  const tree<W> t = make_tree<W>(tree_depth);
+  report(variant_name, "tree: copy and destroy", nodes, [&t]() {
+    tree<W> copy{t};
+    benchmark::DoNotOptimize(&copy);
+  });
+}
+
+int
+main() {
+  // Trees first, since the long chain leaves the heap fragmented
+  run_tree<strict_variant::recursive_wrapper>("recursive_wrapper");
+  run_tree<strict_variant::iterative_wrapper>("iterative_wrapper");
+  run_chain<strict_variant::recursive_wrapper>("recursive_wrapper",
+                                               "short chain: build and destroy",
+                                               "short chain: copy and destroy", short_chain);
+  run_chain<strict_variant::iterative_wrapper>("iterative_wrapper",
+                                               "short chain: build and destroy",
+                                               "short chain: copy and destroy", short_chain);
+  run_chain<strict_variant::iterative_wrapper>("iterative_wrapper",
+                                               "long chain: build and destroy",
+                                               "long chain: copy and destroy", long_chain);
+}
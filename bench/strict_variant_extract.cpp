@@ -0,0 +1,153 @@
+#include "bench_api.hpp"
+#include <strict_variant/extract.hpp>
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <utility>
+
+/***
+ * A tree rewriting pass, which removes every negation node from an expression
+ * tree, replacing it by its operand. The operand is moved into place either by
+ * moving variants, which re-allocates every node of the subtree, or with
+ * `apply_visitor_extract`, which re-uses the allocations.
+ *
+ * Each repetition builds a tree of SEQ_LENGTH nodes and rewrites it, so the
+ * time to build the tree is reported too.
+ */
+
+static constexpr uint32_t tree_size{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM / 10};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+struct add;
+struct neg;
+
+using expr = strict_variant::variant<uint32_t, strict_variant::recursive_wrapper<add>,
+                                     strict_variant::recursive_wrapper<neg>>;
+
+struct add {
+  expr lhs;
+  expr rhs;
+};
+
+struct neg {
+  expr arg;
+};
+
+void
+fill_tree(expr & e, std::mt19937 & rng, uint32_t size) {
+  if (size <= 1) {
+    e = static_cast<uint32_t>(rng());
+    return;
+  }
+  if (rng() % 3 == 0) {
+    e.emplace<neg>();
+    fill_tree(e.get<neg>()->arg, rng, size - 1);
+  } else {
+    const uint32_t left = 1 + static_cast<uint32_t>(rng() % (size - 1));
+    e.emplace<add>();
+    fill_tree(e.get<add>()->lhs, rng, left);
+    fill_tree(e.get<add>()->rhs, rng, size - left);
+  }
+}
+
+void
+strip_by_move(expr & e) {
+  while (neg * n = e.get<neg>()) {
+    expr operand{std::move(n->arg)};
+    e = std::move(operand);
+  }
+  if (add * a = e.get<add>()) {
+    strip_by_move(a->lhs);
+    strip_by_move(a->rhs);
+  }
+}
+
+// Puts an extracted value into `target`
+struct put {
+  expr & target;
+
+  void operator()(uint32_t && u) const { target = u; }
+
+  template <typename T>
+  void operator()(std::unique_ptr<T> && p) const {
+    target.emplace<T>(std::move(p));
+  }
+};
+
+// Replaces a negation in `target`, which has been extracted from it, by its operand
+struct lift_operand {
+  expr & target;
+
+  void operator()(std::unique_ptr<neg> && n) const {
+    strict_variant::apply_visitor_extract(put{target}, std::move(n->arg));
+  }
+
+  template <typename T>
+  void operator()(T &&) const {}
+};
+
+void
+strip_by_extract(expr & e) {
+  while (e.get<neg>()) {
+    strict_variant::apply_visitor_extract(lift_operand{e}, std::move(e));
+  }
+  if (add * a = e.get<add>()) {
+    strip_by_extract(a->lhs);
+    strip_by_extract(a->rhs);
+  }
+}
+
+template <typename Task>
+void
+report(const char * task_name, Task && task) {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  auto const start = clock_t::now();
+  benchmark::ClobberMemory();
+
+  for (uint32_t count{repeat_num}; count; --count) {
+    task();
+  }
+
+  benchmark::ClobberMemory();
+  auto const end = clock_t::now();
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  std::fprintf(stdout, "strict_variant::variant (%s):\n  tree_size = %u\n  repeat_num = %u\n\n",
+               task_name, tree_size, repeat_num);
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "average nanoseconds per node: %f\n\n\n",
+               (static_cast<double>(us) / (tree_size * repeat_num)) * 1000);
+}
+
+int
+main() {
+  report("build", []() {
+    std::mt19937 rng{rng_seed};
+    expr tree;
+    fill_tree(tree, rng, tree_size);
+    benchmark::DoNotOptimize(tree);
+  });
+
+  report("build and strip, by move", []() {
+    std::mt19937 rng{rng_seed};
+    expr tree;
+    fill_tree(tree, rng, tree_size);
+    strip_by_move(tree);
+    benchmark::DoNotOptimize(tree);
+  });
+
+  report("build and strip, by apply_visitor_extract", []() {
+    std::mt19937 rng{rng_seed};
+    expr tree;
+    fill_tree(tree, rng, tree_size);
+    strip_by_extract(tree);
+    benchmark::DoNotOptimize(tree);
+  });
+}
@@ -0,0 +1,140 @@
+#include "bench_api.hpp"
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_hash.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***
+ * Measures `std::unordered_map` inserts and lookups keyed on a variant of
+ * two integer types, with the hash which `variant_hash.hpp` used to define,
+ * `hash(value) + 31 * which`, with the current one, and with `mixed_hash`.
+ *
+ * The dense keys are every integer below SEQ_LENGTH, once as each type, so
+ * that with the old hash `int32_t{i + 31}` and `int64_t{i}` collide. The
+ * strided keys are multiples of 2^16, like ids whose low bits are zero.
+ *
+ * Also measures hashing a sequence of variants one at a time, and with
+ * `hash_range`.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM / 10};
+
+using key_var = strict_variant::variant<int32_t, int64_t>;
+
+struct legacy_hash {
+  struct hasher {
+    template <typename T>
+    std::size_t operator()(const T & t) const {
+      return std::hash<T>{}(t);
+    }
+  };
+
+  std::size_t operator()(const key_var & k) const {
+    return strict_variant::apply_visitor(hasher{}, k) + (31 * k.which());
+  }
+};
+
+template <typename Task>
+void
+report(const char * hash_name, const char * task_name, Task && task) {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  auto const start = clock_t::now();
+  benchmark::ClobberMemory();
+
+  for (uint32_t count{repeat_num}; count; --count) {
+    task();
+  }
+
+  benchmark::ClobberMemory();
+  auto const end = clock_t::now();
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  std::fprintf(stdout, "%s:\n  task = %s\n  num_keys = %u\n  repeat_num = %u\n\n", hash_name,
+               task_name, 2 * seq_length, repeat_num);
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "average nanoseconds per key: %f\n\n\n",
+               (static_cast<double>(us) / (2 * seq_length * repeat_num)) * 1000);
+}
+
+template <typename Hash>
+void
+run_map(const char * hash_name, const char * keys_name, const std::vector<key_var> & keys) {
+  using map_t = std::unordered_map<key_var, uint32_t, Hash>;
+
+  std::string insert_name = std::string{"insert, "} + keys_name;
+  std::string lookup_name = std::string{"lookup, "} + keys_name;
+
+  report(hash_name, insert_name.c_str(), [&keys]() {
+    map_t m;
+    for (const key_var & k : keys) {
+      m.emplace(k, 1u);
+    }
+    benchmark::DoNotOptimize(m);
+  });
+
+  map_t m;
+  for (const key_var & k : keys) {
+    m.emplace(k, 1u);
+  }
+
+  report(hash_name, lookup_name.c_str(), [&keys, &m]() {
+    uint32_t found = 0;
+    for (const key_var & k : keys) {
+      found += m.find(k)->second;
+    }
+    benchmark::DoNotOptimize(found);
+  });
+
+  std::size_t longest = 0;
+  for (std::size_t b = 0; b < m.bucket_count(); ++b) {
+    if (m.bucket_size(b) > longest) { longest = m.bucket_size(b); }
+  }
+  std::fprintf(stdout, "%s, %s keys: %u buckets, longest chain %u\n\n\n", hash_name, keys_name,
+               static_cast<unsigned>(m.bucket_count()), static_cast<unsigned>(longest));
+}
+
+int
+main() {
+  std::vector<key_var> keys;
+  std::vector<key_var> strided_keys;
+  keys.reserve(2 * seq_length);
+  strided_keys.reserve(2 * seq_length);
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    keys.emplace_back(static_cast<int32_t>(i));
+    keys.emplace_back(static_cast<int64_t>(i));
+    strided_keys.emplace_back(static_cast<int32_t>(i << 16));
+    strided_keys.emplace_back(static_cast<int64_t>(i) << 16);
+  }
+
+  run_map<legacy_hash>("hash(value) + 31 * which", "dense", keys);
+  run_map<std::hash<key_var>>("std::hash<variant>", "dense", keys);
+  run_map<strict_variant::mixed_hash<key_var>>("mixed_hash<variant>", "dense", keys);
+  run_map<legacy_hash>("hash(value) + 31 * which", "strided", strided_keys);
+  run_map<std::hash<key_var>>("std::hash<variant>", "strided", strided_keys);
+  run_map<strict_variant::mixed_hash<key_var>>("mixed_hash<variant>", "strided", strided_keys);
+
+  std::vector<std::size_t> hashes(keys.size());
+
+  report("std::hash<variant>", "hash each", [&keys, &hashes]() {
+    std::hash<key_var> h;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      hashes[i] = h(keys[i]);
+    }
+    benchmark::DoNotOptimize(hashes.data());
+    benchmark::ClobberMemory();
+  });
+
+  report("std::hash<variant>", "hash_range", [&keys, &hashes]() {
+    strict_variant::hash_range(keys.data(), keys.data() + keys.size(), hashes.data());
+    benchmark::DoNotOptimize(hashes.data());
+    benchmark::ClobberMemory();
+  });
+}
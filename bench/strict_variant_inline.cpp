@@ -0,0 +1,177 @@
+#include "bench_api.hpp"
+#include <strict_variant/inline_wrapper.hpp>
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+/***
+ * Measures a stream of messages, whose types are forward declared, so that
+ * each one must be wrapped. Most of them are small, and one rare type is
+ * large.
+ *
+ * With `recursive_wrapper`, every message is allocated on its own. With
+ * `inline_wrapper`, only the large one is, and the others are visited without
+ * an indirection.
+ *
+ * Allocations are counted by replacing the global `operator new`.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM / 10};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+static unsigned long allocations = 0;
+
+void *
+operator new(std::size_t size) {
+  ++allocations;
+  if (void * p = std::malloc(size)) { return p; }
+  throw std::bad_alloc{};
+}
+
+void
+operator delete(void * p) noexcept {
+  std::free(p);
+}
+
+void
+operator delete(void * p, std::size_t) noexcept {
+  std::free(p);
+}
+
+struct ping;
+struct quote;
+struct order;
+struct snapshot;
+
+template <template <typename> class W>
+using message = strict_variant::variant<W<ping>, W<quote>, W<order>, W<snapshot>>;
+
+template <typename T>
+using inline_32 = strict_variant::inline_wrapper<T, 32>;
+
+using boxed_t = message<strict_variant::recursive_wrapper>;
+using inline_t = message<inline_32>;
+
+struct ping {
+  uint32_t seq;
+};
+
+struct quote {
+  uint32_t id;
+  uint32_t price;
+  uint32_t size;
+};
+
+struct order {
+  uint32_t id;
+  uint32_t price;
+  uint32_t size;
+  uint32_t side;
+  uint64_t client;
+};
+
+struct snapshot {
+  uint32_t prices[50];
+};
+
+static_assert(inline_32<order>::holds_inline(), "Expected order to be held in place");
+static_assert(!inline_32<snapshot>::holds_inline(), "Expected snapshot to be on the heap");
+
+struct sum_visitor {
+  uint32_t operator()(const ping & p) const { return p.seq; }
+  uint32_t operator()(const quote & q) const { return q.price * q.size; }
+  uint32_t operator()(const order & o) const { return o.price * o.size + o.side; }
+  uint32_t operator()(const snapshot & s) const { return s.prices[0] + s.prices[49]; }
+};
+
+// One message in 64 is a snapshot
+template <typename V>
+void
+fill_sequence(std::vector<V> & result, uint32_t seed) {
+  std::mt19937 rng{seed};
+  result.clear();
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    const uint32_t x = static_cast<uint32_t>(rng());
+    switch (x % 64) {
+      case 0:
+        result.emplace_back(snapshot{{x}});
+        break;
+      case 1:
+      case 2:
+      case 3:
+        result.emplace_back(order{x, x >> 8, x >> 16, 1, x});
+        break;
+      default:
+        if (x % 2) {
+          result.emplace_back(ping{x});
+        } else {
+          result.emplace_back(quote{x, x >> 8, x >> 16});
+        }
+    }
+  }
+}
+
+template <typename Task>
+void
+report(const char * variant_name, const char * task_name, unsigned size, Task && task) {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  const unsigned long allocations_before = allocations;
+  auto const start = clock_t::now();
+  benchmark::ClobberMemory();
+
+  for (uint32_t count{repeat_num}; count; --count) {
+    task();
+  }
+
+  benchmark::ClobberMemory();
+  auto const end = clock_t::now();
+  const unsigned long allocated = allocations - allocations_before;
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  std::fprintf(stdout, "%s:\n  task = %s\n  seq_length = %u\n  repeat_num = %u\n"
+                       "  sizeof(variant) = %u\n\n",
+               variant_name, task_name, seq_length, repeat_num, size);
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "average nanoseconds per element: %f\n",
+               (static_cast<double>(us) / (seq_length * repeat_num)) * 1000);
+  std::fprintf(stdout, "average allocations per element: %f\n\n\n",
+               static_cast<double>(allocated) / (seq_length * repeat_num));
+}
+
+template <typename V>
+void
+run_all(const char * variant_name) {
+  const unsigned size = sizeof(V);
+  std::vector<V> seq;
+  seq.reserve(seq_length);
+
+  report(variant_name, "build", size, [&seq]() {
+    fill_sequence(seq, rng_seed);
+    benchmark::DoNotOptimize(seq.data());
+    benchmark::ClobberMemory();
+  });
+
+  fill_sequence(seq, rng_seed);
+  report(variant_name, "visit", size, [&seq]() {
+    uint32_t result = 0;
+    for (const V & v : seq) {
+      result += strict_variant::apply_visitor(sum_visitor{}, v);
+    }
+    benchmark::DoNotOptimize(result);
+  });
+}
+
+int
+main() {
+  run_all<boxed_t>("strict_variant::variant<recursive_wrapper<T>...>");
+  run_all<inline_t>("strict_variant::variant<inline_wrapper<T, 32>...>");
+}
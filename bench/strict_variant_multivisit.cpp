@@ -0,0 +1,127 @@
+#include "bench_api.hpp"
+#include <strict_variant/multivisit.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+/***
+ * Measures 2-way and 3-way multivisitation, as in an expression evaluator
+ * combining operands of type `variant<int, double, std::string, bool>`.
+ * Compares `apply_visitor`, which dispatches once on a combined index, with
+ * the nested implementation, which dispatches once per variant.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+using var_t = strict_variant::variant<int, double, std::string, bool>;
+
+// "Size" of the result of a binary / ternary operation
+struct op_visitor {
+  static double value(int i) { return i; }
+  static double value(double d) { return d; }
+  static double value(const std::string & s) { return static_cast<double>(s.size()); }
+  static double value(bool b) { return b ? 1 : 0; }
+
+  template <typename A, typename B>
+  double operator()(const A & a, const B & b) const {
+    return value(a) + value(b);
+  }
+
+  template <typename A, typename B, typename C>
+  double operator()(const A & a, const B & b, const C & c) const {
+    return value(a) * value(b) + value(c);
+  }
+};
+
+std::vector<var_t>
+make_sequence(uint32_t seed) {
+  std::mt19937 rng{seed};
+  std::vector<var_t> result;
+  result.reserve(seq_length + 2);
+  for (uint32_t i = 0; i < seq_length + 2; ++i) {
+    int x = static_cast<int>(rng() % 1000);
+    switch (rng() % 4) {
+      case 0:
+        result.emplace_back(x);
+        break;
+      case 1:
+        result.emplace_back(static_cast<double>(x) / 8);
+        break;
+      case 2:
+        result.emplace_back(std::string(static_cast<std::size_t>(x % 24), 'x'));
+        break;
+      default:
+        result.emplace_back(x % 2 == 0);
+        break;
+    }
+  }
+  return result;
+}
+
+template <typename Task>
+void
+report(const char * variant_name, const char * task_name, Task && task) {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  auto const start = clock_t::now();
+  benchmark::ClobberMemory();
+
+  for (uint32_t count{repeat_num}; count; --count) {
+    task();
+  }
+
+  benchmark::ClobberMemory();
+  auto const end = clock_t::now();
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  std::fprintf(stdout, "%s:\n  task = %s\n  seq_length = %u\n  repeat_num = %u\n\n", variant_name,
+               task_name, seq_length, repeat_num);
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "average nanoseconds per visit: %f\n\n\n",
+               (static_cast<double>(us) / (seq_length * repeat_num)) * 1000);
+}
+
+int
+main() {
+  const std::vector<var_t> seq = make_sequence(rng_seed);
+
+  report("strict_variant::apply_visitor (flat)", "2-way", [&seq]() {
+    double total = 0;
+    for (uint32_t i = 0; i < seq_length; ++i) {
+      total += strict_variant::apply_visitor(op_visitor{}, seq[i], seq[i + 1]);
+    }
+    benchmark::DoNotOptimize(total);
+  });
+
+  report("strict_variant nested multivisit", "2-way", [&seq]() {
+    double total = 0;
+    for (uint32_t i = 0; i < seq_length; ++i) {
+      total += strict_variant::detail::nested_multivisit_impl(op_visitor{}, seq[i], seq[i + 1]);
+    }
+    benchmark::DoNotOptimize(total);
+  });
+
+  report("strict_variant::apply_visitor (flat)", "3-way", [&seq]() {
+    double total = 0;
+    for (uint32_t i = 0; i < seq_length; ++i) {
+      total += strict_variant::apply_visitor(op_visitor{}, seq[i], seq[i + 1], seq[i + 2]);
+    }
+    benchmark::DoNotOptimize(total);
+  });
+
+  report("strict_variant nested multivisit", "3-way", [&seq]() {
+    double total = 0;
+    for (uint32_t i = 0; i < seq_length; ++i) {
+      total += strict_variant::detail::nested_multivisit_impl(op_visitor{}, seq[i], seq[i + 1],
+                                                               seq[i + 2]);
+    }
+    benchmark::DoNotOptimize(total);
+  });
+}
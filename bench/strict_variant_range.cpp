@@ -0,0 +1,96 @@
+#include "bench.hpp"
+#include "bench_api.hpp"
+#include <strict_variant/variant.hpp>
+#include <strict_variant/visit_range.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/***
+ * Compares visiting a `std::vector` of variants one element at a time, against
+ * `apply_visitor_range`, which groups the elements by type first.
+ */
+
+static constexpr uint32_t num_variants{NUM_VARIANTS};
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+using var_t = benchmark::dummy_variant_t<strict_variant::variant, num_variants>;
+
+struct accumulator {
+  uint32_t total = 0;
+
+  template <typename T>
+  void operator()(const T & t) {
+    total += benchmark::visitor{}(t);
+  }
+};
+
+template <typename Task>
+void
+report(const char * task_name, Task && task) {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  auto const start = clock_t::now();
+  benchmark::ClobberMemory();
+
+  for (uint32_t count{repeat_num}; count; --count) {
+    task();
+  }
+
+  benchmark::ClobberMemory();
+  auto const end = clock_t::now();
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  std::fprintf(stdout, "strict_variant::variant (%s):\n  num_variants = %u\n  seq_length = %u\n"
+                       "  repeat_num = %u\n\n",
+               task_name, num_variants, seq_length, repeat_num);
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "average nanoseconds per visit: %f\n\n\n",
+               (static_cast<double>(us) / (seq_length * repeat_num)) * 1000);
+}
+
+int
+main() {
+  std::vector<var_t> seq(seq_length);
+  {
+    std::mt19937 rng{rng_seed};
+    for (var_t & v : seq) {
+      benchmark::set_type<strict_variant::variant, num_variants>(v, static_cast<uint32_t>(rng()));
+    }
+  }
+  std::vector<uint32_t> results(seq_length);
+
+  report("per element", [&seq, &results]() {
+    for (std::size_t i = 0; i < seq.size(); ++i) {
+      results[i] = strict_variant::apply_visitor(benchmark::visitor{}, seq[i]);
+    }
+    benchmark::DoNotOptimize(results.data());
+    benchmark::ClobberMemory();
+  });
+
+  report("apply_visitor_range", [&seq, &results]() {
+    strict_variant::apply_visitor_range(benchmark::visitor{}, seq.cbegin(), seq.cend(),
+                                        results.begin());
+    benchmark::DoNotOptimize(results.data());
+    benchmark::ClobberMemory();
+  });
+
+  report("per element, accumulate", [&seq]() {
+    accumulator acc;
+    for (const var_t & v : seq) {
+      strict_variant::apply_visitor(acc, v);
+    }
+    benchmark::DoNotOptimize(acc.total);
+  });
+
+  report("apply_visitor_range, accumulate", [&seq]() {
+    accumulator acc;
+    strict_variant::apply_visitor_range(acc, seq.cbegin(), seq.cend());
+    benchmark::DoNotOptimize(acc.total);
+  });
+}
@@ -0,0 +1,149 @@
+#include "bench_api.hpp"
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/shared_variant.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***
+ * Measures reader threads visiting a shared configuration tree, an
+ * `easy_variant` of 13 nodes, while one writer publishes a new version every
+ * millisecond. The tree is held by a `shared_variant`, behind a
+ * `std::shared_timed_mutex`, or in a `std::shared_ptr` read with
+ * `std::atomic_load`.
+ *
+ * The readers perform REPEAT_NUM * 10000 reads in total, divided among 1 to 64
+ * threads, so that perfect scaling shows as a constant time per read.
+ */
+
+static constexpr uint32_t total_reads{REPEAT_NUM * 10000};
+
+struct section;
+using config_t = strict_variant::easy_variant<int, std::string,
+                                              strict_variant::recursive_wrapper<section>>;
+
+struct section {
+  std::vector<config_t> entries;
+};
+
+config_t
+make_config(int version, int depth) {
+  if (!depth) { return config_t{version}; }
+  section s;
+  s.entries.emplace_back(std::string{"name"});
+  for (int i = 0; i < 3; ++i) {
+    s.entries.push_back(make_config(version + i, depth - 1));
+  }
+  return config_t{std::move(s)};
+}
+
+struct sum_ints {
+  int operator()(int i) const { return i; }
+  int operator()(const std::string &) const { return 0; }
+  int operator()(const section & s) const {
+    int result = 0;
+    for (const config_t & e : s.entries) {
+      result += strict_variant::apply_visitor(*this, e);
+    }
+    return result;
+  }
+};
+
+struct rcu_shared {
+  strict_variant::shared_variant<config_t> cell{make_config(0, 2)};
+
+  int read() const { return strict_variant::apply_visitor(sum_ints{}, cell); }
+  void write(int version) { cell.store(make_config(version, 2)); }
+};
+
+struct rwlock_shared {
+  mutable std::shared_timed_mutex mutex;
+  config_t value{make_config(0, 2)};
+
+  int read() const {
+    std::shared_lock<std::shared_timed_mutex> lock{mutex};
+    return strict_variant::apply_visitor(sum_ints{}, value);
+  }
+
+  void write(int version) {
+    config_t c{make_config(version, 2)};
+    std::unique_lock<std::shared_timed_mutex> lock{mutex};
+    value = std::move(c);
+  }
+};
+
+struct shared_ptr_shared {
+  std::shared_ptr<const config_t> ptr{std::make_shared<const config_t>(make_config(0, 2))};
+
+  int read() const {
+    const std::shared_ptr<const config_t> p = std::atomic_load(&ptr);
+    return strict_variant::apply_visitor(sum_ints{}, *p);
+  }
+
+  void write(int version) {
+    std::atomic_store(&ptr, std::make_shared<const config_t>(make_config(version, 2)));
+  }
+};
+
+template <typename Shared>
+void
+report(const char * shared_name, uint32_t num_threads) {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  Shared shared;
+  std::atomic<bool> done{false};
+
+  std::thread writer([&shared, &done]() {
+    for (int version = 1; !done.load(); ++version) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      shared.write(version);
+    }
+  });
+
+  auto const start = clock_t::now();
+  benchmark::ClobberMemory();
+
+  std::vector<std::thread> readers;
+  for (uint32_t t = 0; t < num_threads; ++t) {
+    readers.emplace_back([&shared, num_threads]() {
+      int64_t total = 0;
+      for (uint32_t i = total_reads / num_threads; i; --i) {
+        total += shared.read();
+      }
+      benchmark::DoNotOptimize(total);
+    });
+  }
+  for (std::thread & t : readers) {
+    t.join();
+  }
+
+  benchmark::ClobberMemory();
+  auto const end = clock_t::now();
+
+  done = true;
+  writer.join();
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  std::fprintf(stdout, "%s:\n  num_threads = %u\n  total_reads = %u\n\n", shared_name, num_threads,
+               total_reads);
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "average nanoseconds per read: %f\n\n\n",
+               (static_cast<double>(us) / total_reads) * 1000);
+}
+
+int
+main() {
+  for (uint32_t n : {1u, 2u, 4u, 8u, 16u, 32u, 64u}) {
+    report<rcu_shared>("shared_variant", n);
+    report<rwlock_shared>("std::shared_timed_mutex", n);
+    report<shared_ptr_shared>("std::atomic_load(std::shared_ptr)", n);
+  }
+}
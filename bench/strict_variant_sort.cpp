@@ -0,0 +1,122 @@
+#include "bench_api.hpp"
+#include <strict_variant/sort_variants.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_compare.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/***
+ * Measures sorting, deduplicating and searching a sequence of variants of
+ * four numeric types, with `std::sort`, `std::unique` and `std::lower_bound`
+ * and `variant_comparator` or `operator==`, and with `sort_variants`,
+ * `unique_variants` and `lower_bound_variants`.
+ *
+ * The sequence has 100 * SEQ_LENGTH elements, with values drawn from a range
+ * of about a million per type.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH * 100};
+static constexpr uint32_t repeat_num{REPEAT_NUM / 100};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+using var_t = strict_variant::variant<int32_t, uint32_t, int64_t, double>;
+using less_t = strict_variant::variant_comparator<var_t>;
+
+std::vector<var_t>
+make_sequence(uint32_t n, uint32_t seed) {
+  std::mt19937 rng{seed};
+  std::vector<var_t> result;
+  result.reserve(n);
+  for (uint32_t i = 0; i < n; ++i) {
+    const uint32_t x = static_cast<uint32_t>(rng());
+    const int32_t v = static_cast<int32_t>(x >> 2) % (1 << 20) - (1 << 19);
+    switch (x % 4) {
+      case 0: result.emplace_back(v); break;
+      case 1: result.emplace_back(static_cast<uint32_t>(v) >> 1); break;
+      case 2: result.emplace_back(static_cast<int64_t>(v) * 4096); break;
+      default: result.emplace_back(static_cast<double>(v) / 3); break;
+    }
+  }
+  return result;
+}
+
+template <typename Task>
+void
+report(const char * algorithm_name, const char * task_name, Task && task) {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  auto const start = clock_t::now();
+  benchmark::ClobberMemory();
+
+  for (uint32_t count{repeat_num}; count; --count) {
+    task();
+  }
+
+  benchmark::ClobberMemory();
+  auto const end = clock_t::now();
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  std::fprintf(stdout, "%s:\n  task = %s\n  seq_length = %u\n  repeat_num = %u\n\n",
+               algorithm_name, task_name, seq_length, repeat_num);
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "average nanoseconds per element: %f\n\n\n",
+               (static_cast<double>(us) / (static_cast<double>(seq_length) * repeat_num)) * 1000);
+}
+
+int
+main() {
+  const std::vector<var_t> seq = make_sequence(seq_length, rng_seed);
+
+  report("std::sort", "sort", [&seq]() {
+    std::vector<var_t> v(seq);
+    std::sort(v.begin(), v.end(), less_t{});
+    benchmark::DoNotOptimize(v.data());
+  });
+
+  report("sort_variants", "sort", [&seq]() {
+    std::vector<var_t> v(seq);
+    strict_variant::sort_variants(v.begin(), v.end());
+    benchmark::DoNotOptimize(v.data());
+  });
+
+  std::vector<var_t> sorted(seq);
+  strict_variant::sort_variants(sorted.begin(), sorted.end());
+
+  report("std::unique", "unique", [&sorted]() {
+    std::vector<var_t> v(sorted);
+    auto it = std::unique(v.begin(), v.end());
+    benchmark::DoNotOptimize(it);
+  });
+
+  report("unique_variants", "unique", [&sorted]() {
+    std::vector<var_t> v(sorted);
+    auto it = strict_variant::unique_variants(v.begin(), v.end());
+    benchmark::DoNotOptimize(it);
+  });
+
+  // One search per element of another sequence
+  const std::vector<var_t> probes = make_sequence(seq_length, rng_seed + 1);
+
+  report("std::lower_bound", "lower_bound", [&sorted, &probes]() {
+    std::size_t total = 0;
+    for (const var_t & p : probes) {
+      total += static_cast<std::size_t>(
+        std::lower_bound(sorted.begin(), sorted.end(), p, less_t{}) - sorted.begin());
+    }
+    benchmark::DoNotOptimize(total);
+  });
+
+  report("lower_bound_variants", "lower_bound", [&sorted, &probes]() {
+    std::size_t total = 0;
+    for (const var_t & p : probes) {
+      total += static_cast<std::size_t>(
+        strict_variant::lower_bound_variants(sorted.begin(), sorted.end(), p) - sorted.begin());
+    }
+    benchmark::DoNotOptimize(total);
+  });
+}
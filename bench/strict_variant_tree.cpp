@@ -0,0 +1,279 @@
+#include "bench_api.hpp"
+#include <strict_variant/arena_wrapper.hpp>
+#include <strict_variant/monotonic_allocator.hpp>
+#include <strict_variant/pool_allocator.hpp>
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <type_traits>
+
+/***
+ * Builds, walks and copies an expression tree whose nodes are variants of
+ * `recursive_wrapper`s. Define POOL_WRAPPER, MONOTONIC_WRAPPER or
+ * ARENA_WRAPPER to use `pool_wrapper`, `monotonic_wrapper` or `arena_wrapper`
+ * instead, and COMPACT_LAYOUT to use `compact_layout` for them.
+ *
+ * With MONOTONIC_WRAPPER, each tree is built in its own `monotonic_buffer`,
+ * which is released after the tree is destroyed. (The copy task is skipped,
+ * since copies go to the buffer of the original.)
+ *
+ * With ARENA_WRAPPER, each tree is built in its own `node_arena`s, and copying
+ * it copies the arenas.
+ *
+ * The tree has 100 * SEQ_LENGTH nodes, so that it does not fit in cache, and
+ * each task is repeated REPEAT_NUM / 100 times.
+ */
+
+static constexpr uint32_t tree_size{100 * SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM / 100};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+#if defined(POOL_WRAPPER)
+
+template <typename T>
+using wrapper_t = strict_variant::pool_wrapper<T>;
+
+#define WRAPPER_NAME "pool_wrapper"
+
+#elif defined(MONOTONIC_WRAPPER)
+
+template <typename T>
+using wrapper_t = strict_variant::monotonic_wrapper<T>;
+
+#define WRAPPER_NAME "monotonic_wrapper"
+
+#elif defined(ARENA_WRAPPER)
+
+template <typename T>
+using wrapper_t = strict_variant::arena_wrapper<T>;
+
+#define WRAPPER_NAME "arena_wrapper"
+
+#else
+
+template <typename T>
+using wrapper_t = strict_variant::recursive_wrapper<T>;
+
+#define WRAPPER_NAME "recursive_wrapper"
+
+#endif
+
+namespace ast {
+
+struct leaf;
+struct add;
+struct mul;
+struct neg;
+
+using expr = strict_variant::variant<wrapper_t<leaf>, wrapper_t<add>, wrapper_t<mul>, wrapper_t<neg>>;
+
+} // end namespace ast
+
+#ifdef COMPACT_LAYOUT
+
+namespace strict_variant {
+
+template <>
+struct compact_layout<ast::expr> : std::true_type {};
+
+} // end namespace strict_variant
+
+#define VARIANT_NAME "strict_variant::variant (" WRAPPER_NAME ", compact_layout)"
+
+#else
+
+#define VARIANT_NAME "strict_variant::variant (" WRAPPER_NAME ")"
+
+#endif
+
+namespace ast {
+
+struct leaf {
+  uint32_t value;
+};
+
+struct add {
+  expr lhs;
+  expr rhs;
+};
+
+struct mul {
+  expr lhs;
+  expr rhs;
+};
+
+struct neg {
+  expr arg;
+};
+
+struct evaluator {
+  uint32_t operator()(const leaf & l) const { return l.value; }
+  uint32_t operator()(const add & a) const {
+    return strict_variant::apply_visitor(*this, a.lhs) + strict_variant::apply_visitor(*this, a.rhs);
+  }
+  uint32_t operator()(const mul & m) const {
+    return strict_variant::apply_visitor(*this, m.lhs) * strict_variant::apply_visitor(*this, m.rhs);
+  }
+  uint32_t operator()(const neg & n) const { return -strict_variant::apply_visitor(*this, n.arg); }
+};
+
+#ifdef ARENA_WRAPPER
+
+// The arenas of one tree, bound to this thread while it lives
+struct tree_arena {
+  strict_variant::node_arena<leaf> leaves;
+  strict_variant::node_arena<add> adds;
+  strict_variant::node_arena<mul> muls;
+  strict_variant::node_arena<neg> negs;
+
+  strict_variant::node_arena<leaf>::scope leaves_scope{leaves};
+  strict_variant::node_arena<add>::scope adds_scope{adds};
+  strict_variant::node_arena<mul>::scope muls_scope{muls};
+  strict_variant::node_arena<neg>::scope negs_scope{negs};
+};
+
+// Returns the same random tree as `fill_tree`. (The children are built before
+// the parent, since adding a node may move the others in its arena.)
+expr
+make_tree(std::mt19937 & rng, uint32_t size) {
+  if (size <= 1) { return expr{leaf{static_cast<uint32_t>(rng())}}; }
+  switch (rng() % 5) {
+    case 0: return expr{neg{make_tree(rng, size - 1)}};
+    case 1:
+    case 2: {
+      const uint32_t left = 1 + static_cast<uint32_t>(rng() % (size - 1));
+      expr lhs = make_tree(rng, left);
+      expr rhs = make_tree(rng, size - left);
+      return expr{add{lhs, rhs}};
+    }
+    default: {
+      const uint32_t left = 1 + static_cast<uint32_t>(rng() % (size - 1));
+      expr lhs = make_tree(rng, left);
+      expr rhs = make_tree(rng, size - left);
+      return expr{mul{lhs, rhs}};
+    }
+  }
+}
+
+#else
+
+// Fills `e` with a random tree of `size` nodes. (The nodes are built in
+// place, since moving a variant moves the value out of its wrapper.)
+void
+fill_tree(expr & e, std::mt19937 & rng, uint32_t size) {
+  if (size <= 1) {
+    e.emplace<leaf>(leaf{static_cast<uint32_t>(rng())});
+    return;
+  }
+  switch (rng() % 5) {
+    case 0:
+      e.emplace<neg>();
+      fill_tree(e.get<neg>()->arg, rng, size - 1);
+      break;
+    case 1:
+    case 2: {
+      const uint32_t left = 1 + static_cast<uint32_t>(rng() % (size - 1));
+      e.emplace<add>();
+      fill_tree(e.get<add>()->lhs, rng, left);
+      fill_tree(e.get<add>()->rhs, rng, size - left);
+      break;
+    }
+    default: {
+      const uint32_t left = 1 + static_cast<uint32_t>(rng() % (size - 1));
+      e.emplace<mul>();
+      fill_tree(e.get<mul>()->lhs, rng, left);
+      fill_tree(e.get<mul>()->rhs, rng, size - left);
+      break;
+    }
+  }
+}
+
+#endif
+
+} // end namespace ast
+
+template <typename Task>
+void
+report(const char * task_name, Task && task) {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  auto const start = clock_t::now();
+  benchmark::ClobberMemory();
+
+  for (uint32_t count{repeat_num}; count; --count) {
+    task();
+  }
+
+  benchmark::ClobberMemory();
+  auto const end = clock_t::now();
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  std::fprintf(stdout, "%s:\n  task = %s\n  tree_size = %u\n  repeat_num = %u\n"
+                       "  sizeof(expr) = %u\n  sizeof(add) = %u\n\n",
+               VARIANT_NAME, task_name, tree_size, repeat_num,
+               static_cast<unsigned>(sizeof(ast::expr)), static_cast<unsigned>(sizeof(ast::add)));
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "average nanoseconds per node: %f\n\n\n",
+               (static_cast<double>(us) / (tree_size * repeat_num)) * 1000);
+}
+
+int
+main() {
+  using expr = ast::expr;
+
+  report("build and destroy", []() {
+#ifdef MONOTONIC_WRAPPER
+    strict_variant::monotonic_buffer buffer;
+    strict_variant::monotonic_buffer::scope scope{buffer};
+#endif
+    std::mt19937 rng{rng_seed};
+#ifdef ARENA_WRAPPER
+    ast::tree_arena arena;
+    expr tree = ast::make_tree(rng, tree_size);
+#else
+    expr tree;
+    ast::fill_tree(tree, rng, tree_size);
+#endif
+    benchmark::DoNotOptimize(tree);
+  });
+
+#ifdef MONOTONIC_WRAPPER
+  strict_variant::monotonic_buffer buffer;
+  strict_variant::monotonic_buffer::scope scope{buffer};
+#endif
+  std::mt19937 rng{rng_seed};
+#ifdef ARENA_WRAPPER
+  ast::tree_arena arena;
+  expr tree = ast::make_tree(rng, tree_size);
+#else
+  expr tree;
+  ast::fill_tree(tree, rng, tree_size);
+#endif
+
+  report("walk", [&tree]() {
+    uint32_t result = strict_variant::apply_visitor(ast::evaluator{}, tree);
+    benchmark::DoNotOptimize(result);
+  });
+
+#if defined(ARENA_WRAPPER)
+  report("copy and destroy", [&arena]() {
+    strict_variant::node_arena<ast::leaf> leaves{arena.leaves};
+    strict_variant::node_arena<ast::add> adds{arena.adds};
+    strict_variant::node_arena<ast::mul> muls{arena.muls};
+    strict_variant::node_arena<ast::neg> negs{arena.negs};
+    benchmark::DoNotOptimize(leaves);
+    benchmark::DoNotOptimize(adds);
+    benchmark::DoNotOptimize(muls);
+    benchmark::DoNotOptimize(negs);
+  });
+#elif !defined(MONOTONIC_WRAPPER)
+  report("copy and destroy", [&tree]() {
+    expr copy{tree};
+    benchmark::DoNotOptimize(copy);
+  });
+#endif
+}
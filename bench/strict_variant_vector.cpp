@@ -0,0 +1,123 @@
+#include "bench_api.hpp"
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_vector.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/***
+ * Compares `std::vector<variant<...>>` against `variant_vector<...>` for a
+ * telemetry-like sequence, where most values are small and a few are large:
+ * memory used, visiting every element in order, and visiting every element
+ * with `for_each_by_type`.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+struct event {
+  uint64_t timestamp;
+  uint32_t code;
+  uint32_t flags;
+  double values[5];
+};
+
+using var_t = strict_variant::variant<int, float, event>;
+using vec_t = strict_variant::variant_vector<int, float, event>;
+
+struct sum_visitor {
+  double operator()(int i) const noexcept { return i; }
+  double operator()(float f) const noexcept { return f; }
+  double operator()(const event & e) const noexcept { return e.values[0] + e.code; }
+};
+
+struct accumulator {
+  double total = 0;
+
+  template <typename T>
+  void operator()(const T & t) noexcept {
+    total += sum_visitor{}(t);
+  }
+};
+
+// 45% int, 45% float, 10% event
+template <typename C>
+C
+make_sequence(uint32_t seed) {
+  std::mt19937 rng{seed};
+  C result;
+  result.reserve(seq_length);
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    int x = static_cast<int>(rng() % 1000);
+    uint32_t r = rng() % 20;
+    if (r < 9) {
+      result.push_back(x);
+    } else if (r < 18) {
+      result.push_back(static_cast<float>(x));
+    } else {
+      result.push_back(event{i, static_cast<uint32_t>(x), 0u, {1.0, 2.0, 3.0, 4.0, 5.0}});
+    }
+  }
+  return result;
+}
+
+template <typename Task>
+void
+report(const char * name, unsigned long bytes, Task && task) {
+  using clock_t = std::chrono::high_resolution_clock;
+
+  auto const start = clock_t::now();
+  benchmark::ClobberMemory();
+
+  for (uint32_t count{repeat_num}; count; --count) {
+    task();
+  }
+
+  benchmark::ClobberMemory();
+  auto const end = clock_t::now();
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  std::fprintf(stdout, "%s:\n  seq_length = %u\n  repeat_num = %u\n  bytes = %lu\n\n", name,
+               seq_length, repeat_num, bytes);
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "average nanoseconds per element: %f\n\n\n",
+               (static_cast<double>(us) / (seq_length * repeat_num)) * 1000);
+}
+
+int
+main() {
+  const auto aos = make_sequence<std::vector<var_t>>(rng_seed);
+  const auto soa = make_sequence<vec_t>(rng_seed);
+
+  const unsigned long aos_bytes = aos.size() * sizeof(var_t);
+  const unsigned long soa_bytes = soa.size() * (sizeof(uint8_t) + sizeof(uint32_t))
+                                  + soa.pool<int>().size() * sizeof(int)
+                                  + soa.pool<float>().size() * sizeof(float)
+                                  + soa.pool<event>().size() * sizeof(event);
+
+  report("std::vector<variant> (apply_visitor)", aos_bytes, [&aos]() {
+    double total = 0;
+    for (const var_t & v : aos) {
+      total += strict_variant::apply_visitor(sum_visitor{}, v);
+    }
+    benchmark::DoNotOptimize(total);
+  });
+
+  report("variant_vector (apply_visitor on references)", soa_bytes, [&soa]() {
+    double total = 0;
+    for (std::size_t i = 0; i < soa.size(); ++i) {
+      total += strict_variant::apply_visitor(sum_visitor{}, soa[i]);
+    }
+    benchmark::DoNotOptimize(total);
+  });
+
+  report("variant_vector (for_each_by_type)", soa_bytes, [&soa]() {
+    accumulator acc;
+    soa.for_each_by_type(acc);
+    benchmark::DoNotOptimize(acc.total);
+  });
+}
@@ -8,6 +8,9 @@
 /***
  * For use with strict_variant::variant
  */
+#include <cstddef>
+#include <memory>
+#include <strict_variant/mpl/std_traits.hpp>
 #include <strict_variant/wrapper.hpp>
 #include <type_traits>
 #include <utility>
@@ -30,18 +33,99 @@
 
 #endif // STRICT_VARIANT_DEBUG
 
-//[ strict_variant_alloc_wrapper
 namespace strict_variant {
 
+/***
+ * Trait giving the alignment of the memory which `Alloc::allocate` returns,
+ * whatever the value type. Specialize it for a custom allocator so that
+ * `alloc_wrapper` can advertise `spare_bits`.
+ */
+template <typename Alloc>
+struct allocation_alignment : std::integral_constant<std::size_t, 1> {};
+
+template <typename U>
+struct allocation_alignment<std::allocator<U>>
+  : std::integral_constant<std::size_t, alignof(std::max_align_t)> {};
+
+namespace detail {
+
+/***
+ * The pointer of an `alloc_wrapper`, together with its allocator. The pointer
+ * comes first, so that its spare bits are in the first word, and an empty
+ * allocator takes no space.
+ */
+template <typename Pointer, typename Alloc, bool = std::is_empty<Alloc>::value>
+struct alloc_pointer_pair : private Alloc {
+  Pointer m_ptr;
+
+  explicit alloc_pointer_pair(const Alloc & a) noexcept
+    : Alloc(a)
+    , m_ptr(nullptr) {}
+
+  Alloc & alloc() noexcept { return *this; }
+  const Alloc & alloc() const noexcept { return *this; }
+};
+
+template <typename Pointer, typename Alloc>
+struct alloc_pointer_pair<Pointer, Alloc, false> {
+  Pointer m_ptr;
+  Alloc m_alloc;
+
+  explicit alloc_pointer_pair(const Alloc & a) noexcept
+    : m_ptr(nullptr)
+    , m_alloc(a) {}
+
+  Alloc & alloc() noexcept { return m_alloc; }
+  const Alloc & alloc() const noexcept { return m_alloc; }
+};
+
+// Deleter which destroys an object and frees it with an allocator
+template <typename Alloc>
+struct alloc_deleter {
+  using traits = std::allocator_traits<Alloc>;
+  using T = typename traits::value_type;
+
+  Alloc m_alloc;
+
+  void operator()(T * p) const noexcept {
+    Alloc a(m_alloc);
+    p->~T();
+    traits::deallocate(a, p, 1);
+  }
+};
+
+// Whether the first of a pack of ctor arguments is std::allocator_arg
+template <typename... Args>
+struct leading_allocator_arg : std::false_type {};
+
+template <typename First, typename... Args>
+struct leading_allocator_arg<First, Args...>
+  : std::is_same<mpl::remove_const_t<mpl::remove_reference_t<First>>, std::allocator_arg_t> {};
+
+} // end namespace detail
+
+//[ strict_variant_alloc_wrapper
+/***
+ * Like `recursive_wrapper<T>`, but uses the allocator `Alloc`.
+ *
+ * The wrapper keeps a copy of the allocator which made its value, so that
+ * stateful allocators work. A wrapper constructed from a value uses a default
+ * constructed allocator, unless the allocator is given first, after
+ * `std::allocator_arg`. A copy uses the allocator of the source, and so the
+ * copy of a tree comes from the same place as the original.
+ */
 template <typename T, typename Alloc>
 class alloc_wrapper {
-  T * m_t;
+  using traits = std::allocator_traits<Alloc>;
+
+  // The low bits of the pointer are left for a variant with compact_layout.
+  using pointer_t = detail::tagged_pointer<T, allocation_alignment<Alloc>::value>;
+  detail::alloc_pointer_pair<pointer_t, Alloc> m_t;
 
   void destroy() {
-    if (m_t) {
-      Alloc a;
-      m_t->~T();
-      a.deallocate(m_t, 1);
+    if (T * t = m_t.m_ptr.get()) {
+      t->~T();
+      traits::deallocate(m_t.alloc(), t, 1);
     }
   }
 
@@ -50,19 +134,19 @@ class alloc_wrapper {
   // if initialization was unsuccessful.
 
   struct initer {
-    Alloc a;
+    Alloc & a;
     bool success;
     T * m_t;
 
-    initer()
-      : a()
+    explicit initer(Alloc & alloc)
+      : a(alloc)
       , success(false)
       , m_t(nullptr) {
-      m_t = a.allocate(1);
+      m_t = traits::allocate(a, 1);
     }
 
     ~initer() {
-      if (!success) { a.deallocate(m_t, 1); }
+      if (!success) { traits::deallocate(a, m_t, 1); }
     }
 
     template <typename... Args>
@@ -74,19 +158,31 @@ class alloc_wrapper {
 
   template <typename... Args>
   void init(Args &&... args) {
-    initer i;
+    initer i{m_t.alloc()};
     i.go(std::forward<Args>(args)...);
-    m_t = i.m_t;
+    STRICT_VARIANT_ASSERT(m_t.m_ptr.is_aligned(i.m_t),
+                          "Allocation is less aligned than allocation_alignment claims!");
+    m_t.m_ptr.set(i.m_t);
   }
 
 public:
   typedef T value_type;
+  typedef Alloc allocator_type;
+  typedef std::unique_ptr<T, detail::alloc_deleter<Alloc>> unique_ptr_type;
 
   ~alloc_wrapper() noexcept { this->destroy(); }
 
-  template <typename... Args>
+  template <typename... Args,
+            typename = mpl::enable_if_t<!detail::leading_allocator_arg<Args...>::value>>
   alloc_wrapper(Args &&... args)
-    : m_t(nullptr) {
+    : m_t(Alloc()) {
+    this->init(std::forward<Args>(args)...);
+  }
+
+  // Allocator-extended ctor
+  template <typename... Args>
+  alloc_wrapper(std::allocator_arg_t, const Alloc & a, Args &&... args)
+    : m_t(a) {
     this->init(std::forward<Args>(args)...);
   }
 
@@ -94,15 +190,26 @@ public:
     : alloc_wrapper(static_cast<const alloc_wrapper &>(rhs)) {}
 
   alloc_wrapper(const alloc_wrapper & rhs)
-    : m_t(nullptr) {
+    : m_t(traits::select_on_container_copy_construction(rhs.m_t.alloc())) {
     this->init(rhs.get());
   }
 
   // Pointer move
   alloc_wrapper(alloc_wrapper && rhs) noexcept //
-    : m_t(rhs.m_t)                             //
+    : m_t(rhs.m_t.alloc())                     //
+  {
+    m_t.m_ptr.set(rhs.m_t.m_ptr.get());
+    rhs.m_t.m_ptr.set(nullptr);
+  }
+
+  // Adopts an object made with the allocator in the deleter
+  explicit alloc_wrapper(unique_ptr_type && p) noexcept //
+    : m_t(p.get_deleter().m_alloc)                      //
   {
-    rhs.m_t = nullptr;
+    STRICT_VARIANT_ASSERT(p.get(), "Adopted a null pointer!");
+    STRICT_VARIANT_ASSERT(m_t.m_ptr.is_aligned(p.get()),
+                          "Allocation is less aligned than allocation_alignment claims!");
+    m_t.m_ptr.set(p.release());
   }
 
   // Not assignable, we never actually need this, and it adds complexity
@@ -110,17 +217,27 @@ public:
   alloc_wrapper & operator=(const alloc_wrapper &) = delete;
   alloc_wrapper & operator=(alloc_wrapper &&) = delete;
 
+  allocator_type get_allocator() const noexcept { return m_t.alloc(); }
+
+  // Gives up ownership of the object, leaving the wrapper empty. An empty
+  // wrapper may only be destroyed.
+  unique_ptr_type release() noexcept {
+    T * t = m_t.m_ptr.get();
+    m_t.m_ptr.set(nullptr);
+    return unique_ptr_type{t, detail::alloc_deleter<Alloc>{m_t.alloc()}};
+  }
+
   T & get() & {
-    STRICT_VARIANT_ASSERT(m_t, "Bad access!");
-    return *m_t;
+    STRICT_VARIANT_ASSERT(m_t.m_ptr.get(), "Bad access!");
+    return *m_t.m_ptr.get();
   }
   const T & get() const & {
-    STRICT_VARIANT_ASSERT(m_t, "Bad access!");
-    return *m_t;
+    STRICT_VARIANT_ASSERT(m_t.m_ptr.get(), "Bad access!");
+    return *m_t.m_ptr.get();
   }
   T && get() && {
-    STRICT_VARIANT_ASSERT(m_t, "Bad access!");
-    return std::move(*m_t);
+    STRICT_VARIANT_ASSERT(m_t.m_ptr.get(), "Bad access!");
+    return std::move(*m_t.m_ptr.get());
   }
 };
 //]
@@ -132,6 +249,10 @@ struct is_wrapper<alloc_wrapper<T, A>> : std::true_type {};
 
 } // end namespace detail
 
+template <typename T, typename A>
+struct spare_bits<alloc_wrapper<T, A>>
+  : std::integral_constant<unsigned int, detail::alignment_bits(allocation_alignment<A>::value)> {};
+
 } // end namespace strict_variant
 
 #undef STRICT_VARIANT_ASSERT
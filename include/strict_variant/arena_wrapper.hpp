@@ -0,0 +1,180 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * A wrapper which holds a 32-bit index into a `node_arena`, rather than a
+ * pointer to a node of its own.
+ *
+ * All the nodes of one type in a tree are in one `std::vector` owned by the
+ * arena, in the order they were made. So the tree is contiguous, a wrapper is
+ * half the size of a pointer, and a tree whose nodes are trivially copyable
+ * can be copied, moved or written out with `memcpy`, since an index means the
+ * same thing in any copy of the arena.
+ *
+ * The wrapper doesn't know its arena. It is pierced through the arena bound
+ * to the calling thread with `node_arena<T>::scope`.
+ */
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <strict_variant/variant_fwd.hpp>
+#include <strict_variant/wrapper.hpp>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef STRICT_VARIANT_DEBUG
+#include <cassert>
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+    assert((X) && C);                                                                              \
+  } while (0)
+
+#else // STRICT_VARIANT_DEBUG
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+  } while (0)
+
+#endif // STRICT_VARIANT_DEBUG
+
+namespace strict_variant {
+
+//[ strict_variant_node_arena
+template <typename T>
+class node_arena {
+public:
+  typedef std::uint32_t index_type;
+
+  node_arena() = default;
+  node_arena(const node_arena &) = default;
+  node_arena(node_arena &&) = default;
+  node_arena & operator=(const node_arena &) = default;
+  node_arena & operator=(node_arena &&) = default;
+
+  // Makes a node, and returns its index. The value is made before it is
+  // added, so the arguments may refer to other nodes.
+  template <typename... Args>
+  index_type emplace(Args &&... args) {
+    if (m_nodes.size() >= std::numeric_limits<index_type>::max()) {
+      throw std::length_error{"node_arena is full"};
+    }
+    T t(std::forward<Args>(args)...);
+    m_nodes.push_back(std::move(t));
+    return static_cast<index_type>(m_nodes.size() - 1);
+  }
+
+  // Like any reference into a `std::vector`, this is invalidated when a node
+  // is added, unless there is capacity for it.
+  T & operator[](index_type i) noexcept {
+    STRICT_VARIANT_ASSERT(i < m_nodes.size(), "Bad node index!");
+    return m_nodes[i];
+  }
+
+  const T & operator[](index_type i) const noexcept {
+    STRICT_VARIANT_ASSERT(i < m_nodes.size(), "Bad node index!");
+    return m_nodes[i];
+  }
+
+  std::size_t size() const noexcept { return m_nodes.size(); }
+  void reserve(std::size_t n) { m_nodes.reserve(n); }
+
+  // Destroys every node at once
+  void clear() noexcept { m_nodes.clear(); }
+
+  T * data() noexcept { return m_nodes.data(); }
+  const T * data() const noexcept { return m_nodes.data(); }
+
+  /***
+   * The arena which `arena_wrapper<T>`s on this thread make and find their
+   * nodes in. It is set for the lifetime of a `scope` object.
+   */
+  static node_arena * current() noexcept { return current_ref(); }
+
+  class scope {
+    node_arena * m_prev;
+
+  public:
+    explicit scope(node_arena & arena) noexcept
+      : m_prev(current_ref()) {
+      current_ref() = &arena;
+    }
+
+    scope(const scope &) = delete;
+    scope & operator=(const scope &) = delete;
+
+    ~scope() noexcept { current_ref() = m_prev; }
+  };
+
+private:
+  std::vector<T> m_nodes;
+
+  static node_arena *& current_ref() noexcept {
+    static thread_local node_arena * a = nullptr;
+    return a;
+  }
+};
+//]
+
+//[ strict_variant_arena_wrapper
+/***
+ * Copies of an `arena_wrapper` refer to the same node. Destroying one does
+ * nothing, the node lives as long as its arena. Visiting an rvalue variant
+ * which holds one passes the node by const reference, rather than moving it.
+ */
+template <typename T>
+class arena_wrapper {
+  using arena_t = node_arena<T>;
+  typename arena_t::index_type m_index;
+
+  static arena_t & arena() noexcept {
+    STRICT_VARIANT_ASSERT(arena_t::current(), "No node_arena is bound to this thread!");
+    return *arena_t::current();
+  }
+
+public:
+  typedef T value_type;
+  typedef typename arena_t::index_type index_type;
+
+  // Makes a node in the current arena
+  template <typename... Args>
+  arena_wrapper(Args &&... args)
+    : m_index(arena().emplace(std::forward<Args>(args)...)) {}
+
+  // Trivial, so that a node made of these and of trivial types is too
+  arena_wrapper(arena_wrapper &) = default;
+  arena_wrapper(const arena_wrapper &) = default;
+  arena_wrapper(arena_wrapper &&) = default;
+  arena_wrapper & operator=(const arena_wrapper &) = default;
+  arena_wrapper & operator=(arena_wrapper &&) = default;
+  ~arena_wrapper() = default;
+
+  index_type index() const noexcept { return m_index; }
+
+  T & get() & { return arena()[m_index]; }
+  const T & get() const & { return arena()[m_index]; }
+  // Copies share the node, so it isn't moved from
+  const T & get() && { return arena()[m_index]; }
+};
+//]
+
+namespace detail {
+
+template <typename T>
+struct is_wrapper<arena_wrapper<T>> : std::true_type {};
+
+// Copies share a node, so assigning a new value makes a new node
+template <typename T>
+struct is_shared_wrapper<arena_wrapper<T>> : std::true_type {};
+
+} // end namespace detail
+
+} // end namespace strict_variant
+
+#undef STRICT_VARIANT_ASSERT
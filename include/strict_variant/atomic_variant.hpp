@@ -0,0 +1,430 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * An atomic variable holding a variant whose types are all trivially
+ * copyable, such as a small status value shared between threads.
+ *
+ * The variant is kept as a sequence of 64-bit words. If it fits in one word,
+ * these are `std::atomic` operations on that word. If it fits in two, and the
+ * target has a double-width compare-and-swap (`cmpxchg16b` on x86-64, which
+ * gcc and clang use with `-mcx16`), they are compare-and-swap loops on both
+ * words at once. Either way they are lock-free. Otherwise the words are
+ * guarded by a seqlock, so loads do not write to shared memory, but stores
+ * wait for one another.
+ */
+
+#include <strict_variant/mpl/find_with.hpp>
+#include <strict_variant/mpl/std_traits.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+#ifdef STRICT_VARIANT_DEBUG
+#include <cassert>
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+    assert((X) && C);                                                                              \
+  } while (0)
+
+#else // STRICT_VARIANT_DEBUG
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+  } while (0)
+
+#endif // STRICT_VARIANT_DEBUG
+
+namespace strict_variant {
+namespace detail {
+
+// A type which may be copied by copying its bytes
+template <typename T>
+struct is_atomic_storable
+  : std::integral_constant<bool, mpl::is_trivially_copy_constructible<T>::value
+                                   && mpl::is_trivially_copy_assignable<T>::value
+                                   && mpl::is_trivially_destructible<T>::value> {};
+
+/***
+ * The bytes of a variant as 64-bit words, in a canonical form: the bytes of
+ * the value and of the `which` value are kept, and all the others, that is
+ * the rest of the storage and the padding, are zero. So two variants have the
+ * same words exactly when they hold the same type, and values with the same
+ * bytes, and the words can be compared by a compare-and-swap.
+ *
+ * The layout is that of `variant_data`, whose storage is `detail::storage`.
+ */
+template <typename... Ts>
+struct atomic_variant_layout {
+  using var_t = variant<Ts...>;
+
+  static constexpr std::size_t num_types = sizeof...(Ts);
+
+  using storage_t = storage<Ts...>;
+  using which_t = which_type_t<num_types>;
+  using data_t = variant_data<storage_t, which_t, false, which_bits<num_types>::value>;
+
+  static_assert(mpl::All_Have<is_atomic_storable, Ts...>::value,
+                "atomic_variant requires that every type is trivially copyable!");
+  static_assert(!compact_layout<var_t>::value,
+                "atomic_variant does not support variants with compact_layout!");
+  static_assert(std::is_standard_layout<data_t>::value && sizeof(var_t) == sizeof(data_t),
+                "atomic_variant expects a variant to be laid out as its variant_data!");
+
+  static constexpr std::size_t size = sizeof(var_t);
+  static constexpr std::size_t num_words = (size + sizeof(std::uint64_t) - 1)
+                                           / sizeof(std::uint64_t);
+  static constexpr std::size_t which_offset = offsetof(data_t, m_which);
+
+  struct bits {
+    std::uint64_t words[num_words];
+
+    bool operator==(const bits & o) const noexcept {
+      for (std::size_t i = 0; i < num_words; ++i) {
+        if (words[i] != o.words[i]) { return false; }
+      }
+      return true;
+    }
+  };
+
+  // For each type, the bytes of a value of that type and of the which value
+  struct mask_table {
+    bits masks[num_types];
+
+    mask_table() noexcept {
+      const std::size_t sizes[num_types] = {sizeof(Ts)...};
+      for (std::size_t i = 0; i < num_types; ++i) {
+        unsigned char bytes[sizeof(bits)] = {};
+        std::memset(bytes, 0xff, sizes[i]);
+        std::memset(bytes + which_offset, 0xff, sizeof(which_t));
+        std::memcpy(&masks[i], bytes, sizeof(bits));
+      }
+    }
+  };
+
+  static const bits & mask(int which) noexcept {
+    static const mask_table table;
+    return table.masks[which];
+  }
+
+  static bits encode(const var_t & v) noexcept {
+    STRICT_VARIANT_ASSERT(var_t::storage_impl(v).address() == static_cast<const void *>(&v),
+                          "variant storage is not at the start of the variant!");
+    bits result{};
+    std::memcpy(&result, static_cast<const void *>(&v), size);
+    const bits & m = mask(v.which());
+    for (std::size_t i = 0; i < num_words; ++i) {
+      result.words[i] &= m.words[i];
+    }
+    return result;
+  }
+
+  static var_t decode(const bits & b) noexcept {
+    typename std::aligned_storage<sizeof(var_t), alignof(var_t)>::type buffer;
+    std::memcpy(&buffer, &b, size);
+    return *reinterpret_cast<const var_t *>(&buffer);
+  }
+};
+
+/***
+ * Atomic operations on the words of a variant. The memory order arguments
+ * are used only for a single word, with more words the operations always
+ * synchronize as a lock would: a load is an acquire, a store is a release, and a read-modify-write
+ * is both.
+ */
+template <typename Bits, std::size_t num_words = sizeof(Bits) / sizeof(std::uint64_t)>
+class words_atomic;
+
+// One word, with std::atomic
+template <typename Bits>
+class words_atomic<Bits, 1> {
+  std::atomic<unsigned long long> m_word;
+
+  static unsigned long long to_word(const Bits & b) noexcept { return b.words[0]; }
+  static Bits from_word(unsigned long long w) noexcept {
+    Bits b;
+    b.words[0] = w;
+    return b;
+  }
+
+public:
+  static constexpr bool is_always_lock_free = ATOMIC_LLONG_LOCK_FREE == 2;
+
+  explicit words_atomic(const Bits & b) noexcept
+    : m_word(to_word(b)) {}
+
+  bool is_lock_free() const noexcept { return m_word.is_lock_free(); }
+
+  Bits load(std::memory_order order) const noexcept { return from_word(m_word.load(order)); }
+
+  void store(const Bits & b, std::memory_order order) noexcept { m_word.store(to_word(b), order); }
+
+  Bits exchange(const Bits & b, std::memory_order order) noexcept {
+    return from_word(m_word.exchange(to_word(b), order));
+  }
+
+  bool compare_exchange(Bits & expected, const Bits & desired, bool weak,
+                        std::memory_order order) noexcept {
+    unsigned long long e = to_word(expected);
+    const bool result = weak ? m_word.compare_exchange_weak(e, to_word(desired), order)
+                             : m_word.compare_exchange_strong(e, to_word(desired), order);
+    expected = from_word(e);
+    return result;
+  }
+};
+
+#ifdef __GCC_HAVE_SYNC_COMPARE_AND_SWAP_16
+
+// Two words, with a double-width compare-and-swap. The `__sync` builtins are
+// used because gcc expands them inline, where the `__atomic` ones call into
+// libatomic.
+template <typename Bits>
+class words_atomic<Bits, 2> {
+  __extension__ typedef unsigned __int128 dword_t;
+
+  alignas(16) mutable dword_t m_dword;
+
+  static dword_t to_dword(const Bits & b) noexcept {
+    dword_t d;
+    std::memcpy(&d, &b, sizeof(d));
+    return d;
+  }
+
+  static Bits from_dword(dword_t d) noexcept {
+    Bits b;
+    std::memcpy(&b, &d, sizeof(d));
+    return b;
+  }
+
+  // Swaps in `desired` if the value is `expected`, and returns the old value
+  dword_t cas(dword_t expected, dword_t desired) const noexcept {
+    return __sync_val_compare_and_swap(&m_dword, expected, desired);
+  }
+
+public:
+  static constexpr bool is_always_lock_free = true;
+
+  explicit words_atomic(const Bits & b) noexcept
+    : m_dword(to_dword(b)) {}
+
+  bool is_lock_free() const noexcept { return true; }
+
+  // A load is a compare-and-swap which, if it succeeds, writes the same value
+  Bits load(std::memory_order) const noexcept { return from_dword(this->cas(0, 0)); }
+
+  void store(const Bits & b, std::memory_order order) noexcept { this->exchange(b, order); }
+
+  Bits exchange(const Bits & b, std::memory_order) noexcept {
+    const dword_t desired = to_dword(b);
+    // A first guess, the compare-and-swap returns the actual value
+    dword_t current = 0;
+    for (;;) {
+      const dword_t old = this->cas(current, desired);
+      if (old == current) { return from_dword(old); }
+      current = old;
+    }
+  }
+
+  bool compare_exchange(Bits & expected, const Bits & desired, bool,
+                        std::memory_order) noexcept {
+    const dword_t e = to_dword(expected);
+    const dword_t old = this->cas(e, to_dword(desired));
+    expected = from_dword(old);
+    return old == e;
+  }
+};
+
+#endif // __GCC_HAVE_SYNC_COMPARE_AND_SWAP_16
+
+// Spins for a while, then yields, in case the thread which holds the seqlock
+// is not running
+class seqlock_backoff {
+  unsigned int m_spins{0};
+
+public:
+  void operator()() noexcept {
+    if (++m_spins > 64) { std::this_thread::yield(); }
+  }
+};
+
+/***
+ * Any number of words, with a seqlock: a writer makes the sequence number
+ * odd, writes the words, and makes it even again. A reader copies the words,
+ * and retries if the sequence number was odd or changed meanwhile.
+ *
+ * The words are themselves relaxed atomics, so that a reader racing with a
+ * writer is not a data race, only a torn copy which it throws away.
+ */
+template <typename Bits, std::size_t num_words>
+class words_atomic {
+  std::atomic<std::uint64_t> m_seq;
+  std::atomic<std::uint64_t> m_words[num_words];
+
+  Bits read() const noexcept {
+    Bits b;
+    for (std::size_t i = 0; i < num_words; ++i) {
+      b.words[i] = m_words[i].load(std::memory_order_relaxed);
+    }
+    return b;
+  }
+
+  void write(const Bits & b) noexcept {
+    for (std::size_t i = 0; i < num_words; ++i) {
+      m_words[i].store(b.words[i], std::memory_order_relaxed);
+    }
+  }
+
+  std::uint64_t lock() noexcept {
+    seqlock_backoff backoff;
+    for (;;) {
+      std::uint64_t seq = m_seq.load(std::memory_order_relaxed);
+      if (!(seq & 1)
+          && m_seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire,
+                                         std::memory_order_relaxed)) {
+        // Orders the odd sequence number before the writes of the words
+        std::atomic_thread_fence(std::memory_order_release);
+        return seq;
+      }
+      backoff();
+    }
+  }
+
+  void unlock(std::uint64_t seq) noexcept { m_seq.store(seq + 2, std::memory_order_release); }
+
+public:
+  static constexpr bool is_always_lock_free = false;
+
+  explicit words_atomic(const Bits & b) noexcept
+    : m_seq(0) {
+    this->write(b);
+  }
+
+  bool is_lock_free() const noexcept { return false; }
+
+  Bits load(std::memory_order) const noexcept {
+    seqlock_backoff backoff;
+    for (;;) {
+      const std::uint64_t seq = m_seq.load(std::memory_order_acquire);
+      if (!(seq & 1)) {
+        const Bits b = this->read();
+        // Orders the reads of the words before the second read of the sequence number
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_seq.load(std::memory_order_relaxed) == seq) { return b; }
+      }
+      backoff();
+    }
+  }
+
+  void store(const Bits & b, std::memory_order) noexcept {
+    const std::uint64_t seq = this->lock();
+    this->write(b);
+    this->unlock(seq);
+  }
+
+  Bits exchange(const Bits & b, std::memory_order) noexcept {
+    const std::uint64_t seq = this->lock();
+    const Bits old = this->read();
+    this->write(b);
+    this->unlock(seq);
+    return old;
+  }
+
+  bool compare_exchange(Bits & expected, const Bits & desired, bool,
+                        std::memory_order) noexcept {
+    const std::uint64_t seq = this->lock();
+    const Bits old = this->read();
+    const bool result = (old == expected);
+    if (result) { this->write(desired); }
+    this->unlock(seq);
+    expected = old;
+    return result;
+  }
+};
+
+} // end namespace detail
+
+//[ strict_variant_atomic_variant
+/***
+ * An atomic `variant<Ts...>`, for types which are all trivially copyable.
+ *
+ * `compare_exchange_*` compare the bytes of the values, as `std::atomic`
+ * does, so e.g. `0.0` and `-0.0` differ, and a NaN may equal itself. A variant
+ * with `compact_layout` is not supported.
+ */
+template <typename... Ts>
+class atomic_variant {
+  using layout = detail::atomic_variant_layout<Ts...>;
+  using bits = typename layout::bits;
+  using impl_t = detail::words_atomic<bits>;
+
+  impl_t m_impl;
+
+public:
+  using value_type = variant<Ts...>;
+
+  // True if the operations are lock-free, false if there is a seqlock
+  static constexpr bool is_always_lock_free = impl_t::is_always_lock_free;
+
+  atomic_variant() noexcept
+    : atomic_variant(value_type{}) {}
+
+  explicit atomic_variant(const value_type & v) noexcept
+    : m_impl(layout::encode(v)) {}
+
+  atomic_variant(const atomic_variant &) = delete;
+  atomic_variant & operator=(const atomic_variant &) = delete;
+
+  bool is_lock_free() const noexcept { return m_impl.is_lock_free(); }
+
+  value_type load(std::memory_order order = std::memory_order_seq_cst) const noexcept {
+    return layout::decode(m_impl.load(order));
+  }
+
+  void store(const value_type & v, std::memory_order order = std::memory_order_seq_cst) noexcept {
+    m_impl.store(layout::encode(v), order);
+  }
+
+  value_type exchange(const value_type & v,
+                      std::memory_order order = std::memory_order_seq_cst) noexcept {
+    return layout::decode(m_impl.exchange(layout::encode(v), order));
+  }
+
+  // On failure, `expected` is set to the current value
+  bool compare_exchange_strong(value_type & expected, const value_type & desired,
+                               std::memory_order order = std::memory_order_seq_cst) noexcept {
+    return this->compare_exchange(expected, desired, false, order);
+  }
+
+  // May fail spuriously, like `std::atomic::compare_exchange_weak`
+  bool compare_exchange_weak(value_type & expected, const value_type & desired,
+                             std::memory_order order = std::memory_order_seq_cst) noexcept {
+    return this->compare_exchange(expected, desired, true, order);
+  }
+
+private:
+  bool compare_exchange(value_type & expected, const value_type & desired, bool weak,
+                        std::memory_order order) noexcept {
+    bits e = layout::encode(expected);
+    const bool result = m_impl.compare_exchange(e, layout::encode(desired), weak, order);
+    if (!result) { expected = layout::decode(e); }
+    return result;
+  }
+};
+//]
+
+template <typename... Ts>
+constexpr bool atomic_variant<Ts...>::is_always_lock_free;
+
+} // end namespace strict_variant
+
+#undef STRICT_VARIANT_ASSERT
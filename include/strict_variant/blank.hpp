@@ -0,0 +1,78 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * A designated empty state for variant, like `boost::blank`.
+ */
+
+#include <cstddef>
+#include <functional>
+
+namespace strict_variant {
+
+//[ strict_variant_blank
+/***
+ * An empty type. When it is one of the types of a variant, the variant uses
+ * it as a fallback value:
+ *
+ * - A change of type whose constructor may throw is done in place, after
+ *   destroying the old value. If the constructor throws, the variant is left
+ *   holding `blank`. So the variant is assignable even if some of its types
+ *   have throwing moves and are not wrapped.
+ * - Wrapped values are moved by pointer, and a moved-from variant is left
+ *   holding `blank` (see `pointer_move`). So for instance
+ *   `easy_variant<blank, std::string, T>` is nothrow move constructible, even
+ *   if `T` is wrapped.
+ *
+ * All blanks are equal.
+ */
+struct blank {};
+
+constexpr bool
+operator==(const blank &, const blank &) noexcept {
+  return true;
+}
+
+constexpr bool
+operator!=(const blank &, const blank &) noexcept {
+  return false;
+}
+
+constexpr bool
+operator<(const blank &, const blank &) noexcept {
+  return false;
+}
+
+constexpr bool
+operator>(const blank &, const blank &) noexcept {
+  return false;
+}
+
+constexpr bool
+operator<=(const blank &, const blank &) noexcept {
+  return true;
+}
+
+constexpr bool
+operator>=(const blank &, const blank &) noexcept {
+  return true;
+}
+//]
+
+} // end namespace strict_variant
+
+namespace std {
+
+template <>
+struct hash<strict_variant::blank> {
+  using argument_type = strict_variant::blank;
+  using result_type = std::size_t;
+
+  std::size_t operator()(const argument_type &) const noexcept { return 0; }
+};
+
+} // namespace std
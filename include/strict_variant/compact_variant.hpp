@@ -0,0 +1,188 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Versions of `easy_variant` which also box large types, so that one rare,
+ * large type doesn't make every instance of the variant large, and a report
+ * of the layout of a variant type.
+ *
+ * Boxing a type by size requires it to be complete. A recursive type must
+ * still be wrapped explicitly, and a type which is already wrapped is left
+ * alone.
+ */
+
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/wrapper.hpp>
+
+#include <cstddef>
+#include <ostream>
+#include <type_traits>
+
+namespace strict_variant {
+namespace detail {
+
+/***
+ * Metafunctions over lists of sizes
+ */
+template <std::size_t... Sizes>
+struct size_max;
+
+template <std::size_t S>
+struct size_max<S> {
+  static constexpr std::size_t value = S;
+};
+
+template <std::size_t S, std::size_t T, std::size_t... Sizes>
+struct size_max<S, T, Sizes...> : size_max<(S < T ? T : S), Sizes...> {};
+
+template <std::size_t... Sizes>
+struct size_min;
+
+template <std::size_t S>
+struct size_min<S> {
+  static constexpr std::size_t value = S;
+};
+
+template <std::size_t S, std::size_t T, std::size_t... Sizes>
+struct size_min<S, T, Sizes...> : size_min<(T < S ? T : S), Sizes...> {};
+
+// How many of `Sizes` are less than `S`, and how many are at most `S`
+template <std::size_t S, std::size_t... Sizes>
+struct size_rank;
+
+template <std::size_t S>
+struct size_rank<S> {
+  static constexpr std::size_t below = 0;
+  static constexpr std::size_t not_above = 0;
+};
+
+template <std::size_t S, std::size_t T, std::size_t... Sizes>
+struct size_rank<S, T, Sizes...> {
+  static constexpr std::size_t below = (T < S ? 1 : 0) + size_rank<S, Sizes...>::below;
+  static constexpr std::size_t not_above = (T <= S ? 1 : 0) + size_rank<S, Sizes...>::not_above;
+};
+
+// The median of `Sizes`, the lower one if there is an even number of them
+template <std::size_t... Sizes>
+struct size_median {
+  static constexpr std::size_t k = (sizeof...(Sizes) - 1) / 2;
+
+  template <std::size_t S>
+  struct is_median {
+    static constexpr bool value =
+      size_rank<S, Sizes...>::below <= k && k < size_rank<S, Sizes...>::not_above;
+  };
+
+  static constexpr std::size_t value = size_max<(is_median<Sizes>::value ? Sizes : 0)...>::value;
+};
+
+/***
+ * Metafunction `box_if_larger`: Wraps `T` if it has a throwing move, like
+ * `wrap_if_throwing_move`, or if it is larger than `Limit` bytes and than its
+ * wrapper.
+ */
+template <typename T, std::size_t Limit, template <typename> class Wrapper,
+          bool = is_wrapper<T>::value>
+struct box_if_larger {
+  static_assert(std::is_nothrow_destructible<T>::value && !std::is_reference<T>::value,
+                "Types in a variant must be nothrow destructible and not references!");
+
+  static constexpr bool large = sizeof(T) > Limit && sizeof(T) > sizeof(Wrapper<T>);
+
+  using type = typename std::conditional<large || !std::is_nothrow_move_constructible<T>::value,
+                                         Wrapper<T>, T>::type;
+};
+
+template <typename T, std::size_t Limit, template <typename> class Wrapper>
+struct box_if_larger<T, Limit, Wrapper, true> {
+  using type = T;
+};
+
+} // end namespace detail
+
+//[ strict_variant_compact_variant
+/***
+ * Version of `easy_variant` which also wraps every type larger than `Budget`
+ * bytes, in `Wrapper` (`recursive_wrapper` by default).
+ *
+ * A type is only wrapped for its size if it is also larger than the wrapper.
+ */
+template <std::size_t Budget, template <typename> class Wrapper = recursive_wrapper>
+struct bounded_variant {
+  template <typename T>
+  using wrap_t = typename detail::box_if_larger<T, Budget, Wrapper>::type;
+
+  template <typename... Ts>
+  using type = variant<wrap_t<Ts>...>;
+};
+
+/***
+ * Version of `easy_variant` which also wraps every type larger than `Multiple`
+ * times the median size of the types.
+ */
+template <std::size_t Multiple, template <typename> class Wrapper = recursive_wrapper>
+struct median_bounded_variant {
+  template <typename... Ts>
+  using type = typename bounded_variant<Multiple * detail::size_median<sizeof(Ts)...>::value,
+                                        Wrapper>::template type<Ts...>;
+};
+
+/***
+ * Wraps types with throwing moves, and types larger than four times the median
+ * size, in `recursive_wrapper`.
+ */
+template <typename... Ts>
+using compact_variant = median_bounded_variant<4>::type<Ts...>;
+//]
+
+//[ strict_variant_layout_report
+/***
+ * Compile-time report of the layout of a variant type: the size of each of
+ * its types, as held in the variant, and the bytes wasted in an instance which
+ * holds it.
+ */
+template <typename Variant>
+struct layout_report;
+
+template <typename... Ts>
+struct layout_report<variant<Ts...>> {
+  static constexpr std::size_t num_types = sizeof...(Ts);
+
+  // sizeof the variant
+  static constexpr std::size_t size = sizeof(variant<Ts...>);
+
+  // sizeof each type, a wrapped type is the size of its wrapper
+  static constexpr std::size_t sizes[] = {sizeof(Ts)...};
+
+  // Whether each type is wrapped
+  static constexpr bool wrapped[] = {detail::is_wrapper<Ts>::value...};
+
+  static constexpr std::size_t wasted(std::size_t index) { return size - sizes[index]; }
+
+  static constexpr std::size_t min_wasted = size - detail::size_max<sizeof(Ts)...>::value;
+  static constexpr std::size_t max_wasted = size - detail::size_min<sizeof(Ts)...>::value;
+
+  // Prints one line for the variant, and one for each type
+  static void print(std::ostream & os) {
+    os << "variant of " << num_types << " types: " << size << " bytes, " << min_wasted << " to "
+       << max_wasted << " wasted\n";
+    for (std::size_t i = 0; i < num_types; ++i) {
+      os << "  " << i << ": " << sizes[i] << " bytes" << (wrapped[i] ? " (wrapped)" : "") << ", "
+         << wasted(i) << " wasted\n";
+    }
+  }
+};
+
+template <typename... Ts>
+constexpr std::size_t layout_report<variant<Ts...>>::sizes[];
+
+template <typename... Ts>
+constexpr bool layout_report<variant<Ts...>>::wrapped[];
+//]
+
+} // end namespace strict_variant
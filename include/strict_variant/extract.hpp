@@ -0,0 +1,127 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Destructive visitation: take ownership of a wrapped value, instead of
+ * moving it.
+ *
+ * Moving a value out of a `recursive_wrapper` in a variant is a value move,
+ * which allocates a new object, and for a tree, moves every node below it too.
+ * `apply_visitor_extract` instead hands the visitor the allocation itself, as
+ * a `std::unique_ptr`, and leaves the variant holding a cheap default value.
+ * Such a pointer can be put back into a variant, without allocating, with
+ * `emplace<T>(std::move(ptr))`.
+ */
+
+#include <strict_variant/mpl/std_traits.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/wrapper.hpp>
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace strict_variant {
+namespace detail {
+
+// The fallback value of a variant type, see `extract_fallback`
+template <typename Variant>
+struct extract_fallback_of;
+
+template <typename... Types>
+struct extract_fallback_of<variant<Types...>> : extract_fallback<Types...> {};
+
+// Whether a type is a wrapper which can release its value, as a
+// `unique_ptr_type`. (`shared_wrapper`, `interned` and `arena_wrapper` can't.)
+template <typename T, typename = void>
+struct is_releasable_wrapper : std::false_type {};
+
+template <typename T>
+struct is_releasable_wrapper<T, decltype(static_cast<void>(
+                                  std::declval<typename T::unique_ptr_type>()))>
+  : is_wrapper<T> {};
+
+// Visits the storage of a variant without piercing wrappers.
+template <typename Variant, typename Visitor>
+struct extractor {
+  using fallback = extract_fallback_of<Variant>;
+
+  Variant & m_var;
+  Visitor & m_visitor;
+
+  // A value held in place, or in a wrapper which can't release it, is passed as
+  // by an rvalue visit, and left in the variant
+  template <typename T>
+  auto call(T & t, std::false_type)
+    -> decltype(std::declval<Visitor>()(detail::pierce_expiring_wrapper(t))) {
+    return static_cast<Visitor &&>(m_visitor)(detail::pierce_expiring_wrapper(t));
+  }
+
+  // A wrapped value is released, and the variant falls back before the visitor
+  // is called, so the visitor may do what it likes with the variant.
+  template <typename W>
+  auto call(W & w, std::true_type)
+    -> decltype(std::declval<Visitor>()(std::declval<typename W::unique_ptr_type>())) {
+    static_assert(fallback::found,
+                  "To extract a wrapped value, the variant must have a type which is not wrapped "
+                  "and is nothrow default constructible, to be left holding.");
+    typename W::unique_ptr_type p = w.release();
+    m_var.template emplace<fallback::value>();
+    return static_cast<Visitor &&>(m_visitor)(std::move(p));
+  }
+
+  template <typename T>
+  auto operator()(T & t)
+    -> decltype(this->call(t, typename is_releasable_wrapper<mpl::remove_const_t<T>>::type{})) {
+    return this->call(t, typename is_releasable_wrapper<mpl::remove_const_t<T>>::type{});
+  }
+};
+
+// Dispatches on the storage, with the variant's dispatch strategy, without
+// piercing wrappers
+template <typename Variant>
+struct extract_dispatcher;
+
+template <typename... Types>
+struct extract_dispatcher<variant<Types...>> {
+  using type = visitor_dispatch<true_, sizeof...(Types),
+                                typename dispatch_strategy<variant<Types...>>::type>;
+};
+
+template <typename Variant>
+using extract_dispatcher_t = typename extract_dispatcher<Variant>::type;
+
+} // end namespace detail
+
+//[ strict_variant_apply_visitor_extract
+/***
+ * Apply a visitor to the value of a variant, consuming it.
+ *
+ * If the value is held in a wrapper, such as `recursive_wrapper<T>`, the
+ * visitor gets the allocation itself, as an rvalue of the wrapper's
+ * `unique_ptr_type` (`std::unique_ptr<T>` for `recursive_wrapper`), and the
+ * variant is left holding `blank`, if it is one of the types, and otherwise a
+ * default constructed value of its first type which is not wrapped and is
+ * nothrow default constructible. Nothing is allocated or moved.
+ *
+ * Otherwise, including for a wrapper which can't release its value, like
+ * `shared_wrapper`, the visitor gets the value as an rvalue visit would pass
+ * it, and the variant is left holding the moved-from value.
+ */
+template <typename Visitor, typename... Types>
+auto
+apply_visitor_extract(Visitor && visitor, variant<Types...> && var)
+  -> decltype(detail::extract_dispatcher_t<variant<Types...>>{}(
+    0u, variant<Types...>::storage_impl(var),
+    std::declval<detail::extractor<variant<Types...>, Visitor> &>())) {
+  detail::extractor<variant<Types...>, Visitor> e{var, visitor};
+  return detail::extract_dispatcher_t<variant<Types...>>{}(
+    static_cast<unsigned int>(var.which()), variant<Types...>::storage_impl(var), e);
+}
+//]
+
+} // end namespace strict_variant
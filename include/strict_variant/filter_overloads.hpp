@@ -69,4 +69,15 @@ struct filter_overloads<T, mpl::TypeList<Ts...>> {
   using type = safe_and_undominated;
 };
 
+// unique_overload is true if filter_overloads leaves exactly one of the types
+// for an argument of type T, and then gives its index. Used for lookups with
+// values which are not variants, see `variant_transparent_hash`.
+template <typename T, typename TL, typename UL = typename filter_overloads<T, TL>::type>
+struct unique_overload : std::false_type {};
+
+template <typename T, typename TL, unsigned u>
+struct unique_overload<T, TL, mpl::ulist<u>> : std::true_type {
+  static constexpr unsigned index = u;
+};
+
 } // end namespace strict_variant
@@ -0,0 +1,192 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * A wrapper with a small buffer: a value which fits in the buffer, and is
+ * nothrow move constructible, is held in place, and any other value on the
+ * heap, like `recursive_wrapper`.
+ *
+ * Like `recursive_wrapper`, it may be named with an incomplete type. Where the
+ * value is held is decided where it is constructed, accessed or destroyed,
+ * where the type must be complete anyways.
+ */
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <strict_variant/variant_fwd.hpp>
+#include <strict_variant/wrapper.hpp>
+#include <type_traits>
+#include <utility>
+
+#ifdef STRICT_VARIANT_DEBUG
+#include <cassert>
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+    assert((X) && C);                                                                              \
+  } while (0)
+
+#else // STRICT_VARIANT_DEBUG
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+  } while (0)
+
+#endif // STRICT_VARIANT_DEBUG
+
+namespace strict_variant {
+namespace detail {
+
+// The buffer of an `inline_wrapper` is aligned for pointers and for the
+// scalar types, but not over-aligned, so as not to pad the variant.
+union inline_buffer_align {
+  void * p;
+  double d;
+  long long l;
+};
+
+/***
+ * Metafunction `fits_inline`: Whether `T` is held in place, in a buffer of
+ * `size` bytes.
+ */
+template <typename T, std::size_t size>
+struct fits_inline
+  : std::integral_constant<bool, sizeof(T) <= size
+                                   && alignof(T) <= alignof(inline_buffer_align)
+                                   && std::is_nothrow_move_constructible<T>::value> {};
+
+} // end namespace detail
+
+//[ strict_variant_inline_wrapper
+template <typename T, std::size_t N = 4 * sizeof(void *)>
+class inline_wrapper {
+  // The buffer holds either the value, or a pointer to it
+  static constexpr std::size_t buffer_size = N < sizeof(T *) ? sizeof(T *) : N;
+
+  using buffer_t =
+    typename std::aligned_storage<buffer_size, alignof(detail::inline_buffer_align)>::type;
+  buffer_t m_buffer;
+
+  using in_place = detail::fits_inline<T, buffer_size>;
+
+  T *& heap_ptr() noexcept { return *reinterpret_cast<T **>(&m_buffer); }
+  T * const & heap_ptr() const noexcept { return *reinterpret_cast<T * const *>(&m_buffer); }
+
+  T * ptr(std::true_type) noexcept { return reinterpret_cast<T *>(&m_buffer); }
+  const T * ptr(std::true_type) const noexcept { return reinterpret_cast<const T *>(&m_buffer); }
+  T * ptr(std::false_type) const noexcept { return this->heap_ptr(); }
+
+  T * ptr() noexcept { return this->ptr(typename in_place::type{}); }
+  const T * ptr() const noexcept { return this->ptr(typename in_place::type{}); }
+
+  template <typename... Args>
+  void init(std::true_type, Args &&... args) {
+    new (&m_buffer) T(std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  void init(std::false_type, Args &&... args) {
+    new (&m_buffer) T *(new T(std::forward<Args>(args)...));
+  }
+
+  void destroy(std::true_type) noexcept { this->ptr(std::true_type{})->~T(); }
+  void destroy(std::false_type) noexcept { delete this->heap_ptr(); }
+
+  void move_from(std::true_type, inline_wrapper & rhs) noexcept {
+    new (&m_buffer) T(std::move(*rhs.ptr(std::true_type{})));
+  }
+
+  // Pointer move
+  void move_from(std::false_type, inline_wrapper & rhs) noexcept {
+    new (&m_buffer) T *(rhs.heap_ptr());
+    rhs.heap_ptr() = nullptr;
+  }
+
+public:
+  typedef T value_type;
+  typedef std::unique_ptr<T> unique_ptr_type;
+
+  // Whether a `T` is held in place, rather than on the heap. `T` must be complete.
+  static constexpr bool holds_inline() { return in_place::value; }
+
+  ~inline_wrapper() noexcept { this->destroy(typename in_place::type{}); }
+
+  template <typename... Args>
+  inline_wrapper(Args &&... args) {
+    this->init(typename in_place::type{}, std::forward<Args>(args)...);
+  }
+
+  inline_wrapper(inline_wrapper & rhs)
+    : inline_wrapper(static_cast<const inline_wrapper &>(rhs)) {}
+
+  inline_wrapper(const inline_wrapper & rhs) {
+    this->init(typename in_place::type{}, rhs.get());
+  }
+
+  // Moves the value if it is in place, and the pointer if it is not
+  inline_wrapper(inline_wrapper && rhs) noexcept {
+    this->move_from(typename in_place::type{}, rhs);
+  }
+
+  // Adopts an object made with `new`. A value held in place is moved out of it.
+  explicit inline_wrapper(unique_ptr_type && p) noexcept {
+    STRICT_VARIANT_ASSERT(p, "Adopted a null pointer!");
+    this->adopt(typename in_place::type{}, std::move(p));
+  }
+
+  inline_wrapper & operator=(const inline_wrapper &) = delete;
+  inline_wrapper & operator=(inline_wrapper &&) = delete;
+
+  // Gives up ownership of the value. A value on the heap is handed over, and
+  // the wrapper is left empty, and may only be destroyed. A value held in place
+  // is moved to the heap, which may throw.
+  unique_ptr_type release() { return this->release(typename in_place::type{}); }
+
+  T & get() & {
+    STRICT_VARIANT_ASSERT(this->ptr(), "Bad access!");
+    return *this->ptr();
+  }
+  const T & get() const & {
+    STRICT_VARIANT_ASSERT(this->ptr(), "Bad access!");
+    return *this->ptr();
+  }
+  T && get() && {
+    STRICT_VARIANT_ASSERT(this->ptr(), "Bad access!");
+    return std::move(*this->ptr());
+  }
+
+private:
+  void adopt(std::true_type, unique_ptr_type && p) noexcept {
+    this->init(std::true_type{}, std::move(*p));
+    p.reset();
+  }
+
+  void adopt(std::false_type, unique_ptr_type && p) noexcept { new (&m_buffer) T *(p.release()); }
+
+  unique_ptr_type release(std::true_type) {
+    return unique_ptr_type{new T(std::move(this->get()))};
+  }
+
+  unique_ptr_type release(std::false_type) noexcept {
+    T * t = this->heap_ptr();
+    this->heap_ptr() = nullptr;
+    return unique_ptr_type{t};
+  }
+};
+//]
+
+namespace detail {
+
+template <typename T, std::size_t N>
+struct is_wrapper<inline_wrapper<T, N>> : std::true_type {};
+
+} // end namespace detail
+
+} // end namespace strict_variant
+
+#undef STRICT_VARIANT_ASSERT
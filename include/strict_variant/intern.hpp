@@ -0,0 +1,310 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Hash-consing of recursive variant values.
+ *
+ * An `interned<T>` is a wrapper whose value is looked up in a table of
+ * canonical values when it is constructed, and shared with every other
+ * `interned<T>` equal to it. So structurally equal subtrees share storage,
+ * and since the children of a canonical value are canonical themselves,
+ * comparing and hashing them is a pointer comparison and a stored hash.
+ *
+ * The table is sharded, each shard with its own lock, so values may be
+ * interned and released on many threads at once.
+ */
+
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_hash.hpp>
+#include <strict_variant/wrapper.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#ifdef STRICT_VARIANT_DEBUG
+#include <cassert>
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+    assert((X) && C);                                                                              \
+  } while (0)
+
+#else // STRICT_VARIANT_DEBUG
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+  } while (0)
+
+#endif // STRICT_VARIANT_DEBUG
+
+namespace strict_variant {
+namespace detail {
+
+// A canonical value in an intern table, or a private copy of one
+template <typename T>
+struct interned_node {
+  std::atomic<std::size_t> count;
+  std::size_t hash;
+  bool canonical;
+  T value;
+
+  template <typename U>
+  interned_node(std::size_t h, bool c, U && u)
+    : count(1)
+    , hash(h)
+    , canonical(c)
+    , value(std::forward<U>(u)) {}
+};
+
+} // end namespace detail
+
+//[ strict_variant_intern_table
+/***
+ * A table of canonical values of `T`, split into `num_shards` shards by hash,
+ * each with its own lock. Each value is reference counted, and removed when
+ * the last reference is dropped.
+ */
+template <typename T, typename Hash = std::hash<T>, typename Eq = std::equal_to<T>>
+class intern_table {
+public:
+  using node_t = detail::interned_node<T>;
+
+  static constexpr std::size_t num_shards = 16;
+
+  // The table used by `interned<T, Hash, Eq>`. It is never destroyed, so that
+  // values may be released during static destruction.
+  static intern_table & instance() {
+    static intern_table * t = new intern_table;
+    return *t;
+  }
+
+  // Returns the canonical node equal to `u`, with a reference added
+  template <typename U>
+  node_t * intern(U && u) {
+    const std::size_t hash = Hash{}(static_cast<const T &>(u));
+    shard & s = this->shard_for(hash);
+
+    std::lock_guard<std::mutex> lock{s.mutex};
+    auto range = s.nodes.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      node_t * n = it->second;
+      if (Eq{}(n->value, static_cast<const T &>(u))) {
+        if (acquire(n)) { return n; }
+        // Its last reference is being dropped, replace it
+        s.nodes.erase(it);
+        break;
+      }
+    }
+
+    std::unique_ptr<node_t> n{new node_t(hash, true, std::forward<U>(u))};
+    s.nodes.emplace(hash, n.get());
+    return n.release();
+  }
+
+  // Drops a reference to a canonical node
+  void release(node_t * n) noexcept {
+    STRICT_VARIANT_ASSERT(n->canonical, "Released a node which is not in the table!");
+    if (n->count.fetch_sub(1, std::memory_order_acq_rel) != 1) { return; }
+
+    {
+      shard & s = this->shard_for(n->hash);
+      std::lock_guard<std::mutex> lock{s.mutex};
+      auto range = s.nodes.equal_range(n->hash);
+      for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == n) {
+          s.nodes.erase(it);
+          break;
+        }
+      }
+    }
+    delete n;
+  }
+
+  // The number of canonical values
+  std::size_t size() const {
+    std::size_t result = 0;
+    for (const shard & s : m_shards) {
+      std::lock_guard<std::mutex> lock{s.mutex};
+      result += s.nodes.size();
+    }
+    return result;
+  }
+
+private:
+  struct shard {
+    mutable std::mutex mutex;
+    std::unordered_multimap<std::size_t, node_t *> nodes;
+  };
+
+  shard m_shards[num_shards];
+
+  // The low bits of the hash pick the bucket within a shard, so use high ones
+  shard & shard_for(std::size_t hash) noexcept {
+    return m_shards[(hash ^ (hash >> 29) ^ (hash >> 13)) % num_shards];
+  }
+
+  // Adds a reference, unless the last one has already been dropped
+  static bool acquire(node_t * n) noexcept {
+    std::size_t c = n->count.load(std::memory_order_relaxed);
+    while (c) {
+      if (n->count.compare_exchange_weak(c, c + 1, std::memory_order_relaxed)) { return true; }
+    }
+    return false;
+  }
+};
+
+template <typename T, typename Hash, typename Eq>
+constexpr std::size_t intern_table<T, Hash, Eq>::num_shards;
+//]
+
+//[ strict_variant_interned
+/***
+ * Wrapper which holds a canonical value from `intern_table<T, Hash, Eq>`.
+ *
+ * Const access reads the canonical value. Mutable access first gives the
+ * wrapper a private copy, which is no longer canonical, like `shared_wrapper`.
+ */
+template <typename T, typename Hash = std::hash<T>, typename Eq = std::equal_to<T>>
+class interned {
+  using table_t = intern_table<T, Hash, Eq>;
+  using node_t = detail::interned_node<T>;
+  node_t * m_node;
+
+  void destroy() noexcept {
+    if (!m_node) { return; }
+    if (m_node->canonical) {
+      table_t::instance().release(m_node);
+    } else if (m_node->count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete m_node;
+    }
+  }
+
+  // Gives this wrapper a private copy, unless it has one already
+  void unshare() {
+    STRICT_VARIANT_ASSERT(m_node, "Bad access!");
+    if (m_node->canonical || m_node->count.load(std::memory_order_acquire) != 1) {
+      node_t * n = new node_t(m_node->hash, false, static_cast<const T &>(m_node->value));
+      this->destroy();
+      m_node = n;
+    }
+  }
+
+  // (These are not ctors, so that checking whether the wrapper is
+  // constructible doesn't need `T` to be complete.)
+  void init(const T & t) { m_node = table_t::instance().intern(t); }
+  void init(T & t) { this->init(static_cast<const T &>(t)); }
+  void init(T && t) { m_node = table_t::instance().intern(std::move(t)); }
+
+  template <typename... Args>
+  void init(Args &&... args) {
+    this->init(T(std::forward<Args>(args)...));
+  }
+
+public:
+  typedef T value_type;
+
+  ~interned() noexcept { this->destroy(); }
+
+  template <typename... Args>
+  interned(Args &&... args)
+    : m_node(nullptr) {
+    this->init(std::forward<Args>(args)...);
+  }
+
+  interned(interned & rhs) noexcept
+    : interned(static_cast<const interned &>(rhs)) {}
+
+  // Shares the value
+  interned(const interned & rhs) noexcept //
+    : m_node(rhs.m_node)                  //
+  {
+    STRICT_VARIANT_ASSERT(m_node, "Copied an empty wrapper!");
+    m_node->count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Pointer move
+  interned(interned && rhs) noexcept //
+    : m_node(rhs.m_node)             //
+  {
+    rhs.m_node = nullptr;
+  }
+
+  interned & operator=(const interned &) = delete;
+  interned & operator=(interned &&) = delete;
+
+  // Whether the value is the canonical one, rather than a private copy
+  bool canonical() const noexcept {
+    STRICT_VARIANT_ASSERT(m_node, "Bad access!");
+    return m_node->canonical;
+  }
+
+  // Two canonical values are equal exactly if they are the same object
+  friend bool operator==(const interned & l, const interned & r) {
+    if (l.canonical() && r.canonical()) { return l.m_node == r.m_node; }
+    return Eq{}(l.get(), r.get());
+  }
+
+  friend bool operator!=(const interned & l, const interned & r) { return !(l == r); }
+
+  // The hash of a canonical value was computed when it was interned
+  std::size_t hash() const {
+    return this->canonical() ? m_node->hash : Hash{}(m_node->value);
+  }
+
+  const T & get() const & {
+    STRICT_VARIANT_ASSERT(m_node, "Bad access!");
+    return m_node->value;
+  }
+  T & get() & {
+    this->unshare();
+    return m_node->value;
+  }
+  T && get() && {
+    this->unshare();
+    return std::move(m_node->value);
+  }
+};
+//]
+
+namespace detail {
+
+template <typename T, typename H, typename E>
+struct is_wrapper<interned<T, H, E>> : std::true_type {};
+
+template <typename T, typename H, typename E>
+struct is_shared_wrapper<interned<T, H, E>> : std::true_type {};
+
+template <typename T, typename H, typename E>
+struct value_equal<interned<T, H, E>, true, false> {
+  static bool equal(const interned<T, H, E> & l, const interned<T, H, E> & r) { return l == r; }
+};
+
+template <typename T, typename H, typename E>
+struct value_hash<interned<T, H, E>, true, false> {
+  static std::size_t hash(const interned<T, H, E> & t) { return t.hash(); }
+};
+
+} // end namespace detail
+
+} // end namespace strict_variant
+
+namespace std {
+
+template <typename T, typename H, typename E>
+struct hash<strict_variant::interned<T, H, E>> {
+  std::size_t operator()(const strict_variant::interned<T, H, E> & t) const { return t.hash(); }
+};
+
+} // end namespace std
+
+#undef STRICT_VARIANT_ASSERT
@@ -0,0 +1,374 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * A wrapper which destroys and copies recursive structures iteratively.
+ *
+ * Destroying a long list made of `recursive_wrapper`s recurses once per node,
+ * through the destructors of the wrapper, the node and the variant, and so
+ * does copying it. Deep enough, that overflows the stack.
+ *
+ * `iterative_wrapper` breaks that recursion. While one `iterative_wrapper` on
+ * a thread is deleting its value, any other one destroyed on that thread
+ * pushes its value onto a heap-allocated work stack instead of deleting it,
+ * and the first one deletes them in a loop. Copies work the same way: a
+ * nested copy marks its wrapper as pending, and the first copy fills it in
+ * later. So destroying or copying a tree of any depth uses a fixed amount of
+ * native stack.
+ *
+ * The copy constructor of the parent may still use a pending wrapper. If it
+ * is moved or copied, the deferred copy follows it, or is made twice. If its
+ * value is accessed, the value is copied right away, which recurses once more.
+ *
+ * Since the copies are deferred, the copy constructor of `T` may only copy
+ * wrapped values which outlive the outermost copy, like those of the value
+ * it copies, and not, for instance, those of a local variable.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <strict_variant/variant_fwd.hpp>
+#include <strict_variant/wrapper.hpp>
+#include <type_traits>
+#include <utility>
+
+#ifdef STRICT_VARIANT_DEBUG
+#include <cassert>
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+    assert((X) && C);                                                                              \
+  } while (0)
+
+#else // STRICT_VARIANT_DEBUG
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+  } while (0)
+
+#endif // STRICT_VARIANT_DEBUG
+
+namespace strict_variant {
+namespace detail {
+
+// A deferred step: deletes `target`, or copies `source` into `*target`. A task
+// whose `run` is null was cancelled.
+struct iterative_task {
+  void (*run)(void * target, const void * source);
+  void * target;
+  const void * source;
+};
+
+// A stack of tasks, which grows without throwing
+class iterative_stack {
+  iterative_task * m_data = nullptr;
+  std::size_t m_size = 0;
+  std::size_t m_capacity = 0;
+
+public:
+  iterative_stack() = default;
+  iterative_stack(const iterative_stack &) = delete;
+  iterative_stack & operator=(const iterative_stack &) = delete;
+
+  ~iterative_stack() noexcept { ::operator delete(m_data); }
+
+  bool empty() const noexcept { return !m_size; }
+  std::size_t size() const noexcept { return m_size; }
+  void clear() noexcept { m_size = 0; }
+
+  // Returns false if it had to grow, and couldn't
+  bool push(const iterative_task & t) noexcept {
+    if (m_size == m_capacity) {
+      const std::size_t capacity = m_capacity ? 2 * m_capacity : 64;
+      void * data = ::operator new(capacity * sizeof(iterative_task), std::nothrow);
+      if (!data) { return false; }
+      if (m_size) { std::memcpy(data, m_data, m_size * sizeof(iterative_task)); }
+      ::operator delete(m_data);
+      m_data = static_cast<iterative_task *>(data);
+      m_capacity = capacity;
+    }
+    m_data[m_size++] = t;
+    return true;
+  }
+
+  iterative_task pop() noexcept {
+    STRICT_VARIANT_ASSERT(m_size, "Popped an empty stack!");
+    return m_data[--m_size];
+  }
+
+  // The task at index `i`, if it has this target and wasn't cancelled, or null
+  iterative_task * at(std::size_t i, const void * target) noexcept {
+    if (i < m_size && m_data[i].target == target && m_data[i].run) { return &m_data[i]; }
+    return nullptr;
+  }
+
+  // Runs tasks until there are none left. A task may push more.
+  void run_all() {
+    while (m_size) {
+      const iterative_task t = this->pop();
+      if (t.run) { t.run(t.target, t.source); }
+    }
+  }
+};
+
+// The calling thread's deferred deletes and copies
+struct iterative_work {
+  iterative_stack deletes;
+  iterative_stack copies;
+  bool deleting = false;
+  bool copying = false;
+
+  static iterative_work & local() noexcept {
+    static thread_local iterative_work w;
+    return w;
+  }
+};
+
+template <typename T>
+void
+iterative_delete_task(void * target, const void *) noexcept {
+  delete static_cast<T *>(target);
+}
+
+template <typename T>
+void
+iterative_delete(T * t) noexcept {
+  if (!t) { return; }
+
+  iterative_work & w = iterative_work::local();
+  if (w.deleting) {
+    // If the stack can't grow, fall back to recursion
+    if (!w.deletes.push(iterative_task{&iterative_delete_task<T>, t, nullptr})) { delete t; }
+    return;
+  }
+
+  w.deleting = true;
+  delete t;
+  w.deletes.run_all();
+  w.deleting = false;
+}
+
+template <typename T>
+void
+iterative_copy_task(void * target, const void * source) {
+  *static_cast<T **>(target) = new T(*static_cast<const T *>(source));
+}
+
+/***
+ * A wrapper whose copy is deferred holds the index of its task on the copy
+ * stack, shifted left, with the low bit set, in place of a pointer. (Pointers
+ * from `new` are aligned, so their low bit is clear.) So the task is found
+ * directly, when the wrapper is moved, copied, used or destroyed.
+ */
+template <typename T>
+T *
+iterative_pending(std::size_t index) noexcept {
+  return reinterpret_cast<T *>((static_cast<std::uintptr_t>(index) << 1) | 1u);
+}
+
+inline bool
+iterative_is_pending(const void * p) noexcept {
+  return reinterpret_cast<std::uintptr_t>(p) & 1u;
+}
+
+inline std::size_t
+iterative_pending_index(const void * p) noexcept {
+  return static_cast<std::size_t>(reinterpret_cast<std::uintptr_t>(p) >> 1);
+}
+
+// The deferred copy of a pending wrapper, or null
+template <typename T>
+iterative_task *
+iterative_copy_task_of(T * const * target) noexcept {
+  return iterative_work::local().copies.at(iterative_pending_index(*target), target);
+}
+
+// A wrapper whose copy is deferred moved from `from` to `to`
+template <typename T>
+void
+iterative_copy_moved(T ** from, T ** to) noexcept {
+  // `to` has taken the index, and the task still has the old target
+  iterative_work & w = iterative_work::local();
+  if (iterative_task * t = w.copies.at(iterative_pending_index(*to), from)) { t->target = to; }
+}
+
+// A wrapper whose copy is deferred is copied to `to`, which copies the same
+// source later
+template <typename T>
+void
+iterative_copy_again(T * const * from, T ** to) {
+  iterative_work & w = iterative_work::local();
+  iterative_task * t = iterative_copy_task_of(from);
+  STRICT_VARIANT_ASSERT(t, "Pending wrapper has no deferred copy!");
+  const std::size_t index = w.copies.size();
+  if (!w.copies.push(iterative_task{t->run, to, t->source})) { throw std::bad_alloc{}; }
+  *to = iterative_pending<T>(index);
+}
+
+// A wrapper whose copy is deferred is destroyed before the copy ran
+template <typename T>
+void
+iterative_copy_cancel(T ** target) noexcept {
+  if (iterative_task * t = iterative_copy_task_of(target)) { t->run = nullptr; }
+}
+
+// A wrapper whose copy is deferred is used, so the copy runs now
+template <typename T>
+void
+iterative_copy_now(T ** target) {
+  iterative_task * t = iterative_copy_task_of(target);
+  STRICT_VARIANT_ASSERT(t, "Pending wrapper has no deferred copy!");
+  const iterative_task task = *t;
+  t->run = nullptr;
+  task.run(task.target, task.source);
+}
+
+// If the outermost copy throws, throws away the deferred copies, and deletes
+// what was copied so far.
+template <typename T>
+struct iterative_copy_guard {
+  iterative_work & w;
+  T *& target;
+  bool success;
+
+  ~iterative_copy_guard() noexcept {
+    w.copies.clear();
+    w.copying = false;
+    if (!success) {
+      iterative_delete(target);
+      target = nullptr;
+    }
+  }
+};
+
+template <typename T>
+void
+iterative_copy(T *& target, const T * source) {
+  iterative_work & w = iterative_work::local();
+  if (w.copying) {
+    const std::size_t index = w.copies.size();
+    if (!w.copies.push(iterative_task{&iterative_copy_task<T>, &target, source})) {
+      throw std::bad_alloc{};
+    }
+    target = iterative_pending<T>(index);
+    return;
+  }
+
+  w.copying = true;
+  iterative_copy_guard<T> guard{w, target, false};
+  target = new T(*source);
+  w.copies.run_all();
+  guard.success = true;
+}
+
+} // end namespace detail
+
+//[ strict_variant_iterative_wrapper
+template <typename T>
+class iterative_wrapper {
+  T * m_t;
+
+  template <typename... Args>
+  void init(Args &&... args) {
+    m_t = new T(std::forward<Args>(args)...);
+  }
+
+  // Copying a value is iterative too. (These are not ctors, so that checking
+  // whether the wrapper is constructible doesn't need `T` to be complete.)
+  void init(T & t) { this->init(static_cast<const T &>(t)); }
+  void init(const T & t) { detail::iterative_copy(m_t, &t); }
+
+  // Whether our copy is deferred, see `iterative_copy`
+  bool pending() const noexcept { return detail::iterative_is_pending(m_t); }
+
+  void resolve() {
+    if (this->pending()) { detail::iterative_copy_now(&m_t); }
+  }
+
+public:
+  typedef T value_type;
+  typedef std::unique_ptr<T> unique_ptr_type;
+
+  ~iterative_wrapper() noexcept {
+    if (this->pending()) {
+      detail::iterative_copy_cancel(&m_t);
+    } else {
+      detail::iterative_delete(m_t);
+    }
+  }
+
+  template <typename... Args>
+  iterative_wrapper(Args &&... args)
+    : m_t(nullptr) {
+    this->init(std::forward<Args>(args)...);
+  }
+
+  iterative_wrapper(iterative_wrapper & rhs)
+    : iterative_wrapper(static_cast<const iterative_wrapper &>(rhs)) {}
+
+  iterative_wrapper(const iterative_wrapper & rhs)
+    : m_t(nullptr) {
+    STRICT_VARIANT_ASSERT(rhs.m_t, "Copied an empty wrapper!");
+    if (rhs.pending()) {
+      detail::iterative_copy_again(&rhs.m_t, &m_t);
+    } else {
+      detail::iterative_copy(m_t, static_cast<const T *>(rhs.m_t));
+    }
+  }
+
+  // Pointer move
+  iterative_wrapper(iterative_wrapper && rhs) noexcept //
+    : m_t(rhs.m_t)                                     //
+  {
+    if (this->pending()) { detail::iterative_copy_moved(&rhs.m_t, &m_t); }
+    rhs.m_t = nullptr;
+  }
+
+  // Adopts an object made with `new`
+  explicit iterative_wrapper(unique_ptr_type && p) noexcept //
+    : m_t(p.release())                                      //
+  {
+    STRICT_VARIANT_ASSERT(m_t, "Adopted a null pointer!");
+  }
+
+  iterative_wrapper & operator=(const iterative_wrapper &) = delete;
+  iterative_wrapper & operator=(iterative_wrapper &&) = delete;
+
+  // Gives up ownership of the object, leaving the wrapper empty. An empty
+  // wrapper may only be destroyed.
+  unique_ptr_type release() {
+    this->resolve();
+    T * t = m_t;
+    m_t = nullptr;
+    return unique_ptr_type{t};
+  }
+
+  T & get() & {
+    this->resolve();
+    STRICT_VARIANT_ASSERT(m_t, "Bad access!");
+    return *m_t;
+  }
+  // A pending wrapper belongs to a value which is still being copied, so it
+  // isn't const yet
+  const T & get() const & { return const_cast<iterative_wrapper &>(*this).get(); }
+  T && get() && { return std::move(this->get()); }
+};
+//]
+
+namespace detail {
+
+template <typename T>
+struct is_wrapper<iterative_wrapper<T>> : std::true_type {};
+
+} // end namespace detail
+
+} // end namespace strict_variant
+
+#undef STRICT_VARIANT_ASSERT
@@ -0,0 +1,191 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * A monotonic buffer, and a stateful allocator which allocates from one, for
+ * use with `alloc_wrapper`.
+ *
+ * Freeing memory from a monotonic buffer does nothing, all of it is released
+ * at once when the buffer is. So a request-scoped tree of variants can be
+ * built in a buffer, and then torn down without a call to the heap per node.
+ */
+
+#include <strict_variant/alloc_variant.hpp>
+#include <strict_variant/alloc_wrapper.hpp>
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace strict_variant {
+
+//[ strict_variant_monotonic_buffer
+class monotonic_buffer {
+public:
+  // Every allocation is aligned to this
+  static constexpr std::size_t align = alignof(std::max_align_t);
+
+  explicit monotonic_buffer(std::size_t initial_size = 4096) noexcept
+    : m_chunks(nullptr)
+    , m_cur(nullptr)
+    , m_end(nullptr)
+    , m_next_size(round_up(initial_size)) {}
+
+  monotonic_buffer(const monotonic_buffer &) = delete;
+  monotonic_buffer & operator=(const monotonic_buffer &) = delete;
+
+  ~monotonic_buffer() noexcept { this->release(); }
+
+  // Takes `bytes` from the current chunk, or from a new, larger one
+  void * allocate(std::size_t bytes) {
+    if (bytes > std::numeric_limits<std::size_t>::max() / 2) { throw std::bad_alloc{}; }
+    bytes = round_up(bytes);
+    if (static_cast<std::size_t>(m_end - m_cur) < bytes) { this->refill(bytes); }
+    void * result = m_cur;
+    m_cur += bytes;
+    return result;
+  }
+
+  // Frees all of the memory at once. Anything still using it must not be
+  // touched again.
+  void release() noexcept {
+    while (m_chunks) {
+      chunk * next = m_chunks->next;
+      ::operator delete(m_chunks);
+      m_chunks = next;
+    }
+    m_cur = m_end = nullptr;
+  }
+
+  /***
+   * The buffer which default constructed `monotonic_allocator`s on this thread
+   * use, if any. It is set for the lifetime of a `scope` object.
+   */
+  static monotonic_buffer * current() noexcept { return current_ref(); }
+
+  class scope {
+    monotonic_buffer * m_prev;
+
+  public:
+    explicit scope(monotonic_buffer & buffer) noexcept
+      : m_prev(current_ref()) {
+      current_ref() = &buffer;
+    }
+
+    scope(const scope &) = delete;
+    scope & operator=(const scope &) = delete;
+
+    ~scope() noexcept { current_ref() = m_prev; }
+  };
+
+private:
+  struct chunk {
+    chunk * next;
+  };
+
+  static constexpr std::size_t header_size = (sizeof(chunk) + align - 1) / align * align;
+
+  chunk * m_chunks;
+  char * m_cur;
+  char * m_end;
+  std::size_t m_next_size;
+
+  static std::size_t round_up(std::size_t n) noexcept {
+    return (n + align - 1) / align * align;
+  }
+
+  static monotonic_buffer *& current_ref() noexcept {
+    static thread_local monotonic_buffer * b = nullptr;
+    return b;
+  }
+
+  // Chunks grow geometrically
+  void refill(std::size_t bytes) {
+    const std::size_t size = bytes < m_next_size ? m_next_size : bytes;
+    char * mem = static_cast<char *>(::operator new(header_size + size));
+    m_chunks = new (mem) chunk{m_chunks};
+    m_cur = mem + header_size;
+    m_end = m_cur + size;
+    if (m_next_size <= std::numeric_limits<std::size_t>::max() / 4) { m_next_size *= 2; }
+  }
+};
+//]
+
+//[ strict_variant_monotonic_allocator
+/***
+ * Stateful allocator which allocates from a `monotonic_buffer`, and whose
+ * `deallocate` does nothing.
+ *
+ * A default constructed allocator uses `monotonic_buffer::current()`. If
+ * there is none, it uses `std::allocator` instead.
+ */
+template <typename T>
+class monotonic_allocator {
+  monotonic_buffer * m_buffer;
+
+  template <typename U>
+  friend class monotonic_allocator;
+
+public:
+  typedef T value_type;
+
+  monotonic_allocator() noexcept
+    : m_buffer(monotonic_buffer::current()) {}
+
+  explicit monotonic_allocator(monotonic_buffer & buffer) noexcept
+    : m_buffer(&buffer) {}
+
+  template <typename U>
+  monotonic_allocator(const monotonic_allocator<U> & other) noexcept
+    : m_buffer(other.m_buffer) {}
+
+  T * allocate(std::size_t n) {
+    if (!m_buffer) { return std::allocator<T>{}.allocate(n); }
+    if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) { throw std::bad_alloc{}; }
+    return static_cast<T *>(m_buffer->allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T * p, std::size_t n) noexcept {
+    if (!m_buffer) { std::allocator<T>{}.deallocate(p, n); }
+  }
+
+  monotonic_buffer * buffer() const noexcept { return m_buffer; }
+};
+
+template <typename T, typename U>
+bool
+operator==(const monotonic_allocator<T> & a, const monotonic_allocator<U> & b) noexcept {
+  return a.buffer() == b.buffer();
+}
+
+template <typename T, typename U>
+bool
+operator!=(const monotonic_allocator<T> & a, const monotonic_allocator<U> & b) noexcept {
+  return !(a == b);
+}
+
+template <typename U>
+struct allocation_alignment<monotonic_allocator<U>>
+  : std::integral_constant<std::size_t, monotonic_buffer::align> {};
+
+/***
+ * Version of `recursive_wrapper<T>` which allocates with a `monotonic_allocator`.
+ */
+template <typename T>
+using monotonic_wrapper = alloc_wrapper<T, monotonic_allocator<T>>;
+
+/***
+ * Version of `easy_variant`, which wraps types with throwing moves in
+ * `monotonic_wrapper`.
+ */
+template <typename... Ts>
+using monotonic_variant = alloc_variant<monotonic_allocator>::type<Ts...>;
+//]
+
+} // end namespace strict_variant
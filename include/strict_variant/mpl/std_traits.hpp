@@ -26,5 +26,35 @@ using decay_t = typename std::decay<T>::type;
 template <bool b, typename U = void>
 using enable_if_t = typename std::enable_if<b, U>::type;
 
+/***
+ * The `is_trivially_*` traits are C++11, but libstdc++ only provides them
+ * starting with gcc 5. Older versions get a conservative approximation using
+ * the builtins.
+ */
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ < 5)
+
+template <typename T>
+struct is_trivially_copy_constructible : std::integral_constant<bool, __has_trivial_copy(T)> {};
+
+template <typename T>
+struct is_trivially_copy_assignable : std::integral_constant<bool, __has_trivial_assign(T)> {};
+
+template <typename T>
+struct is_trivially_move_constructible : std::is_trivial<T> {};
+
+template <typename T>
+struct is_trivially_move_assignable : std::is_trivial<T> {};
+
+#else
+
+using std::is_trivially_copy_constructible;
+using std::is_trivially_copy_assignable;
+using std::is_trivially_move_constructible;
+using std::is_trivially_move_assignable;
+
+#endif
+
+using std::is_trivially_destructible;
+
 } // end namespace mpl
 } // end namsepace strict_variant
@@ -125,9 +125,16 @@ struct multivisitor_state<Visitor, TypeList<Vs...>, TypeList<U1, Us...>>
 
 namespace detail {
 
+/***
+ * Nested multivisitation: visit the first variant, then the second one with
+ * a visitor which holds the first value, and so on.
+ *
+ * `apply_visitor` uses this when one of the visitables isn't a `variant`,
+ * such as a `variant_vector` reference, since it only needs unary visitation.
+ */
 template <typename Visitor, typename... Us>
 auto
-multivisit_impl(Visitor && visitor, Us &&... us) -> decltype(
+nested_multivisit_impl(Visitor && visitor, Us &&... us) -> decltype(
   static_cast<mpl::multivisitor_state<Visitor, mpl::TypeList<>, mpl::TypeList<Us...>> *>(nullptr)
     ->evaluate()) {
   mpl::multivisitor_state<Visitor, mpl::TypeList<>, mpl::TypeList<Us...>> st{
@@ -135,17 +142,204 @@ multivisit_impl(Visitor && visitor, Us &&... us) -> decltype(
   return st.evaluate();
 }
 
+/***
+ * Flat multivisitation: combine the `which` values of all of the variants
+ * into one index, and dispatch on that once, using the usual dispatch
+ * mechanism. Each leaf then gets the values straight out of the storages.
+ *
+ * If the variants have n1, n2, ..., nk types, the combined index is
+ *   ((w1 * n2 + w2) * n3 + w3) ... * nk + wk
+ * so there are n1 * n2 * ... * nk leaves.
+ */
+
+// Number of types in a variant, or zero if it isn't one
+template <typename T>
+struct multivisit_num_types {
+  static constexpr unsigned int value = 0;
+};
+
+template <typename... Types>
+struct multivisit_num_types<variant<Types...>> {
+  static constexpr unsigned int value = sizeof...(Types);
+};
+
+template <typename V>
+using multivisit_num_types_t =
+  multivisit_num_types<typename std::remove_cv<mpl::remove_reference_t<V>>::type>;
+
+// Combines indices, and splits them up again, given the number of types of each variant
+template <unsigned int... ns>
+struct mixed_radix;
+
+template <>
+struct mixed_radix<> {
+  static constexpr unsigned int size = 1;
+
+  static unsigned int combine() noexcept { return 0; }
+
+  static constexpr unsigned int digit(unsigned int, unsigned int) { return 0; }
+};
+
+template <unsigned int n, unsigned int... ns>
+struct mixed_radix<n, ns...> {
+  using rest_t = mixed_radix<ns...>;
+
+  static constexpr unsigned int size = n * rest_t::size;
+
+  template <typename... Ws>
+  static unsigned int combine(unsigned int w, Ws... ws) noexcept {
+    return w * rest_t::size + rest_t::combine(ws...);
+  }
+
+  // The j'th index which went into combined index k
+  static constexpr unsigned int digit(unsigned int k, unsigned int j) {
+    return j == 0 ? k / rest_t::size : rest_t::digit(k % rest_t::size, j - 1);
+  }
+};
+
+// Plays the role of the variant's storage for the dispatcher: `get_value<k>`
+// returns a position which refers to all of the storages.
+template <unsigned int index, typename StorageTuple>
+struct multivisit_position {
+  StorageTuple & storages;
+};
+
+template <typename StorageTuple>
+struct multivisit_storage {
+  StorageTuple & storages;
+
+  template <unsigned int index, typename Internal>
+  multivisit_position<index, StorageTuple> get_value(Internal) const noexcept {
+    return {storages};
+  }
+};
+
+// Plays the role of the visitor for the dispatcher: for a position, splits up
+// the combined index, and calls the user's visitor with each value.
+template <typename Visitor, typename radix_t, typename StorageTuple>
+struct multivisit_visitor {
+  Visitor && visitor;
+
+  template <unsigned int j>
+  using storage_ref_t = typename std::tuple_element<j, StorageTuple>::type;
+
+#define RESULT_EXPR                                                                                \
+  std::forward<Visitor>(visitor)(                                                                  \
+    std::forward<storage_ref_t<js>>(std::get<js>(pos.storages))                                    \
+      .template get_value<radix_t::digit(index, js)>(false_{})...)
+
+  template <unsigned int index, unsigned int... js>
+  auto call(multivisit_position<index, StorageTuple> pos,
+            mpl::ulist<js...>) noexcept(noexcept(RESULT_EXPR)) -> decltype(RESULT_EXPR) {
+    return RESULT_EXPR;
+  }
+
+#undef RESULT_EXPR
+
+#define RESULT_EXPR this->call(pos, mpl::count_t<std::tuple_size<StorageTuple>::value>{})
+
+  template <unsigned int index>
+  auto operator()(multivisit_position<index, StorageTuple> pos) noexcept(noexcept(RESULT_EXPR))
+    -> decltype(RESULT_EXPR) {
+    return RESULT_EXPR;
+  }
+
+#undef RESULT_EXPR
+};
+
+template <typename Strategy, typename Visitor, typename... Vs>
+struct flat_multivisit_helper {
+  using radix_t = mixed_radix<multivisit_num_types_t<Vs>::value...>;
+
+  using storage_tuple_t = std::tuple<decltype(
+    mpl::remove_reference_t<Vs>::storage_impl(std::forward<Vs>(std::declval<Vs>())))...>;
+
+  using storage_t = multivisit_storage<storage_tuple_t>;
+  using visitor_t = multivisit_visitor<Visitor, radix_t, storage_tuple_t>;
+  using dispatcher_t = visitor_dispatch<false_, radix_t::size, Strategy>;
+};
+
+#define RESULT_EXPR                                                                                \
+  typename flat_multivisit_helper<Strategy, Visitor, Vs...>::dispatcher_t{}(                       \
+    0u, std::declval<typename flat_multivisit_helper<Strategy, Visitor, Vs...>::storage_t &>(),   \
+    std::declval<typename flat_multivisit_helper<Strategy, Visitor, Vs...>::visitor_t &>())
+
+template <typename Strategy, typename Visitor, typename... Vs>
+auto
+flat_multivisit_impl(Visitor && visitor, Vs &&... vs) noexcept(noexcept(RESULT_EXPR))
+  -> decltype(RESULT_EXPR) {
+  using helper_t = flat_multivisit_helper<Strategy, Visitor, Vs...>;
+
+  const unsigned int index =
+    helper_t::radix_t::combine(static_cast<unsigned int>(vs.which())...);
+
+  typename helper_t::storage_tuple_t storages{
+    mpl::remove_reference_t<Vs>::storage_impl(std::forward<Vs>(vs))...};
+  typename helper_t::storage_t storage{storages};
+  typename helper_t::visitor_t vis{std::forward<Visitor>(visitor)};
+
+  return typename helper_t::dispatcher_t{}(index, storage, vis);
+}
+
+#undef RESULT_EXPR
+
+// Flat multivisitation when every visitable is a variant, nested otherwise
+template <typename Strategy, bool flat>
+struct multivisit_impl;
+
+template <typename Strategy>
+struct multivisit_impl<Strategy, true> {
+  template <typename Visitor, typename... Vs>
+  static auto apply(Visitor && visitor, Vs &&... vs) noexcept(noexcept(
+    flat_multivisit_impl<Strategy>(std::forward<Visitor>(visitor), std::forward<Vs>(vs)...)))
+    -> decltype(flat_multivisit_impl<Strategy>(std::forward<Visitor>(visitor),
+                                               std::forward<Vs>(vs)...)) {
+    return flat_multivisit_impl<Strategy>(std::forward<Visitor>(visitor), std::forward<Vs>(vs)...);
+  }
+};
+
+template <typename Strategy>
+struct multivisit_impl<Strategy, false> {
+  template <typename Visitor, typename... Vs>
+  static auto apply(Visitor && visitor, Vs &&... vs)
+    -> decltype(nested_multivisit_impl(std::forward<Visitor>(visitor), std::forward<Vs>(vs)...)) {
+    return nested_multivisit_impl(std::forward<Visitor>(visitor), std::forward<Vs>(vs)...);
+  }
+};
+
+template <typename Strategy, typename... Vs>
+using multivisit_impl_t =
+  multivisit_impl<Strategy, (mixed_radix<multivisit_num_types_t<Vs>::value...>::size != 0)>;
+
 } // end namespace detail
 
+/***
+ * Multivisitation dispatches on the combined index using binary search by
+ * default. The combined index usually has too many values for an indirect
+ * jump to be predicted well, and in `bench/` the binary search did best.
+ * Visitables other than `variant` are visited one after another instead.
+ */
+#define MULTIVISIT_BODY(S)                                                                         \
+  detail::multivisit_impl_t<S, V1, V2, Vs...>::apply(                                              \
+    std::forward<Visitor>(vis), std::forward<V1>(v1), std::forward<V2>(v2), std::forward<Vs>(vs)...)
+
 template <typename Visitor, typename V1, typename V2, typename... Vs>
 auto
-apply_visitor(Visitor && vis, V1 && v1, V2 && v2, Vs &&... vs)
-  -> decltype(detail::multivisit_impl(std::forward<Visitor>(std::declval<Visitor>()),
-                                      std::forward<V1>(std::declval<V1>()),
-                                      std::forward<V2>(std::declval<V2>()),
-                                      std::forward<Vs>(std::declval<Vs>())...)) {
-  return detail::multivisit_impl(std::forward<Visitor>(vis), std::forward<V1>(v1),
-                                 std::forward<V2>(v2), std::forward<Vs>(vs)...);
+apply_visitor(Visitor && vis, V1 && v1, V2 && v2,
+              Vs &&... vs) noexcept(noexcept(MULTIVISIT_BODY(dispatch::binary_search)))
+  -> decltype(MULTIVISIT_BODY(dispatch::binary_search)) {
+  return MULTIVISIT_BODY(dispatch::binary_search);
 }
 
+// Multivisitation using a particular dispatch strategy for the combined index
+template <typename Strategy, typename Visitor, typename V1, typename V2, typename... Vs>
+auto
+apply_visitor_with(Visitor && vis, V1 && v1, V2 && v2,
+                   Vs &&... vs) noexcept(noexcept(MULTIVISIT_BODY(Strategy)))
+  -> decltype(MULTIVISIT_BODY(Strategy)) {
+  return MULTIVISIT_BODY(Strategy);
+}
+
+#undef MULTIVISIT_BODY
+
 } // end namespace strict_variant
@@ -0,0 +1,280 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * A stateless allocator for single objects, which serves them from per-type,
+ * per-thread free lists, and `pool_wrapper` and `pool_variant`, which use it.
+ * Blocks may be freed by any thread, and threads pass surplus free blocks to
+ * each other through a shared list.
+ *
+ * A tree whose nodes are boxed with `recursive_wrapper` makes one small heap
+ * allocation per node. With `pool_wrapper`, allocating a node is instead
+ * popping a free list, and freeing it is pushing one, except when the free
+ * list is empty, and is refilled with a new slab of blocks.
+ */
+
+#include <strict_variant/alloc_variant.hpp>
+#include <strict_variant/alloc_wrapper.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace strict_variant {
+namespace detail {
+
+// Approximate size of the slabs the free lists are refilled from
+static constexpr std::size_t pool_slab_bytes = 16384;
+
+// Least number of blocks in a slab, whatever the block size
+static constexpr std::size_t pool_min_blocks = 8;
+
+constexpr std::size_t
+pool_round_up(std::size_t n, std::size_t align) {
+  return (n + align - 1) / align * align;
+}
+
+constexpr std::size_t
+pool_max(std::size_t a, std::size_t b) {
+  return a < b ? b : a;
+}
+
+/***
+ * Every slab, of every pool, is linked into one list, and never freed.
+ * So a block may be freed by any thread, at any time, even after the thread
+ * which allocated it has exited. (The list is lock free, and trivially
+ * destructible, so that it still works during static destruction.)
+ */
+struct pool_slab {
+  pool_slab * next;
+};
+
+inline void
+pool_register_slab(pool_slab * slab) noexcept {
+  static std::atomic<pool_slab *> head{nullptr};
+  slab->next = head.load(std::memory_order_relaxed);
+  while (!head.compare_exchange_weak(slab->next, slab, std::memory_order_release,
+                                     std::memory_order_relaxed)) {}
+}
+
+/***
+ * The pool for objects of type T. Each thread has its own free list, so
+ * allocating and freeing usually take no locks. A block freed by a thread goes
+ * on that thread's free list, whichever thread allocated it.
+ *
+ * So that blocks freed by one thread can be reused by another, a thread keeps
+ * at most two slabs' worth of free blocks: its free list, and a spare batch.
+ * When the free list has a slab's worth, freeing another block makes it the
+ * spare batch, and gives the old spare batch, if any, to a list shared by all
+ * threads. When the free list is empty, a thread takes the spare batch, or a
+ * batch from the shared list, before it makes a new slab. A thread gives all of
+ * its free blocks to the shared list when it exits.
+ *
+ * Blocks are aligned to `alignof(std::max_align_t)`, like the memory `new`
+ * returns.
+ */
+template <typename T>
+struct type_pool {
+  static constexpr std::size_t align = alignof(std::max_align_t);
+  static_assert(alignof(T) <= align, "Over-aligned types cannot be pooled");
+
+  struct free_block {
+    free_block * next;
+    // In the first block of a batch on the shared list, the next batch
+    free_block * next_batch;
+  };
+
+  static constexpr std::size_t block_size =
+    pool_round_up(pool_max(sizeof(T), sizeof(free_block)), align);
+  static constexpr std::size_t header_size = pool_round_up(sizeof(pool_slab), align);
+  static constexpr std::size_t blocks_per_slab =
+    pool_max(pool_min_blocks, (pool_slab_bytes - header_size) / block_size);
+
+  // A thread's free blocks. `size` is at least the length of `head`, which is
+  // shorter if it was a batch given up by a thread which exited. (Trivially
+  // destructible, so that it can still be used after `local_donor` is
+  // destroyed.)
+  struct local_list {
+    free_block * head;
+    std::size_t size;
+    free_block * spare;
+    bool exited;
+  };
+
+  // Batches of blocks given up by threads. (Trivially destructible, like the
+  // list of slabs.)
+  struct shared_list {
+    std::atomic<bool> busy;
+    free_block * batches;
+  };
+
+  static shared_list & shared() noexcept {
+    static shared_list s{{false}, nullptr};
+    return s;
+  }
+
+  // Puts a batch of blocks on the shared list
+  static void give(free_block * batch) noexcept {
+    shared_list & s = shared();
+    while (s.busy.exchange(true, std::memory_order_acquire)) {}
+    batch->next_batch = s.batches;
+    s.batches = batch;
+    s.busy.store(false, std::memory_order_release);
+  }
+
+  // Takes a batch of blocks from the shared list, or returns nullptr
+  static free_block * take() noexcept {
+    shared_list & s = shared();
+    while (s.busy.exchange(true, std::memory_order_acquire)) {}
+    free_block * batch = s.batches;
+    if (batch) { s.batches = batch->next_batch; }
+    s.busy.store(false, std::memory_order_release);
+    return batch;
+  }
+
+  static void give_all(local_list & l) noexcept {
+    if (l.spare) {
+      give(l.spare);
+      l.spare = nullptr;
+    }
+    if (l.head) {
+      give(l.head);
+      l.head = nullptr;
+    }
+    l.size = 0;
+  }
+
+  // Gives up the thread's free blocks when it exits
+  struct local_donor {
+    local_list & list;
+
+    ~local_donor() noexcept {
+      give_all(list);
+      list.exited = true;
+    }
+  };
+
+  // The calling thread's free blocks
+  static local_list & local() noexcept {
+    static thread_local local_list l{nullptr, 0, nullptr, false};
+    static thread_local local_donor d{l};
+    static_cast<void>(d);
+    return l;
+  }
+
+  // Puts the blocks of a new slab on the free list, in address order
+  static void refill(local_list & l) {
+    char * slab = static_cast<char *>(::operator new(header_size + blocks_per_slab * block_size));
+    pool_register_slab(new (slab) pool_slab{nullptr});
+
+    char * block = slab + header_size + blocks_per_slab * block_size;
+    for (std::size_t i = 0; i < blocks_per_slab; ++i) {
+      block -= block_size;
+      l.head = new (block) free_block{l.head, nullptr};
+    }
+  }
+
+  static void * allocate() {
+    local_list & l = local();
+    if (!l.head) {
+      if (l.spare) {
+        l.head = l.spare;
+        l.spare = nullptr;
+      } else if (!(l.head = take())) {
+        refill(l);
+      }
+      l.size = blocks_per_slab;
+    }
+    free_block * result = l.head;
+    l.head = result->next;
+    --l.size;
+    // After the thread's blocks have been given up, it keeps none
+    if (l.exited) { give_all(l); }
+    return result;
+  }
+
+  static void deallocate(void * p) noexcept {
+    local_list & l = local();
+    if (l.size >= blocks_per_slab) {
+      if (l.spare) { give(l.spare); }
+      l.spare = l.head;
+      l.head = nullptr;
+      l.size = 0;
+    }
+    l.head = new (p) free_block{l.head, nullptr};
+    ++l.size;
+    if (l.exited) { give_all(l); }
+  }
+};
+
+} // end namespace detail
+
+//[ strict_variant_pool_allocator
+/***
+ * Stateless allocator. Single objects come from `detail::type_pool<T>`, arrays
+ * come from `std::allocator<T>`.
+ *
+ * Memory taken by a pool is kept for reuse, and is never returned to the
+ * system.
+ */
+template <typename T>
+class pool_allocator {
+public:
+  typedef T value_type;
+
+  pool_allocator() noexcept = default;
+
+  template <typename U>
+  pool_allocator(const pool_allocator<U> &) noexcept {}
+
+  T * allocate(std::size_t n) {
+    if (n == 1) { return static_cast<T *>(detail::type_pool<T>::allocate()); }
+    return std::allocator<T>{}.allocate(n);
+  }
+
+  void deallocate(T * p, std::size_t n) noexcept {
+    if (n == 1) {
+      detail::type_pool<T>::deallocate(p);
+    } else {
+      std::allocator<T>{}.deallocate(p, n);
+    }
+  }
+};
+
+template <typename T, typename U>
+bool
+operator==(const pool_allocator<T> &, const pool_allocator<U> &) noexcept {
+  return true;
+}
+
+template <typename T, typename U>
+bool
+operator!=(const pool_allocator<T> &, const pool_allocator<U> &) noexcept {
+  return false;
+}
+
+template <typename U>
+struct allocation_alignment<pool_allocator<U>>
+  : std::integral_constant<std::size_t, alignof(std::max_align_t)> {};
+
+/***
+ * Drop-in replacement for `recursive_wrapper<T>`, which allocates from the pool.
+ */
+template <typename T>
+using pool_wrapper = alloc_wrapper<T, pool_allocator<T>>;
+
+/***
+ * Version of `easy_variant`, which wraps types with throwing moves in
+ * `pool_wrapper`.
+ */
+template <typename... Ts>
+using pool_variant = alloc_variant<pool_allocator>::type<Ts...>;
+//]
+
+} // end namespace strict_variant
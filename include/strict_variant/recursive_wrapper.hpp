@@ -8,6 +8,8 @@
 /***
  * For use with strict_variant::variant
  */
+#include <cstddef>
+#include <memory>
 #include <new>
 #include <strict_variant/variant_fwd.hpp>
 #include <strict_variant/wrapper.hpp>
@@ -37,17 +39,23 @@ namespace strict_variant {
 
 template <typename T>
 class recursive_wrapper {
-  T * m_t;
+  // `new` gives memory aligned for any fundamental type, the low bits of the
+  // pointer are left for a variant with compact_layout.
+  using pointer_t = detail::tagged_pointer<T, alignof(std::max_align_t)>;
+  pointer_t m_t;
 
-  void destroy() { delete m_t; }
+  void destroy() { delete m_t.get(); }
 
   template <typename... Args>
   void init(Args &&... args) {
-    m_t = new T(std::forward<Args>(args)...);
+    T * t = new T(std::forward<Args>(args)...);
+    STRICT_VARIANT_ASSERT(m_t.is_aligned(t), "Allocation is less aligned than spare_bits claims!");
+    m_t.set(t);
   }
 
 public:
   typedef T value_type;
+  typedef std::unique_ptr<T> unique_ptr_type;
 
   ~recursive_wrapper() noexcept { this->destroy(); }
 
@@ -67,9 +75,18 @@ public:
 
   // Pointer move
   recursive_wrapper(recursive_wrapper && rhs) noexcept //
-    : m_t(rhs.m_t)                                     //
+    : m_t(rhs.m_t.get())                               //
   {
-    rhs.m_t = nullptr;
+    rhs.m_t.set(nullptr);
+  }
+
+  // Adopts an object made with `new`
+  explicit recursive_wrapper(unique_ptr_type && p) noexcept //
+    : m_t(p.release())                                      //
+  {
+    STRICT_VARIANT_ASSERT(m_t.get(), "Adopted a null pointer!");
+    STRICT_VARIANT_ASSERT(m_t.is_aligned(m_t.get()),
+                          "Allocation is less aligned than spare_bits claims!");
   }
 
   // Not assignable, we never actually need this, and it adds complexity
@@ -77,17 +94,25 @@ public:
   recursive_wrapper & operator=(const recursive_wrapper &) = delete;
   recursive_wrapper & operator=(recursive_wrapper &&) = delete;
 
+  // Gives up ownership of the object, leaving the wrapper empty. An empty
+  // wrapper may only be destroyed.
+  unique_ptr_type release() noexcept {
+    T * t = m_t.get();
+    m_t.set(nullptr);
+    return unique_ptr_type{t};
+  }
+
   T & get() & {
-    STRICT_VARIANT_ASSERT(m_t, "Bad access!");
-    return *m_t;
+    STRICT_VARIANT_ASSERT(m_t.get(), "Bad access!");
+    return *m_t.get();
   }
   const T & get() const & {
-    STRICT_VARIANT_ASSERT(m_t, "Bad access!");
-    return *m_t;
+    STRICT_VARIANT_ASSERT(m_t.get(), "Bad access!");
+    return *m_t.get();
   }
   T && get() && {
-    STRICT_VARIANT_ASSERT(m_t, "Bad access!");
-    return std::move(*m_t);
+    STRICT_VARIANT_ASSERT(m_t.get(), "Bad access!");
+    return std::move(*m_t.get());
   }
 };
 //]
@@ -99,6 +124,10 @@ struct is_wrapper<recursive_wrapper<T>> : std::true_type {};
 
 } // end namespace detail
 
+template <typename T>
+struct spare_bits<recursive_wrapper<T>>
+  : std::integral_constant<unsigned int, detail::alignment_bits(alignof(std::max_align_t))> {};
+
 } // end namespace strict_variant
 
 #undef STRICT_VARIANT_ASSERT
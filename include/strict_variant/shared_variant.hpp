@@ -0,0 +1,298 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * A cell holding an immutable variant, for data which many threads read and
+ * which is rarely replaced, like configuration. A writer publishes a new
+ * version by swapping a pointer, and readers visit whichever version is
+ * current, in place, without taking a lock.
+ *
+ * Old versions are reclaimed with epochs: a reader announces the epoch in
+ * which it started, and a replaced version is freed once every reader has
+ * either finished, or started after it was replaced.
+ */
+
+#include <strict_variant/variant.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#ifdef STRICT_VARIANT_DEBUG
+#include <cassert>
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+    assert((X) && C);                                                                              \
+  } while (0)
+
+#else // STRICT_VARIANT_DEBUG
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+  } while (0)
+
+#endif // STRICT_VARIANT_DEBUG
+
+namespace strict_variant {
+namespace detail {
+
+static constexpr std::size_t rcu_cache_line = 64;
+
+/***
+ * A reader's announcement of the epoch in which it started reading, or zero
+ * when it isn't reading. Each thread which reads has one record, and records
+ * are reused by later threads once their thread exits.
+ *
+ * Records are linked into one list, and never freed, like `pool_slab`. Each
+ * has a cache line to itself, so that readers don't contend with each other.
+ */
+struct alignas(rcu_cache_line) rcu_record {
+  std::atomic<std::uint64_t> epoch{0};
+  std::atomic<bool> in_use{true};
+  rcu_record * next{nullptr};
+
+  // Nesting depth of the owning thread's reads
+  unsigned int depth{0};
+};
+
+struct rcu_domain {
+  std::atomic<std::uint64_t> epoch{1};
+  std::atomic<rcu_record *> head{nullptr};
+};
+
+inline rcu_domain &
+rcu_global() noexcept {
+  static rcu_domain d;
+  return d;
+}
+
+// `new` need not respect the alignment of `rcu_record` before C++17
+inline rcu_record *
+rcu_new_record() {
+  std::size_t space = sizeof(rcu_record) + rcu_cache_line;
+  void * p = ::operator new(space);
+  return new (std::align(rcu_cache_line, sizeof(rcu_record), p, space)) rcu_record;
+}
+
+inline rcu_record *
+rcu_acquire_record() {
+  rcu_domain & d = rcu_global();
+  for (rcu_record * r = d.head.load(std::memory_order_acquire); r; r = r->next) {
+    bool expected = false;
+    if (!r->in_use.load(std::memory_order_relaxed)
+        && r->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+      return r;
+    }
+  }
+
+  rcu_record * r = rcu_new_record();
+  r->next = d.head.load(std::memory_order_relaxed);
+  while (!d.head.compare_exchange_weak(r->next, r, std::memory_order_release,
+                                       std::memory_order_relaxed)) {}
+  return r;
+}
+
+// The calling thread's record, which is given back when the thread exits
+struct rcu_thread_record {
+  rcu_record * record;
+
+  rcu_thread_record()
+    : record(rcu_acquire_record()) {}
+
+  ~rcu_thread_record() { record->in_use.store(false, std::memory_order_release); }
+};
+
+inline rcu_record &
+rcu_local_record() {
+  static thread_local rcu_thread_record r;
+  return *r.record;
+}
+
+/***
+ * Reading starts by announcing the current epoch, and then loading the
+ * pointer to the current version. Both are sequentially consistent, so that
+ * a writer which has replaced that version, and then advanced the epoch, sees
+ * the announcement when it looks for readers.
+ */
+inline rcu_record *
+rcu_enter() {
+  rcu_record & r = rcu_local_record();
+  if (r.depth++ == 0) { r.epoch.store(rcu_global().epoch.load(), std::memory_order_seq_cst); }
+  return &r;
+}
+
+inline void
+rcu_exit(rcu_record * r) noexcept {
+  if (--r->depth == 0) { r->epoch.store(0, std::memory_order_release); }
+}
+
+// The earliest epoch announced by a reader, or the maximum if none is reading
+inline std::uint64_t
+rcu_min_epoch() noexcept {
+  std::uint64_t result = std::numeric_limits<std::uint64_t>::max();
+  for (rcu_record * r = rcu_global().head.load(std::memory_order_acquire); r; r = r->next) {
+    const std::uint64_t e = r->epoch.load(std::memory_order_seq_cst);
+    if (e && e < result) { result = e; }
+  }
+  return result;
+}
+
+} // end namespace detail
+
+//[ strict_variant_shared_variant
+/***
+ * A cell holding an immutable `V`, usually a variant, which many threads read
+ * and few threads replace.
+ *
+ * `read()` returns a `snapshot` of the current version, which stays valid
+ * until the snapshot is destroyed, even if the cell is stored to meanwhile.
+ * Taking a snapshot is wait-free: it stores the current epoch, and loads a
+ * pointer. `apply_visitor` takes a snapshot of the cell, or accepts one, and
+ * visits the value in place.
+ *
+ * `store` publishes a new version, and frees those old versions which no
+ * snapshot holds anymore. Those still held are freed by a later `store`, by
+ * `collect`, or by the destructor. Stores are serialized by a mutex.
+ *
+ * A snapshot must be destroyed by the thread which took it, and before the
+ * cell is destroyed.
+ */
+template <typename V>
+class shared_variant {
+  struct node {
+    const V value;
+
+    explicit node(V && v)
+      : value(std::move(v)) {}
+  };
+
+  struct retired_node {
+    node * ptr;
+    std::uint64_t epoch;
+  };
+
+  std::atomic<node *> m_current;
+
+  std::mutex m_mutex;
+  std::vector<retired_node> m_retired;
+
+  // Frees the retired nodes which no reader can hold. Call with m_mutex held
+  void collect_locked() noexcept {
+    const std::uint64_t min_epoch = detail::rcu_min_epoch();
+    std::size_t kept = 0;
+    for (const retired_node & r : m_retired) {
+      if (r.epoch < min_epoch) {
+        delete r.ptr;
+      } else {
+        m_retired[kept++] = r;
+      }
+    }
+    m_retired.resize(kept);
+  }
+
+public:
+  using value_type = V;
+
+  class snapshot {
+    detail::rcu_record * m_record;
+    const node * m_node;
+
+  public:
+    explicit snapshot(const shared_variant & s)
+      : m_record(detail::rcu_enter())
+      , m_node(s.m_current.load(std::memory_order_seq_cst)) {}
+
+    snapshot(snapshot && other) noexcept
+      : m_record(other.m_record)
+      , m_node(other.m_node) {
+      other.m_record = nullptr;
+    }
+
+    snapshot(const snapshot &) = delete;
+    snapshot & operator=(const snapshot &) = delete;
+    snapshot & operator=(snapshot &&) = delete;
+
+    ~snapshot() noexcept {
+      if (m_record) { detail::rcu_exit(m_record); }
+    }
+
+    const V & get() const noexcept {
+      STRICT_VARIANT_ASSERT(m_record, "Use of a moved-from snapshot!");
+      return m_node->value;
+    }
+
+    const V & operator*() const noexcept { return this->get(); }
+    const V * operator->() const noexcept { return &this->get(); }
+
+    // Used by `apply_visitor`
+    template <typename Visitor>
+    static auto apply_visitor_impl(Visitor && visitor, const snapshot & s)
+      -> decltype(strict_variant::apply_visitor(std::forward<Visitor>(visitor), s.get())) {
+      return strict_variant::apply_visitor(std::forward<Visitor>(visitor), s.get());
+    }
+  };
+
+  explicit shared_variant(V v)
+    : m_current(new node(std::move(v))) {}
+
+  shared_variant(const shared_variant &) = delete;
+  shared_variant & operator=(const shared_variant &) = delete;
+
+  ~shared_variant() noexcept {
+    for (const retired_node & r : m_retired) {
+      delete r.ptr;
+    }
+    delete m_current.load(std::memory_order_relaxed);
+  }
+
+  snapshot read() const { return snapshot{*this}; }
+
+  void store(V v) {
+    std::unique_ptr<node> n{new node(std::move(v))};
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_retired.reserve(m_retired.size() + 1);
+    node * old = m_current.exchange(n.release(), std::memory_order_seq_cst);
+
+    // A reader which holds `old` announced this epoch or an earlier one
+    m_retired.push_back(retired_node{old, detail::rcu_global().epoch.fetch_add(1)});
+    this->collect_locked();
+  }
+
+  // Frees the old versions which no snapshot holds anymore
+  void collect() {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    this->collect_locked();
+  }
+
+  // The number of old versions not yet freed
+  std::size_t retired_count() {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_retired.size();
+  }
+
+  // Used by `apply_visitor`, visits a snapshot of the current version
+  template <typename Visitor>
+  static auto apply_visitor_impl(Visitor && visitor, const shared_variant & s)
+    -> decltype(strict_variant::apply_visitor(std::forward<Visitor>(visitor),
+                                              std::declval<const V &>())) {
+    const snapshot snap{s};
+    return strict_variant::apply_visitor(std::forward<Visitor>(visitor), snap.get());
+  }
+};
+//]
+
+} // end namespace strict_variant
+
+#undef STRICT_VARIANT_ASSERT
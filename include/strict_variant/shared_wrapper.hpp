@@ -0,0 +1,182 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * A reference counted, copy-on-write wrapper. Copies of it share one value on
+ * the heap, and const access reads the shared value. The first mutable access
+ * through a wrapper whose value is shared gives it its own copy.
+ *
+ * So copying a variant, or a tree of variants, which holds one costs a
+ * reference count increment, rather than a deep copy.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <strict_variant/variant_fwd.hpp>
+#include <strict_variant/wrapper.hpp>
+#include <type_traits>
+#include <utility>
+
+#ifdef STRICT_VARIANT_DEBUG
+#include <cassert>
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+    assert((X) && C);                                                                              \
+  } while (0)
+
+#else // STRICT_VARIANT_DEBUG
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+  } while (0)
+
+#endif // STRICT_VARIANT_DEBUG
+
+namespace strict_variant {
+namespace detail {
+
+/***
+ * Reference counts. A count starts at one, `release` returns true when the
+ * last reference is dropped, and `unique` is true when there is exactly one.
+ */
+class atomic_refcount {
+  std::atomic<std::size_t> m_count{1};
+
+public:
+  void add() noexcept { m_count.fetch_add(1, std::memory_order_relaxed); }
+
+  // The last owner must see every write made through the other owners
+  bool release() noexcept { return m_count.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+
+  bool unique() const noexcept { return m_count.load(std::memory_order_acquire) == 1; }
+};
+
+class plain_refcount {
+  std::size_t m_count{1};
+
+public:
+  void add() noexcept { ++m_count; }
+  bool release() noexcept { return --m_count == 0; }
+  bool unique() const noexcept { return m_count == 1; }
+};
+
+// The value, together with its count
+template <typename T, typename Count>
+struct shared_node {
+  Count count;
+  T value;
+
+  template <typename... Args>
+  explicit shared_node(Args &&... args)
+    : count()
+    , value(std::forward<Args>(args)...) {}
+};
+
+} // end namespace detail
+
+//[ strict_variant_shared_wrapper
+template <typename T, typename Count>
+class basic_shared_wrapper {
+  using node_t = detail::shared_node<T, Count>;
+  node_t * m_node;
+
+  void destroy() noexcept {
+    if (m_node && m_node->count.release()) { delete m_node; }
+  }
+
+  // Gives this wrapper its own copy of the value, if it is shared
+  void unshare() {
+    STRICT_VARIANT_ASSERT(m_node, "Bad access!");
+    if (!m_node->count.unique()) {
+      node_t * n = new node_t(static_cast<const T &>(m_node->value));
+      this->destroy();
+      m_node = n;
+    }
+  }
+
+public:
+  typedef T value_type;
+
+  ~basic_shared_wrapper() noexcept { this->destroy(); }
+
+  template <typename... Args>
+  basic_shared_wrapper(Args &&... args)
+    : m_node(new node_t(std::forward<Args>(args)...)) {}
+
+  basic_shared_wrapper(basic_shared_wrapper & rhs) noexcept
+    : basic_shared_wrapper(static_cast<const basic_shared_wrapper &>(rhs)) {}
+
+  // Shares the value
+  basic_shared_wrapper(const basic_shared_wrapper & rhs) noexcept //
+    : m_node(rhs.m_node)                                          //
+  {
+    STRICT_VARIANT_ASSERT(m_node, "Copied an empty wrapper!");
+    m_node->count.add();
+  }
+
+  // Pointer move
+  basic_shared_wrapper(basic_shared_wrapper && rhs) noexcept //
+    : m_node(rhs.m_node)                                     //
+  {
+    rhs.m_node = nullptr;
+  }
+
+  basic_shared_wrapper & operator=(const basic_shared_wrapper &) = delete;
+  basic_shared_wrapper & operator=(basic_shared_wrapper &&) = delete;
+
+  // Whether no other wrapper shares the value
+  bool unique() const noexcept {
+    STRICT_VARIANT_ASSERT(m_node, "Bad access!");
+    return m_node->count.unique();
+  }
+
+  // Mutable access copies the value first, if it is shared, and may throw.
+  // This includes visiting a non-const variant, even with a visitor which only
+  // reads, so visit a const variant to read a shared value.
+  T & get() & {
+    this->unshare();
+    return m_node->value;
+  }
+  const T & get() const & {
+    STRICT_VARIANT_ASSERT(m_node, "Bad access!");
+    return m_node->value;
+  }
+  T && get() && {
+    this->unshare();
+    return std::move(m_node->value);
+  }
+};
+
+/***
+ * Shared wrapper whose reference count is atomic, so that copies may be used
+ * and destroyed on different threads.
+ */
+template <typename T>
+using shared_wrapper = basic_shared_wrapper<T, detail::atomic_refcount>;
+
+/***
+ * Shared wrapper whose reference count is not atomic. All copies must be used
+ * on one thread.
+ */
+template <typename T>
+using local_shared_wrapper = basic_shared_wrapper<T, detail::plain_refcount>;
+//]
+
+namespace detail {
+
+template <typename T, typename Count>
+struct is_wrapper<basic_shared_wrapper<T, Count>> : std::true_type {};
+
+template <typename T, typename Count>
+struct is_shared_wrapper<basic_shared_wrapper<T, Count>> : std::true_type {};
+
+} // end namespace detail
+
+} // end namespace strict_variant
+
+#undef STRICT_VARIANT_ASSERT
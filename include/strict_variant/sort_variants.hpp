@@ -0,0 +1,379 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Sorting, deduplicating and searching a range of variants, in the order of
+ * `variant_comparator`.
+ *
+ * That order sorts by `which` first, so a sorted range is a sequence of runs,
+ * one per type. `sort_variants` first moves each element into the run of its
+ * type, in one counting pass, and then sorts each run with a comparator for
+ * that one type, so that comparisons neither test nor dispatch on `which`.
+ * Runs of integers and floating point numbers compared with `std::less` are
+ * radix sorted. `unique_variants` and `lower_bound_variants` dispatch once per
+ * run, or once per search.
+ */
+
+#include <strict_variant/mpl/std_traits.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_compare.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace strict_variant {
+namespace detail {
+
+template <typename V>
+struct sort_num_types;
+
+template <typename... Types>
+struct sort_num_types<variant<Types...>> {
+  static constexpr unsigned int value = sizeof...(Types);
+};
+
+// Visitors here are dispatched on the first element of a run, and read the
+// other elements as the same type.
+template <typename V>
+using sort_dispatcher_t = visitor_dispatch<true_, sort_num_types<V>::value,
+                                           typename dispatch_strategy<V>::type>;
+
+template <typename V, typename Visitor>
+void
+dispatch_run(V & v, Visitor && visitor) {
+  using var_t = mpl::remove_const_t<V>;
+  sort_dispatcher_t<var_t>{}(static_cast<unsigned int>(v.which()), var_t::storage_impl(v), visitor);
+}
+
+template <typename T, typename V>
+T &
+run_value(V & v) noexcept {
+  return same_type_value<T>(V::storage_impl(v));
+}
+
+template <typename T, typename V>
+const T &
+run_value(const V & v) noexcept {
+  return same_type_value<T>(V::storage_impl(v));
+}
+
+/***
+ * Moves each element of [first, last) into the run of its type, and writes the
+ * start of each run to `starts`, which has one more entry than there are types.
+ * Each element is swapped at most once into its place.
+ */
+template <typename RandomIt>
+void
+partition_by_which(RandomIt first, RandomIt last, std::vector<std::size_t> & starts) {
+  using var_t = typename std::iterator_traits<RandomIt>::value_type;
+  constexpr std::size_t num_types = sort_num_types<var_t>::value;
+
+  starts.assign(num_types + 1, 0);
+  for (RandomIt it = first; it != last; ++it) {
+    ++starts[static_cast<std::size_t>(it->which()) + 1];
+  }
+  for (std::size_t i = 0; i < num_types; ++i) {
+    starts[i + 1] += starts[i];
+  }
+
+  std::vector<std::size_t> next(starts.begin(), starts.end() - 1);
+  for (std::size_t b = 0; b < num_types; ++b) {
+    while (next[b] < starts[b + 1]) {
+      const std::size_t w = static_cast<std::size_t>(first[next[b]].which());
+      if (w == b) {
+        ++next[b];
+      } else {
+        std::iter_swap(first + static_cast<std::ptrdiff_t>(next[b]),
+                       first + static_cast<std::ptrdiff_t>(next[w]));
+        ++next[w];
+      }
+    }
+  }
+}
+
+/***
+ * Radix sort keys: an unsigned integer of the same size as a value, whose order
+ * is that of the values under `std::less`.
+ */
+template <std::size_t size>
+struct radix_key;
+
+template <>
+struct radix_key<1> {
+  using type = std::uint8_t;
+};
+template <>
+struct radix_key<2> {
+  using type = std::uint16_t;
+};
+template <>
+struct radix_key<4> {
+  using type = std::uint32_t;
+};
+template <>
+struct radix_key<8> {
+  using type = std::uint64_t;
+};
+
+template <typename U>
+struct is_radix_sortable
+  : std::integral_constant<bool, ((std::is_integral<U>::value && !std::is_same<U, bool>::value)
+                                  || (std::is_floating_point<U>::value
+                                      && std::numeric_limits<U>::is_iec559))
+                                   && (sizeof(U) == 1 || sizeof(U) == 2 || sizeof(U) == 4
+                                       || sizeof(U) == 8)> {};
+
+template <typename U>
+struct radix_codec {
+  using key_t = typename radix_key<sizeof(U)>::type;
+  static constexpr key_t top = static_cast<key_t>(key_t{1} << (8 * sizeof(U) - 1));
+
+  // Integers: flip the sign bit if signed. Floats: flip every bit of a negative
+  // number, and the sign bit of a positive one.
+  static key_t encode(U u) noexcept {
+    key_t k;
+    std::memcpy(&k, &u, sizeof(U));
+    if (std::is_floating_point<U>::value) {
+      return static_cast<key_t>(k ^ ((k & top) ? static_cast<key_t>(~key_t{0}) : top));
+    }
+    return std::is_signed<U>::value ? static_cast<key_t>(k ^ top) : k;
+  }
+
+  static U decode(key_t k) noexcept {
+    if (std::is_floating_point<U>::value) {
+      k = static_cast<key_t>(k ^ ((k & top) ? top : static_cast<key_t>(~key_t{0})));
+    } else if (std::is_signed<U>::value) {
+      k = static_cast<key_t>(k ^ top);
+    }
+    U u;
+    std::memcpy(&u, &k, sizeof(U));
+    return u;
+  }
+};
+
+// Least significant digit first, a byte at a time, skipping bytes which are
+// the same in every key.
+template <typename K>
+void
+radix_sort_keys(std::vector<K> & keys, std::vector<K> & buffer) {
+  const std::size_t n = keys.size();
+  buffer.resize(n);
+  for (unsigned shift = 0; shift < 8 * sizeof(K); shift += 8) {
+    std::size_t counts[256] = {};
+    for (std::size_t i = 0; i < n; ++i) {
+      ++counts[(keys[i] >> shift) & 0xff];
+    }
+    if (counts[(keys[0] >> shift) & 0xff] == n) { continue; }
+
+    std::size_t total = 0;
+    for (std::size_t d = 0; d < 256; ++d) {
+      const std::size_t c = counts[d];
+      counts[d] = total;
+      total += c;
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      buffer[counts[(keys[i] >> shift) & 0xff]++] = keys[i];
+    }
+    keys.swap(buffer);
+  }
+}
+
+// Below this, a run is sorted with std::sort even if it could be radix sorted
+static constexpr std::size_t radix_sort_threshold = 256;
+
+// Sorts a run of elements which all hold a T
+template <typename RandomIt, template <typename> class ComparatorTemplate>
+struct run_sorter {
+  RandomIt first;
+  RandomIt last;
+
+  using var_t = typename std::iterator_traits<RandomIt>::value_type;
+
+  template <typename T>
+  struct less {
+    bool operator()(const var_t & a, const var_t & b) const {
+      ComparatorTemplate<unwrap_type_t<T>> c;
+      return c(pierce_wrapper(run_value<T>(a)), pierce_wrapper(run_value<T>(b)));
+    }
+  };
+
+  template <typename T>
+  using use_radix = std::integral_constant<bool, is_radix_sortable<T>::value
+                                                   && std::is_same<ComparatorTemplate<T>,
+                                                                   std::less<T>>::value>;
+
+  template <typename T>
+  void operator()(T &) const {
+    this->sort_run(static_cast<T *>(nullptr), use_radix<T>{});
+  }
+
+  template <typename T>
+  void sort_run(T *, std::false_type) const {
+    std::sort(first, last, less<T>{});
+  }
+
+  // The elements differ only in their values, so those are sorted by
+  // themselves and written back
+  template <typename T>
+  void sort_run(T *, std::true_type) const {
+    const std::size_t n = static_cast<std::size_t>(last - first);
+    if (n < radix_sort_threshold) {
+      this->sort_run(static_cast<T *>(nullptr), std::false_type{});
+      return;
+    }
+
+    using codec = radix_codec<T>;
+    std::vector<typename codec::key_t> keys(n);
+    std::vector<typename codec::key_t> buffer;
+    for (std::size_t i = 0; i < n; ++i) {
+      keys[i] = codec::encode(run_value<T>(first[i]));
+    }
+    radix_sort_keys(keys, buffer);
+    for (std::size_t i = 0; i < n; ++i) {
+      run_value<T>(first[i]) = codec::decode(keys[i]);
+    }
+  }
+};
+
+// Removes the consecutive duplicates from a run of elements which all hold a
+// T, moving the rest down to `out`
+template <typename RandomIt>
+struct run_deduplicator {
+  RandomIt first;
+  RandomIt last;
+  RandomIt & out;
+
+  template <typename T>
+  void operator()(T &) const {
+    RandomIt kept = out;
+    if (out != first) { *out = std::move(*first); }
+    ++out;
+    for (RandomIt it = first + 1; it != last; ++it) {
+      if (!value_equal<T>::equal(run_value<T>(*kept), run_value<T>(*it))) {
+        if (out != it) { *out = std::move(*it); }
+        kept = out;
+        ++out;
+      }
+    }
+  }
+};
+
+// Finds the first element which is not less than `value`, with one binary
+// search, in which elements of the type of `value` are compared as that type
+template <typename RandomIt, template <typename> class ComparatorTemplate>
+struct run_searcher {
+  RandomIt first;
+  RandomIt last;
+  RandomIt & result;
+
+  using var_t = typename std::iterator_traits<RandomIt>::value_type;
+
+  template <typename T>
+  struct less_than_value {
+    int which;
+    const T & value;
+
+    bool operator()(const var_t & e) const {
+      ComparatorTemplate<unwrap_type_t<T>> c;
+      const int w = e.which();
+      return w < which
+             || (w == which && c(pierce_wrapper(run_value<T>(e)), pierce_wrapper(value)));
+    }
+  };
+
+  const var_t & value;
+
+  template <typename T>
+  void operator()(const T & t) const {
+    result = std::partition_point(first, last, less_than_value<T>{value.which(), t});
+  }
+};
+
+} // end namespace detail
+
+//[ strict_variant_sort_variants
+/***
+ * Sorts the variants in [first, last) in the order of `variant_comparator`,
+ * by first grouping them by `which`, and then sorting each group by value.
+ * RandomIt must be a random access iterator over variants.
+ */
+template <typename RandomIt, typename... Ts, template <typename> class ComparatorTemplate>
+void
+sort_variants(RandomIt first, RandomIt last,
+              variant_comparator<variant<Ts...>, ComparatorTemplate, std::less<int>>) {
+  static_assert(
+    std::is_same<typename std::iterator_traits<RandomIt>::value_type, variant<Ts...>>::value,
+    "The comparator must be for the variant type of the range");
+
+  std::vector<std::size_t> starts;
+  detail::partition_by_which(first, last, starts);
+  for (std::size_t b = 0; b < sizeof...(Ts); ++b) {
+    if (starts[b + 1] - starts[b] < 2) { continue; }
+    const RandomIt run = first + static_cast<std::ptrdiff_t>(starts[b]);
+    const RandomIt run_end = first + static_cast<std::ptrdiff_t>(starts[b + 1]);
+    detail::dispatch_run(*run, detail::run_sorter<RandomIt, ComparatorTemplate>{run, run_end});
+  }
+}
+
+template <typename RandomIt>
+void
+sort_variants(RandomIt first, RandomIt last) {
+  sort_variants(first, last,
+                variant_comparator<typename std::iterator_traits<RandomIt>::value_type>{});
+}
+
+/***
+ * Removes consecutive equal variants from [first, last), like `std::unique`
+ * with `operator==`, and returns the new end. Equal values are compared with
+ * one dispatch per run of variants of the same type.
+ */
+template <typename RandomIt>
+RandomIt
+unique_variants(RandomIt first, RandomIt last) {
+  RandomIt out = first;
+  while (first != last) {
+    const int w = first->which();
+    RandomIt run_end = first + 1;
+    while (run_end != last && run_end->which() == w) {
+      ++run_end;
+    }
+    detail::dispatch_run(*first, detail::run_deduplicator<RandomIt>{first, run_end, out});
+    first = run_end;
+  }
+  return out;
+}
+
+/***
+ * Returns the first variant in [first, last) which is not less than `value`,
+ * like `std::lower_bound` with `variant_comparator`. The range must be sorted
+ * in that order, e.g. by `sort_variants`.
+ */
+template <typename RandomIt, typename... Ts, template <typename> class ComparatorTemplate>
+RandomIt
+lower_bound_variants(RandomIt first, RandomIt last, const variant<Ts...> & value,
+                     variant_comparator<variant<Ts...>, ComparatorTemplate, std::less<int>>) {
+  RandomIt result = first;
+  using searcher_t = detail::run_searcher<RandomIt, ComparatorTemplate>;
+  detail::dispatch_run(value, searcher_t{first, last, result, value});
+  return result;
+}
+
+template <typename RandomIt, typename... Ts>
+RandomIt
+lower_bound_variants(RandomIt first, RandomIt last, const variant<Ts...> & value) {
+  return lower_bound_variants(first, last, value, variant_comparator<variant<Ts...>>{});
+}
+//]
+
+} // end namespace strict_variant
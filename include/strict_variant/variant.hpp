@@ -28,11 +28,13 @@
 #include <strict_variant/mpl/ulist.hpp>
 #include <strict_variant/recursive_wrapper.hpp>
 #include <strict_variant/safely_constructible.hpp>
+#include <strict_variant/variant_base.hpp>
 #include <strict_variant/variant_detail.hpp>
 #include <strict_variant/variant_dispatch.hpp>
 #include <strict_variant/variant_fwd.hpp>
 #include <strict_variant/variant_storage.hpp>
 
+#include <cstring>
 #include <type_traits>
 #include <utility>
 
@@ -77,7 +79,7 @@ struct emplace_tag {};
  * Class variant
  */
 template <typename First, typename... Types>
-class variant {
+class variant : public detail::variant_layers_t<First, Types...> {
 
 private:
   /***
@@ -97,99 +99,27 @@ private:
                 "Cannot store references in this variant, use `std::reference_wrapper`");
 
   /***
-   * Data members
+   * Data members and special member functions live in the base
    */
+  using base_t = detail::variant_layers_t<First, Types...>;
 
-  using storage_t = detail::storage<First, Types...>;
-  storage_t m_storage;
+  using typename base_t::storage_t;
+  using typename base_t::which_t;
 
-  int m_which;
+  using base_t::m_storage;
+  using base_t::get_which;
 
-  /***
-   * Initialize and destroy
-   */
-  void destroy() noexcept {
-    destroyer d;
-    this->apply_visitor_internal(d);
-  }
-
-  template <std::size_t index, typename... Args>
-  void initialize(Args &&... args) noexcept(
-    noexcept(static_cast<storage_t *>(nullptr)->template initialize<index>(
-      std::forward<Args>(std::declval<Args>())...))) {
-    m_storage.template initialize<index>(std::forward<Args>(args)...);
-    this->m_which = static_cast<int>(index);
-  }
-
-  /***
-   * (Type-changing) Assignment
-   */
-  template <std::size_t index, typename Rhs>
-  void assign(Rhs && rhs) {
-    constexpr bool assume_nothrow_init =
-      std::is_lvalue_reference<Rhs>::value
-        ? detail::variant_noexcept_helper<First, Types...>::assume_copy_nothrow
-        : detail::variant_noexcept_helper<First, Types...>::assume_move_nothrow;
-
-    // This is a recursive_wrapper if that is what storage is using internally
-    using temp_t = typename storage_t::template value_t<index>;
-
-    // Three cases:
-    // 1) Already had an RHS type in the variant. Use assignment directly. Must pierce
-    // recursive_wrapper.
-    // 2) Must change type, but initializing the new value is noexcept. Can destroy and do it
-    // directly.
-    // 3) Must change type, and initializing the new value may throw. Do it on the stack, and then
-    // move into storage.
-
-    static_assert(noexcept(this->destroy()), "Noexcept assumption failed!");
-
-    if (this->which() == index) {
-      m_storage.template get_value<index>(detail::false_{}) = std::forward<Rhs>(rhs);
-    } else if (assume_nothrow_init || noexcept(this->initialize<index>(std::forward<Rhs>(rhs)))) {
-      this->destroy();
-      this->initialize<index>(std::forward<Rhs>(rhs));
-    } else {
-      static_assert(detail::variant_noexcept_helper<First, Types...>::assume_move_nothrow
-                      || noexcept(this->initialize<index>(std::declval<temp_t>())),
-                    "Noexcept assumption failed!");
-
-      temp_t tmp(std::forward<Rhs>(rhs));      // may throw
-      this->destroy();                         // nothrow
-      this->initialize<index>(std::move(tmp)); // nothrow
-    }
-  }
-
-  /***
-   * Used for internal visitors
-   */
-  template <typename Visitor>
-  auto apply_visitor_internal(Visitor & visitor) -> typename Visitor::result_type {
-    // Implementation note:
-    // `detail::true_` here indicates that the visit is internal and we should
-    // NOT pierce `recursive_wrapper`.
-    return detail::visitor_dispatch<detail::true_, 1 + sizeof...(Types)>{}(m_which, m_storage,
-                                                                           visitor);
-  }
+  using base_t::destroy;
+  using base_t::initialize;
+  using base_t::assign;
+  using base_t::apply_visitor_internal;
 
-  /***
-   * find_which is used with non-T&& ctors to figure out what "which" should be
-   * used for a given type
-   */
   template <typename Rhs>
-  struct find_which {
-    static constexpr std::size_t value =
-      mpl::Find_With<detail::same_modulo_const_ref_wrapper<Rhs>::template prop, First,
-                     Types...>::value;
-    static_assert(value < (sizeof...(Types) + 1), "No match for value");
-  };
+  using find_which = typename base_t::template find_which<Rhs>;
 
   /***
-   * Visitors used to implement special member functions and such
+   * Visitors used to implement swap
    */
-  struct constructor;
-  struct assigner;
-  struct destroyer;
   struct swapper;
 
   /***
@@ -242,22 +172,19 @@ private:
   }
 
 public:
-  ~variant() noexcept { this->destroy(); }
+  // Special member functions are implemented by the layers in `variant_base.hpp`.
+  // Each is trivial when the corresponding operation is trivial for all of the
+  // value types. Otherwise its noexcept status is given by `variant_noexcept_helper`,
+  // which handles recursive_wrapper<T> specially.
+  ~variant() = default;
+  variant(const variant &) = default;
+  variant(variant &&) = default;
+  variant & operator=(const variant &) = default;
+  variant & operator=(variant &&) = default;
 
   // Constructors
-  // Note: We use detail:: instead of std:: for trait because we handle
-  // recursive_wrapper<T> specially
-  // TODO: It would be nice if we actually SFINAED the definitions of these
-  // special member functions, following akrzemi1's technical description:
-  // https://akrzemi1.wordpress.com/2015/03/02/a-conditional-copy-constructor/
   variant() noexcept(detail::is_nothrow_default_constructible<First>::value);
 
-  variant(const variant & rhs) noexcept(
-    detail::variant_noexcept_helper<First, Types...>::nothrow_copy_ctors);
-
-  variant(variant && rhs) noexcept(
-    detail::variant_noexcept_helper<First, Types...>::nothrow_move_ctors);
-
   /// Forwarding-reference ctor, construct a variant from one of its value
   /// types, using overload resolution. See documentation.
   template <typename T,
@@ -292,13 +219,6 @@ public:
    * Modifiers
    */
 
-  // Assignment
-  variant & operator=(const variant & rhs) noexcept(
-    detail::variant_noexcept_helper<First, Types...>::nothrow_copy_assign);
-
-  variant & operator=(variant && rhs) noexcept(
-    detail::variant_noexcept_helper<First, Types...>::nothrow_move_assign);
-
   // Forwarding reference assignment
   template <typename T,
             typename =
@@ -348,7 +268,7 @@ public:
    * Accessors
    */
 
-  int which() const noexcept { return m_which; }
+  int which() const noexcept { return static_cast<int>(this->get_which()); }
 
   // get
   template <typename T>
@@ -373,7 +293,7 @@ public:
   template <std::size_t idx>
   auto get() noexcept
     -> decltype(&static_cast<storage_t *>(nullptr)->template get_value<idx>(detail::false_{})) {
-    if (idx == m_which) {
+    if (idx == this->get_which()) {
       return &m_storage.template get_value<idx>(detail::false_{});
     } else {
       return nullptr;
@@ -383,7 +303,7 @@ public:
   template <std::size_t idx>
   auto get() const noexcept -> decltype(
     &static_cast<const storage_t *>(nullptr)->template get_value<idx>(detail::false_{})) {
-    if (idx == m_which) {
+    if (idx == this->get_which()) {
       return &m_storage.template get_value<idx>(detail::false_{});
     } else {
       return nullptr;
@@ -396,14 +316,17 @@ public:
 
   // Implementation details for apply_visitor
   // private:
-  using dispatcher_t = detail::visitor_dispatch<detail::false_, 1 + sizeof...(Types)>;
+  template <typename Strategy>
+  using dispatcher_t = detail::visitor_dispatch<detail::false_, 1 + sizeof...(Types), Strategy>;
 
 #define APPLY_VISITOR_IMPL_BODY                                                                    \
-  dispatcher_t{}(visitable.which(), std::forward<Visitable>(visitable).m_storage,                  \
-                 std::forward<Visitor>(visitor))
+  dispatcher_t<Strategy>{}(visitable.which(), std::forward<Visitable>(visitable).m_storage,        \
+                           std::forward<Visitor>(visitor))
 
   // Visitable is assumed to be, forwarding reference to this type.
-  template <typename Visitor, typename Visitable>
+  // Strategy is one of the tags in `strict_variant::dispatch`.
+  template <typename Strategy = typename dispatch_strategy<variant>::type, typename Visitor,
+            typename Visitable>
   static auto apply_visitor_impl(Visitor && visitor,
                                  Visitable && visitable) noexcept(noexcept(APPLY_VISITOR_IMPL_BODY))
     -> decltype(APPLY_VISITOR_IMPL_BODY) {
@@ -414,6 +337,16 @@ public:
 
 #undef APPLY_VISITOR_IMPL_BODY
 
+  // Implementation details for multivisitation
+  // Gives access to the storage, with the same value category as visitable.
+  template <typename Visitable>
+  static auto storage_impl(Visitable && visitable) noexcept
+    -> decltype((std::forward<Visitable>(visitable).m_storage)) {
+    static_assert(std::is_same<const variant, const mpl::remove_reference_t<Visitable>>::value,
+                  "Misuse of storage_impl!");
+    return std::forward<Visitable>(visitable).m_storage;
+  }
+
   // public:
   // C++17 visit syntax
   template <typename V>
@@ -455,6 +388,25 @@ apply_visitor(Visitor && visitor, Visitable && visitable) noexcept(noexcept(APPL
 
 #undef APPLY_VISITOR_BODY
 
+/***
+ * apply one visitor function, using a particular dispatch strategy
+ * rather than the default for the variant type.
+ *
+ *   strict_variant::apply_visitor_with<strict_variant::dispatch::jump_table>(vis, v);
+ */
+#define APPLY_VISITOR_WITH_BODY                                                                    \
+  mpl::remove_reference_t<Visitable>::template apply_visitor_impl<Strategy>(                       \
+    std::forward<Visitor>(visitor), std::forward<Visitable>(visitable))
+template <typename Strategy, typename Visitor, typename Visitable>
+auto
+apply_visitor_with(Visitor && visitor,
+                   Visitable && visitable) noexcept(noexcept(APPLY_VISITOR_WITH_BODY))
+  -> decltype(APPLY_VISITOR_WITH_BODY) {
+  return APPLY_VISITOR_WITH_BODY;
+}
+
+#undef APPLY_VISITOR_WITH_BODY
+
 /***
  * strict_variant::get function (same semantics as boost::get with pointer type)
  */
@@ -522,58 +474,6 @@ template <typename... Ts>
 using easy_variant = variant<wrap_if_throwing_move_t<Ts>...>;
 //]
 
-/***
- * Implementation details of private visitors
- */
-template <typename First, typename... Types>
-struct variant<First, Types...>::constructor {
-  typedef void result_type;
-
-  explicit constructor(variant & self)
-    : m_self(self) {}
-
-  template <typename T>
-  void operator()(T && rhs) const {
-    constexpr std::size_t index = find_which<mpl::remove_reference_t<T>>::value;
-    m_self.template initialize<index>(std::forward<T>(rhs));
-  }
-
-private:
-  variant & m_self;
-};
-
-// assigner
-template <typename First, typename... Types>
-struct variant<First, Types...>::assigner {
-
-  static_assert(detail::variant_noexcept_helper<First, Types...>::assignable,
-                "All types in this variant must be nothrow move constructible or placed in a "
-                "recursive_wrapper, or the variant cannot be assigned!");
-
-  explicit assigner(variant & self)
-    : m_self(self) {}
-
-  template <typename Rhs>
-  void operator()(Rhs && rhs) const {
-    constexpr std::size_t index = find_which<mpl::remove_reference_t<Rhs>>::value;
-    m_self.template assign<index>(std::forward<Rhs>(rhs));
-  }
-
-private:
-  variant & m_self;
-};
-
-// destroyer
-template <typename First, typename... Types>
-struct variant<First, Types...>::destroyer {
-  typedef void result_type;
-
-  template <typename T>
-  void operator()(T & t) const noexcept {
-    t.~T();
-  }
-};
-
 /***
  * Implementation details of ctors
  */
@@ -584,65 +484,21 @@ struct variant<First, Types...>::destroyer {
 
 template <typename First, typename... Types>
 variant<First, Types...>::variant() noexcept(
-  detail::is_nothrow_default_constructible<First>::value) {
+  detail::is_nothrow_default_constructible<First>::value)
+  : base_t(detail::init_index_tag<0>{}) {
   static_assert(std::is_default_constructible<First>::value,
                 "First type must be default constructible or variant is not!");
-  this->initialize<0>();
-  STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
-}
-
-// Special member functions
-template <typename First, typename... Types>
-variant<First, Types...>::variant(const variant & rhs) noexcept(
-  detail::variant_noexcept_helper<First, Types...>::nothrow_copy_ctors) {
-  constructor c(*this);
-  apply_visitor(c, rhs);
-  STRICT_VARIANT_ASSERT(rhs.which() == this->which(), "Postcondition failed!");
   STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
 }
 
-// Note: noexcept is enforced by static_assert in move_constructor visitor
-template <typename First, typename... Types>
-variant<First, Types...>::variant(variant && rhs) noexcept(
-  detail::variant_noexcept_helper<First, Types...>::nothrow_move_ctors) {
-  constructor mc(*this);
-  apply_visitor(mc, std::move(rhs));
-  STRICT_VARIANT_ASSERT(rhs.which() == this->which(), "Postcondition failed!");
-  STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
-}
-
-template <typename First, typename... Types>
-variant<First, Types...> &
-variant<First, Types...>::operator=(const variant & rhs) noexcept(
-  detail::variant_noexcept_helper<First, Types...>::nothrow_copy_assign) {
-  assigner a(*this);
-  apply_visitor(a, rhs);
-  STRICT_VARIANT_ASSERT(rhs.which() == this->which(), "Postcondition failed!");
-  STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
-  return *this;
-}
-
-// Note: We want to pierce the recursive_wrapper here, if we move it then
-template <typename First, typename... Types>
-variant<First, Types...> &
-variant<First, Types...>::operator=(variant && rhs) noexcept(
-  detail::variant_noexcept_helper<First, Types...>::nothrow_move_assign) {
-  assigner ma(*this);
-  apply_visitor(ma, std::move(rhs));
-  STRICT_VARIANT_ASSERT(rhs.which() == this->which(), "Postcondition failed!");
-  STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
-  return *this;
-}
-
 /// Forwarding-reference ctor
 template <typename First, typename... Types>
 template <typename T, typename>
-variant<First, Types...>::variant(T && t) {
+variant<First, Types...>::variant(T && t)
+  : base_t(detail::init_index_tag<initializer_slot<T>()>{}, std::forward<T>(t)) {
   static_assert(!std::is_same<variant &, mpl::remove_const_t<T>>::value,
                 "why is variant(T&&) instantiated with a variant? why was a special "
                 "member function not selected?");
-  constexpr unsigned idx = initializer_slot<T>();
-  this->initialize<idx>(std::forward<T>(t));
   STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
 }
 
@@ -653,7 +509,7 @@ template <typename T, typename>
 variant<First, Types...> &
 variant<First, Types...>::operator=(T && t) {
   constexpr unsigned idx = initializer_slot<T>();
-  this->assign<idx>(std::forward<T>(t));
+  this->template assign<idx>(std::forward<T>(t));
   return *this;
 }
 
@@ -664,9 +520,8 @@ variant<First, Types...>::operator=(T && t) {
 template <typename First, typename... Types>
 template <typename OFirst, typename... OTypes, typename Enable>
 variant<First, Types...>::variant(const variant<OFirst, OTypes...> & other) noexcept(
-  detail::variant_noexcept_helper<OFirst, OTypes...>::nothrow_copy_ctors) {
-  constructor c(*this);
-  apply_visitor(c, other);
+  detail::variant_noexcept_helper<OFirst, OTypes...>::nothrow_copy_ctors)
+  : base_t(detail::init_visit_tag{}, other) {
   STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
 }
 
@@ -674,9 +529,8 @@ variant<First, Types...>::variant(const variant<OFirst, OTypes...> & other) noex
 template <typename First, typename... Types>
 template <typename OFirst, typename... OTypes, typename Enable>
 variant<First, Types...>::variant(variant<OFirst, OTypes...> && other) noexcept(
-  detail::variant_noexcept_helper<OFirst, OTypes...>::nothrow_move_ctors) {
-  constructor c(*this);
-  apply_visitor(c, std::move(other));
+  detail::variant_noexcept_helper<OFirst, OTypes...>::nothrow_move_ctors)
+  : base_t(detail::init_visit_tag{}, std::move(other)) {
   STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
 }
 
@@ -686,7 +540,7 @@ template <typename OFirst, typename... OTypes, typename Enable>
 variant<First, Types...> &
 variant<First, Types...>::operator=(const variant<OFirst, OTypes...> & other) noexcept(
   detail::variant_noexcept_helper<OFirst, OTypes...>::nothrow_copy_assign) {
-  assigner a(*this);
+  typename base_t::assigner a(*this);
   apply_visitor(a, other);
   STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
   return *this;
@@ -697,7 +551,7 @@ template <typename OFirst, typename... OTypes, typename Enable>
 variant<First, Types...> &
 variant<First, Types...>::operator=(variant<OFirst, OTypes...> && other) noexcept(
   detail::variant_noexcept_helper<OFirst, OTypes...>::nothrow_move_assign) {
-  assigner a(*this);
+  typename base_t::assigner a(*this);
   apply_visitor(a, std::move(other));
   STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
   return *this;
@@ -708,11 +562,9 @@ variant<First, Types...>::operator=(variant<OFirst, OTypes...> && other) noexcep
 template <typename First, typename... Types>
 template <typename T, typename... Args>
 variant<First, Types...>::variant(emplace_tag<T>, Args &&... args) noexcept(
-  std::is_nothrow_constructible<T, Args...>::value) {
-  constexpr std::size_t idx = find_which<T>::value;
-  static_assert(idx < sizeof...(Types) + 1, "Requested type is not a member of this variant type");
-
-  this->initialize<idx>(std::forward<Args>(args)...);
+  std::is_nothrow_constructible<T, Args...>::value)
+  : base_t(detail::init_index_tag<find_which<T>::value>{}, std::forward<Args>(args)...) {
+  STRICT_VARIANT_ASSERT_WHICH_INVARIANT;
 }
 
 // Emplace operation
@@ -722,7 +574,8 @@ variant<First, Types...>::variant(emplace_tag<T>, Args &&... args) noexcept(
 // There are two overloads:
 //   when the invoked constructor is noexcept, we destroy the current value
 //     and reinitialize in-place.
-//   when the invoked constructor is not noexcept, we use a move for safety.
+//   when the invoked constructor is not noexcept, we use a move for safety,
+//     unless we have `blank` to fall back to (see `variant_base::replace`).
 template <typename First, typename... Types>
 template <std::size_t idx, typename... Args>
 auto
@@ -730,11 +583,11 @@ variant<First, Types...>::emplace(Args &&... args) noexcept(false)
   -> mpl::enable_if_t<!std::is_nothrow_constructible<typename storage_t::template value_t<idx>,
                                                      Args...>::value> {
   using temp_t = typename storage_t::template value_t<idx>;
-  static_assert(
-    std::is_nothrow_move_constructible<temp_t>::value,
-    "To use emplace, either the invoked ctor or the move ctor of value type must be noexcept.");
-  temp_t temp(std::forward<Args>(args)...);
-  this->emplace<idx>(std::move(temp));
+  static_assert(base_t::noexcept_helper::has_blank
+                  || std::is_nothrow_move_constructible<temp_t>::value,
+                "To use emplace, either the invoked ctor or the move ctor of value type must be "
+                "noexcept, or the variant must have blank.");
+  this->template replace<idx>(std::forward<Args>(args)...);
 }
 
 template <typename First, typename... Types>
@@ -744,11 +597,11 @@ variant<First, Types...>::emplace(Args &&... args) noexcept
   -> mpl::enable_if_t<std::is_nothrow_constructible<typename storage_t::template value_t<idx>,
                                                     Args...>::value> {
   static_assert(idx < sizeof...(Types) + 1, "Requested type is not a member of this variant type");
-  static_assert(noexcept(this->initialize<idx>(std::forward<Args>(args)...)),
+  static_assert(noexcept(this->template initialize<idx>(std::forward<Args>(args)...)),
                 "Noexcept assumption failed!");
 
   this->destroy();
-  this->initialize<idx>(std::forward<Args>(args)...);
+  this->template initialize<idx>(std::forward<Args>(args)...);
 }
 
 // Swap
@@ -792,17 +645,17 @@ struct variant<First, Types...>::swapper {
     // swap using a move
     template <typename U>
     void operator()(U & second_visit) const noexcept {
-      constexpr std::size_t t_idx = var_t::find_which<T>::value;
-      constexpr std::size_t u_idx = var_t::find_which<U>::value;
+      constexpr std::size_t t_idx = var_t::template find_which<T>::value;
+      constexpr std::size_t u_idx = var_t::template find_which<U>::value;
 
       STRICT_VARIANT_ASSERT(t_idx == first_var_.which(), "Bad access during swap!");
       STRICT_VARIANT_ASSERT(u_idx == second_var_.which(), "Bad access during swap!");
 
       T temp{std::move(first_visit_)};
       first_var_.destroy();
-      first_var_.initialize<u_idx>(std::move(second_visit));
+      first_var_.template initialize<u_idx>(std::move(second_visit));
       second_var_.destroy();
-      second_var_.initialize<t_idx>(std::move(temp));
+      second_var_.template initialize<t_idx>(std::move(temp));
     }
   };
 
@@ -820,47 +673,92 @@ variant<First, Types...>::swap(variant & other) noexcept {
 
 // Operator ==, !=
 
+namespace detail {
+
+/***
+ * Metafunction `is_trivially_comparable`: Whether two values are equal exactly
+ * when their bytes are, so that `operator==` of a variant compares their bytes.
+ * True for integers, enums and pointers. It may be specialized for other
+ * types, e.g. structs of those without padding.
+ */
+template <typename T>
+struct is_trivially_comparable
+  : std::integral_constant<bool, std::is_integral<T>::value || std::is_enum<T>::value
+                                   || std::is_pointer<T>::value> {};
+
+/***
+ * How `operator==` compares two values of the same type in a variant. A
+ * wrapper is pierced and its values compared, unless this is specialized for
+ * it, e.g. to compare canonical values by address.
+ */
+template <typename T, bool = is_wrapper<T>::value, bool = is_trivially_comparable<T>::value>
+struct value_equal {
+  static bool equal(const T & l, const T & r) { return l == r; }
+};
+
+template <typename T>
+struct value_equal<T, false, true> {
+  static bool equal(const T & l, const T & r) noexcept {
+    return !std::memcmp(&l, &r, sizeof(T));
+  }
+};
+
+template <typename T>
+struct value_equal<T, true, false> {
+  static bool equal(const T & l, const T & r) {
+    return value_equal<typename T::value_type>::equal(l.get(), r.get());
+  }
+};
+
+/***
+ * The value of a variant, as the type `T` held by another variant of the same
+ * type and `which` value. This lets a binary operation dispatch only once.
+ */
+template <typename T, typename Storage>
+const T &
+same_type_value(const Storage & s) noexcept {
+  return *reinterpret_cast<const T *>(s.address());
+}
+
+template <typename T, typename Storage>
+T &
+same_type_value(Storage & s) noexcept {
+  return *reinterpret_cast<T *>(s.address());
+}
+
+} // end namespace detail
+
 // equality check
-// This is essentially a multivisitor, but we do the boiler-plate manually to
-// avoid including extra stuff.
+// Both values have the same type, so we dispatch once on `lhs`, and read the
+// value of `rhs` as that type. Wrappers are not pierced, see `value_equal`.
 template <typename First, typename... Types>
 struct eq_checker {
   typedef bool result_type;
 
   using var_t = variant<First, Types...>;
+  using dispatcher_t = detail::visitor_dispatch<detail::true_, 1 + sizeof...(Types),
+                                                typename dispatch_strategy<var_t>::type>;
 
-  eq_checker(const var_t & lhs_variant)
-    : lhs_v(lhs_variant) {}
+  eq_checker(const var_t & rhs_variant)
+    : rhs_v(rhs_variant) {}
 
-  // After we've visited the first value, store it in a function object.
-  // second_visitor<T> is applied to the variant we are passed in ctor.
   template <typename T>
-  struct second_visitor {
-    const T & r;
-
-    bool operator()(const T & l) const { return l == r; }
-    template <typename U>
-    bool operator()(const U &) const {
-      STRICT_VARIANT_ASSERT(false, "Should be unreachable!");
-      return false;
-    }
-  };
-
-  template <typename Rhs>
-  bool operator()(const Rhs & rhs) const {
-    return apply_visitor(second_visitor<Rhs>{rhs}, lhs_v);
+  bool operator()(const T & lhs) const {
+    return detail::value_equal<T>::equal(lhs,
+                                         detail::same_type_value<T>(var_t::storage_impl(rhs_v)));
   }
 
 private:
-  const var_t & lhs_v;
+  const var_t & rhs_v;
 };
 
 template <typename First, typename... Types>
 inline bool
 operator==(const variant<First, Types...> & lhs, const variant<First, Types...> & rhs) {
   if (lhs.which() != rhs.which()) { return false; }
-  eq_checker<First, Types...> eq{lhs};
-  return apply_visitor(eq, rhs);
+  eq_checker<First, Types...> eq{rhs};
+  return typename eq_checker<First, Types...>::dispatcher_t{}(
+    static_cast<unsigned int>(lhs.which()), variant<First, Types...>::storage_impl(lhs), eq);
 }
 
 template <typename First, typename... Types>
@@ -0,0 +1,711 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Data members of variant, and the special member functions built on them.
+ *
+ * The special member functions are provided by a stack of "layers", each of
+ * which is specialized on whether that operation is trivial for all of the
+ * value types. `variant` then simply defaults its own special member functions,
+ * so that e.g. `variant<int, double>` is trivially copyable, and can be
+ * `memcpy`'d by `std::vector` and friends.
+ */
+
+#include <strict_variant/mpl/find_with.hpp>
+#include <strict_variant/mpl/std_traits.hpp>
+#include <strict_variant/variant_detail.hpp>
+#include <strict_variant/variant_dispatch.hpp>
+#include <strict_variant/variant_fwd.hpp>
+#include <strict_variant/variant_storage.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#ifdef STRICT_VARIANT_DEBUG
+#include <cassert>
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+    assert((X) && C);                                                                              \
+  } while (0)
+
+#else // STRICT_VARIANT_DEBUG
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+  } while (0)
+
+#endif // STRICT_VARIANT_DEBUG
+
+namespace strict_variant {
+namespace detail {
+
+/***
+ * variant_data holds the data members of variant: the storage, and the `which`
+ * value, which is either a separate integer, or kept in the spare bits of the
+ * first word of the storage (see `compact_layout`).
+ */
+template <typename Storage, typename Which, bool compact, unsigned int which_bits>
+struct variant_data {
+  using which_t = Which;
+
+  Storage m_storage;
+
+  // The discriminator is the narrowest integer type that can index our types.
+  // It is placed after the storage: `Storage` is already padded out to
+  // `Storage::m_align`, so the only padding added is the tail padding needed
+  // to round the whole variant up to that same alignment.
+  which_t m_which;
+
+  which_t get_which() const noexcept { return m_which; }
+  void set_which(which_t w) noexcept { m_which = w; }
+};
+
+template <typename Storage, typename Which, unsigned int which_bits>
+struct variant_data<Storage, Which, true, which_bits> {
+  using which_t = Which;
+
+  Storage m_storage;
+
+  static constexpr std::uintptr_t which_mask = (std::uintptr_t{1} << which_bits) - 1;
+
+  std::uintptr_t get_word() const noexcept {
+    std::uintptr_t word;
+    std::memcpy(&word, m_storage.address(), sizeof(word));
+    return word;
+  }
+
+  which_t get_which() const noexcept { return static_cast<which_t>(this->get_word() & which_mask); }
+
+  // Must be called after the value is constructed, since that overwrites the
+  // spare bits.
+  void set_which(which_t w) noexcept {
+    const std::uintptr_t word = (this->get_word() & ~which_mask) | w;
+    std::memcpy(m_storage.address(), &word, sizeof(word));
+  }
+};
+
+/***
+ * Tags used to select a constructor of variant_base
+ */
+
+// Construct the value at a particular index from some arguments
+template <std::size_t index>
+struct init_index_tag {};
+
+// Construct by visiting another variant
+struct init_visit_tag {};
+
+// Don't construct anything, the caller will initialize the storage
+struct no_init_tag {};
+
+/***
+ * variant_base holds the storage and the `which` value, and implements
+ * the operations that need to use both.
+ *
+ * Initialization happens in a constructor of this class, so that if it
+ * throws, none of the layers above (in particular the destructor) has been
+ * constructed yet.
+ */
+template <typename First, typename... Types>
+class variant_base
+  : protected variant_data<storage<First, Types...>, which_type_t<1 + sizeof...(Types)>,
+                           compact_layout<variant<First, Types...>>::value,
+                           which_bits<1 + sizeof...(Types)>::value> {
+protected:
+  static constexpr std::size_t num_types = 1 + sizeof...(Types);
+
+  using storage_t = storage<First, Types...>;
+  using noexcept_helper = variant_noexcept_helper<First, Types...>;
+
+  // Uses the dispatch strategy selected for the variant type
+  template <typename Internal, typename V = variant<First, Types...>>
+  using dispatcher_t = visitor_dispatch<Internal, num_types, typename dispatch_strategy<V>::type>;
+
+  /***
+   * Data members live in variant_data
+   */
+  static constexpr bool compact = compact_layout<variant<First, Types...>>::value;
+
+  static_assert(!compact || can_compact<First, Types...>::value,
+                "compact_layout requires that every type has enough spare_bits for the which "
+                "value, and is at least pointer-sized!");
+
+  using data_t =
+    variant_data<storage_t, which_type_t<num_types>, compact, which_bits<num_types>::value>;
+
+  /***
+   * Moves of this variant type move wrappers by pointer, see `pointer_move`
+   */
+  static constexpr bool pointer_move = strict_variant::pointer_move<variant<First, Types...>>::value;
+
+  using fallback = extract_fallback<First, Types...>;
+
+  static_assert(!pointer_move || fallback::found,
+                "pointer_move requires a type which is not wrapped and is nothrow default "
+                "constructible, for a moved-from variant to be left holding.");
+
+  static constexpr bool nothrow_move_ctor = pointer_move
+                                              ? noexcept_helper::nothrow_pointer_move_ctors
+                                              : noexcept_helper::nothrow_move_ctors;
+
+  static constexpr bool nothrow_move_assign = pointer_move
+                                                ? noexcept_helper::nothrow_pointer_move_assign
+                                                : noexcept_helper::nothrow_move_assign;
+
+  using typename data_t::which_t;
+  using data_t::m_storage;
+  using data_t::get_which;
+  using data_t::set_which;
+
+  /***
+   * find_which is used with non-T&& ctors to figure out what "which" should be
+   * used for a given type
+   */
+  template <typename Rhs>
+  struct find_which : detail::find_which<Rhs, First, Types...> {};
+
+  /***
+   * Visitors used to implement special member functions and such
+   */
+  struct constructor;
+  struct assigner;
+  struct destroyer;
+  struct copy_assigner;
+  struct move_constructor;
+  struct move_assigner;
+  struct pointer_constructor;
+  struct pointer_assigner;
+
+  /***
+   * Initialize and destroy
+   */
+  void destroy() noexcept {
+    destroyer d;
+    this->apply_visitor_internal(d);
+  }
+
+  template <std::size_t index, typename... Args>
+  void initialize(Args &&... args) noexcept(
+    noexcept(static_cast<storage_t *>(nullptr)->template initialize<index>(
+      std::forward<Args>(std::declval<Args>())...))) {
+    m_storage.template initialize<index>(std::forward<Args>(args)...);
+    this->set_which(static_cast<which_t>(index));
+  }
+
+  // Used when a wrapper has been moved out of this variant by pointer
+  void reset_to_fallback() noexcept {
+    this->destroy();
+    this->template initialize<fallback::value>();
+  }
+
+  /***
+   * (Type-changing) Assignment
+   */
+  template <std::size_t index, typename Rhs>
+  void assign(Rhs && rhs) {
+    constexpr bool assume_nothrow_init = std::is_lvalue_reference<Rhs>::value
+                                           ? noexcept_helper::assume_copy_nothrow
+                                           : noexcept_helper::assume_move_nothrow;
+
+    // Three cases:
+    // 1) Already had an RHS type in the variant. Use assignment directly. Must pierce
+    // recursive_wrapper. (But not a shared wrapper, whose value is replaced, not assigned to.)
+    // 2) Must change type, but initializing the new value is noexcept. Can destroy and do it
+    // directly.
+    // 3) Must change type, and initializing the new value may throw. See `replace`.
+
+    static_assert(noexcept(this->destroy()), "Noexcept assumption failed!");
+
+    using value_t = typename storage_t::template value_t<index>;
+
+    if (!is_shared_wrapper<value_t>::value
+        && static_cast<std::size_t>(this->get_which()) == index) {
+      m_storage.template get_value<index>(false_{}) = std::forward<Rhs>(rhs);
+    } else if (assume_nothrow_init
+               || noexcept(this->template initialize<index>(std::forward<Rhs>(rhs)))) {
+      this->destroy();
+      this->template initialize<index>(std::forward<Rhs>(rhs));
+    } else {
+      this->template replace<index>(std::forward<Rhs>(rhs));
+    }
+  }
+
+  /***
+   * Replace the value with one whose construction may throw.
+   *
+   * Normally, construct it on the stack, and then move it into storage, so
+   * that if it throws, the old value is untouched. The arguments may refer to
+   * the old value, for instance to a child of it.
+   *
+   * If the new value's move may throw, and we have `blank`, destroy the old
+   * value and construct the new one in place instead, leaving `blank` if that
+   * throws. Then the arguments must not refer to the old value.
+   */
+  template <std::size_t index, typename... Args>
+  void replace(Args &&... args) {
+    using temp_t = typename storage_t::template value_t<index>;
+
+    constexpr bool in_place =
+      noexcept_helper::has_blank && !noexcept_helper::assume_move_nothrow
+      && !noexcept(static_cast<variant_base *>(nullptr)->template initialize<index>(
+           std::declval<temp_t>()));
+
+    this->template replace<index>(std::integral_constant<bool, in_place>{},
+                                  std::forward<Args>(args)...);
+  }
+
+  template <std::size_t index, typename... Args>
+  void replace(std::false_type, Args &&... args) {
+    // This is a recursive_wrapper if that is what storage is using internally
+    using temp_t = typename storage_t::template value_t<index>;
+
+    static_assert(noexcept_helper::assume_move_nothrow
+                    || noexcept(this->template initialize<index>(std::declval<temp_t>())),
+                  "Noexcept assumption failed!");
+
+    temp_t tmp(std::forward<Args>(args)...);          // may throw
+    this->destroy();                                  // nothrow
+    this->template initialize<index>(std::move(tmp)); // nothrow
+  }
+
+  template <std::size_t index, typename... Args>
+  void replace(std::true_type, Args &&... args) {
+    this->destroy();                                                  // nothrow
+    this->template initialize<blank_index<First, Types...>::value>(); // nothrow
+    this->template initialize<index>(std::forward<Args>(args)...);    // may throw
+  }
+
+  /***
+   * Used for internal visitors
+   */
+  template <typename Visitor>
+  auto apply_visitor_internal(Visitor & visitor) -> typename Visitor::result_type {
+    // Implementation note:
+    // `true_` here indicates that the visit is internal and we should
+    // NOT pierce `recursive_wrapper`.
+    return dispatcher_t<true_>{}(this->get_which(), m_storage, visitor);
+  }
+
+  /***
+   * Implementations of the non-trivial special member functions.
+   * Note that we pierce `recursive_wrapper` in the rhs, see ImplementationNotes.
+   */
+  // The copy ctor does not pierce, so that wrappers are copied by their own
+  // copy ctors. (An `alloc_wrapper` copies its allocator this way.)
+  void copy_construct(const variant_base & rhs) {
+    constructor c(*this);
+    dispatcher_t<true_>{}(rhs.get_which(), rhs.m_storage, c);
+    STRICT_VARIANT_ASSERT(rhs.get_which() == this->get_which(), "Postcondition failed!");
+  }
+
+  void move_construct(variant_base && rhs) {
+    this->move_construct(std::move(rhs), std::integral_constant<bool, pointer_move>{});
+  }
+
+  // Does not pierce a shared wrapper, see `move_constructor`
+  void move_construct(variant_base && rhs, std::false_type) {
+    move_constructor c(*this);
+    dispatcher_t<true_>{}(rhs.get_which(), rhs.m_storage, c);
+    STRICT_VARIANT_ASSERT(rhs.get_which() == this->get_which(), "Postcondition failed!");
+  }
+
+  // Does not pierce, and leaves `rhs` holding its fallback value if it held a wrapper
+  void move_construct(variant_base && rhs, std::true_type) {
+    pointer_constructor c(*this, rhs);
+    dispatcher_t<true_>{}(rhs.get_which(), rhs.m_storage, c);
+  }
+
+  // Does not pierce, so that a shared wrapper can be copied rather than its value
+  void copy_assign(const variant_base & rhs) {
+    copy_assigner a(*this);
+    dispatcher_t<true_>{}(rhs.get_which(), rhs.m_storage, a);
+    STRICT_VARIANT_ASSERT(rhs.get_which() == this->get_which(), "Postcondition failed!");
+  }
+
+  void move_assign(variant_base && rhs) {
+    this->move_assign(std::move(rhs), std::integral_constant<bool, pointer_move>{});
+  }
+
+  void move_assign(variant_base && rhs, std::false_type) {
+    move_assigner a(*this);
+    dispatcher_t<true_>{}(rhs.get_which(), rhs.m_storage, a);
+    STRICT_VARIANT_ASSERT(rhs.get_which() == this->get_which(), "Postcondition failed!");
+  }
+
+  void move_assign(variant_base && rhs, std::true_type) {
+    if (this == &rhs) { return; }
+    pointer_assigner a(*this, rhs);
+    dispatcher_t<true_>{}(rhs.get_which(), rhs.m_storage, a);
+  }
+
+  /***
+   * Ctors
+   */
+  explicit variant_base(no_init_tag) noexcept {}
+
+  template <std::size_t index, typename... Args>
+  explicit variant_base(init_index_tag<index>, Args &&... args) {
+    this->template initialize<index>(std::forward<Args>(args)...);
+  }
+
+  // Visitable is a forwarding reference to some variant type
+  template <typename Visitable>
+  explicit variant_base(init_visit_tag, Visitable && visitable) {
+    constructor c(*this);
+    mpl::remove_reference_t<Visitable>::apply_visitor_impl(c, std::forward<Visitable>(visitable));
+  }
+};
+
+/***
+ * Implementation details of private visitors
+ */
+template <typename First, typename... Types>
+struct variant_base<First, Types...>::constructor {
+  typedef void result_type;
+
+  explicit constructor(variant_base & self)
+    : m_self(self) {}
+
+  template <typename T>
+  void operator()(T && rhs) const {
+    constexpr std::size_t index = find_which<mpl::remove_reference_t<T>>::value;
+    m_self.template initialize<index>(std::forward<T>(rhs));
+  }
+
+private:
+  variant_base & m_self;
+};
+
+// assigner
+template <typename First, typename... Types>
+struct variant_base<First, Types...>::assigner {
+
+  static_assert(noexcept_helper::assignable,
+                "All types in this variant must be nothrow move constructible or placed in a "
+                "recursive_wrapper, or the variant cannot be assigned!");
+
+  typedef void result_type;
+
+  explicit assigner(variant_base & self)
+    : m_self(self) {}
+
+  template <typename Rhs>
+  void operator()(Rhs && rhs) const {
+    constexpr std::size_t index = find_which<mpl::remove_reference_t<Rhs>>::value;
+    m_self.template assign<index>(std::forward<Rhs>(rhs));
+  }
+
+private:
+  variant_base & m_self;
+};
+
+// copy_assigner: Copies a shared wrapper, and assigns everything else by value
+template <typename First, typename... Types>
+struct variant_base<First, Types...>::copy_assigner {
+  typedef void result_type;
+
+  explicit copy_assigner(variant_base & self)
+    : m_self(self) {}
+
+  template <typename T>
+  void operator()(const T & t) const {
+    this->copy(t, typename is_shared_wrapper<T>::type{});
+  }
+
+private:
+  variant_base & m_self;
+
+  template <typename T>
+  void copy(const T & t, std::false_type) const {
+    assigner{m_self}(pierce_wrapper(t));
+  }
+
+  // Copying the wrapper doesn't throw, and keeps the value alive if it is our own
+  template <typename T>
+  void copy(const T & t, std::true_type) const noexcept {
+    T tmp(t);
+    m_self.destroy();
+    m_self.template initialize<find_which<T>::value>(std::move(tmp));
+  }
+};
+
+// move_constructor: Copies a shared wrapper, and moves everything else by value.
+// Moving the value out of a shared wrapper would copy it if it is shared, and
+// then allocate a new wrapper for it, but copying the wrapper doesn't throw.
+template <typename First, typename... Types>
+struct variant_base<First, Types...>::move_constructor {
+  typedef void result_type;
+
+  explicit move_constructor(variant_base & self)
+    : m_self(self) {}
+
+  template <typename T>
+  void operator()(T & t) const {
+    this->move(t, typename is_shared_wrapper<T>::type{});
+  }
+
+private:
+  variant_base & m_self;
+
+  template <typename T>
+  void move(T & t, std::false_type) const {
+    constructor{m_self}(std::move(pierce_wrapper(t)));
+  }
+
+  template <typename T>
+  void move(T & t, std::true_type) const noexcept {
+    m_self.template initialize<find_which<T>::value>(static_cast<const T &>(t));
+  }
+};
+
+// move_assigner: Copies a shared wrapper, and move assigns everything else by value
+template <typename First, typename... Types>
+struct variant_base<First, Types...>::move_assigner {
+  typedef void result_type;
+
+  explicit move_assigner(variant_base & self)
+    : m_self(self) {}
+
+  template <typename T>
+  void operator()(T & t) const {
+    this->move(t, typename is_shared_wrapper<T>::type{});
+  }
+
+private:
+  variant_base & m_self;
+
+  template <typename T>
+  void move(T & t, std::false_type) const {
+    assigner{m_self}(std::move(pierce_wrapper(t)));
+  }
+
+  template <typename T>
+  void move(T & t, std::true_type) const noexcept {
+    copy_assigner{m_self}(static_cast<const T &>(t));
+  }
+};
+
+// pointer_constructor: Moves a wrapper by pointer, and everything else by value
+template <typename First, typename... Types>
+struct variant_base<First, Types...>::pointer_constructor {
+  typedef void result_type;
+
+  pointer_constructor(variant_base & self, variant_base & rhs)
+    : m_self(self)
+    , m_rhs(rhs) {}
+
+  template <typename T>
+  void operator()(T & t) const {
+    this->move(t, typename is_wrapper<T>::type{});
+  }
+
+private:
+  variant_base & m_self;
+  variant_base & m_rhs;
+
+  template <typename T>
+  void move(T & t, std::false_type) const {
+    m_self.template initialize<find_which<T>::value>(std::move(t));
+  }
+
+  template <typename T>
+  void move(T & t, std::true_type) const noexcept {
+    m_self.template initialize<find_which<T>::value>(std::move(t));
+    m_rhs.reset_to_fallback();
+  }
+};
+
+// pointer_assigner
+template <typename First, typename... Types>
+struct variant_base<First, Types...>::pointer_assigner {
+  typedef void result_type;
+
+  pointer_assigner(variant_base & self, variant_base & rhs)
+    : m_self(self)
+    , m_rhs(rhs) {}
+
+  template <typename T>
+  void operator()(T & t) const {
+    this->move(t, typename is_wrapper<T>::type{});
+  }
+
+private:
+  variant_base & m_self;
+  variant_base & m_rhs;
+
+  template <typename T>
+  void move(T & t, std::false_type) const {
+    m_self.template assign<find_which<T>::value>(std::move(t));
+  }
+
+  // Our old value is destroyed even if it is the same type, instead of being
+  // move assigned. `rhs` may live inside that value, as in
+  // `v = std::move(get<node>(&v)->child)`, so the wrapper is taken out of it
+  // before anything is destroyed.
+  template <typename T>
+  void move(T & t, std::true_type) const noexcept {
+    T tmp(std::move(t));
+    m_rhs.reset_to_fallback();
+    m_self.destroy();
+    m_self.template initialize<find_which<T>::value>(std::move(tmp));
+  }
+};
+
+// destroyer
+template <typename First, typename... Types>
+struct variant_base<First, Types...>::destroyer {
+  typedef void result_type;
+
+  template <typename T>
+  void operator()(T & t) const noexcept {
+    t.~T();
+  }
+};
+
+/***
+ * Special member function layers.
+ *
+ * Each one is specialized on whether the corresponding operation is trivial.
+ * The trivial version declares nothing and lets the compiler generate it, the
+ * non-trivial version implements it using variant_base.
+ *
+ * Note: The destructor layer must be above both of the ctor layers, so that if
+ * a copy or move ctor throws we never run the variant destructor.
+ */
+
+// Copy ctor
+template <typename Base, bool trivial>
+struct variant_copy_ctor_layer : Base {
+  using Base::Base;
+};
+
+template <typename Base>
+struct variant_copy_ctor_layer<Base, false> : Base {
+  using Base::Base;
+
+  variant_copy_ctor_layer(const variant_copy_ctor_layer & rhs) noexcept(
+    Base::noexcept_helper::nothrow_copy_ctors)
+    : Base(no_init_tag{}) {
+    this->copy_construct(rhs);
+  }
+
+  variant_copy_ctor_layer(variant_copy_ctor_layer &&) = default;
+  variant_copy_ctor_layer & operator=(const variant_copy_ctor_layer &) = default;
+  variant_copy_ctor_layer & operator=(variant_copy_ctor_layer &&) = default;
+};
+
+// Move ctor
+template <typename Base, bool trivial>
+struct variant_move_ctor_layer : Base {
+  using Base::Base;
+};
+
+template <typename Base>
+struct variant_move_ctor_layer<Base, false> : Base {
+  using Base::Base;
+
+  variant_move_ctor_layer(const variant_move_ctor_layer &) = default;
+
+  variant_move_ctor_layer(variant_move_ctor_layer && rhs) noexcept(Base::nothrow_move_ctor)
+    : Base(no_init_tag{}) {
+    this->move_construct(std::move(rhs));
+  }
+
+  variant_move_ctor_layer & operator=(const variant_move_ctor_layer &) = default;
+  variant_move_ctor_layer & operator=(variant_move_ctor_layer &&) = default;
+};
+
+// Dtor
+template <typename Base, bool trivial>
+struct variant_dtor_layer : Base {
+  using Base::Base;
+};
+
+template <typename Base>
+struct variant_dtor_layer<Base, false> : Base {
+  using Base::Base;
+
+  ~variant_dtor_layer() noexcept { this->destroy(); }
+
+  variant_dtor_layer(const variant_dtor_layer &) = default;
+  variant_dtor_layer(variant_dtor_layer &&) = default;
+  variant_dtor_layer & operator=(const variant_dtor_layer &) = default;
+  variant_dtor_layer & operator=(variant_dtor_layer &&) = default;
+};
+
+// Copy assignment
+template <typename Base, bool trivial>
+struct variant_copy_assign_layer : Base {
+  using Base::Base;
+};
+
+template <typename Base>
+struct variant_copy_assign_layer<Base, false> : Base {
+  using Base::Base;
+
+  variant_copy_assign_layer(const variant_copy_assign_layer &) = default;
+  variant_copy_assign_layer(variant_copy_assign_layer &&) = default;
+
+  variant_copy_assign_layer & operator=(const variant_copy_assign_layer & rhs) noexcept(
+    Base::noexcept_helper::nothrow_copy_assign) {
+    this->copy_assign(rhs);
+    return *this;
+  }
+
+  variant_copy_assign_layer & operator=(variant_copy_assign_layer &&) = default;
+};
+
+// Move assignment
+template <typename Base, bool trivial>
+struct variant_move_assign_layer : Base {
+  using Base::Base;
+};
+
+template <typename Base>
+struct variant_move_assign_layer<Base, false> : Base {
+  using Base::Base;
+
+  variant_move_assign_layer(const variant_move_assign_layer &) = default;
+  variant_move_assign_layer(variant_move_assign_layer &&) = default;
+  variant_move_assign_layer & operator=(const variant_move_assign_layer &) = default;
+
+  variant_move_assign_layer & operator=(variant_move_assign_layer && rhs) noexcept(
+    Base::nothrow_move_assign) {
+    this->move_assign(std::move(rhs));
+    return *this;
+  }
+};
+
+/***
+ * Metafunction which assembles the base class of `variant<First, Types...>`
+ */
+template <typename First, typename... Types>
+struct variant_layers {
+  using trivial = variant_trivial_helper<First, Types...>;
+
+  using type = variant_move_assign_layer<
+    variant_copy_assign_layer<
+      variant_dtor_layer<
+        variant_move_ctor_layer<
+          variant_copy_ctor_layer<variant_base<First, Types...>, trivial::copy_ctor>,
+          trivial::move_ctor>,
+        trivial::dtor>,
+      trivial::copy_assign>,
+    trivial::move_assign>;
+};
+
+template <typename First, typename... Types>
+using variant_layers_t = typename variant_layers<First, Types...>::type;
+
+} // end namespace detail
+} // end namespace strict_variant
+
+#undef STRICT_VARIANT_ASSERT
@@ -6,8 +6,10 @@
 #pragma once
 
 #include <functional>
+#include <strict_variant/filter_overloads.hpp>
 #include <strict_variant/variant.hpp>
 #include <type_traits>
+#include <utility>
 
 /***
  * This variant comparator allows comparing variants which are over
@@ -43,34 +45,129 @@ struct variant_comparator<variant<types...>, ComparatorTemplate, WhichComparator
 
   typedef variant<types...> var_t;
 
+  // Both values have the same type, so we dispatch once on the first, and read
+  // the other as that type.
   struct helper {
 
-    const var_t & first;
     const var_t & other;
 
-    explicit helper(const var_t & _f, const var_t & _o)
-      : first(_f)
-      , other(_o) {}
+    explicit helper(const var_t & _o)
+      : other(_o) {}
 
     template <typename T>
     bool operator()(const T & t) const {
-      if (const T * o = strict_variant::get<T>(&other)) {
-        ComparatorTemplate<T> c;
-        return c(t, *o);
-      } else {
-        static_assert(std::is_same<int, decltype(first.which())>::value,
-                      "The return type of 'variant::which' was changed and "
-                      "variant_compare was not updated");
-        WhichComparator_t c;
-        return c(first.which(), other.which());
-      }
+      ComparatorTemplate<unwrap_type_t<T>> c;
+      return c(detail::pierce_wrapper(t),
+               detail::pierce_wrapper(detail::same_type_value<T>(var_t::storage_impl(other))));
     }
   };
 
+  using dispatcher_t = detail::visitor_dispatch<detail::true_, sizeof...(types),
+                                                typename dispatch_strategy<var_t>::type>;
+
   bool operator()(const var_t & v1, const var_t & v2) const {
-    helper h{v1, v2};
-    return strict_variant::apply_visitor(h, v1);
+    static_assert(std::is_same<int, decltype(v1.which())>::value,
+                  "The return type of 'variant::which' was changed and "
+                  "variant_compare was not updated");
+    if (v1.which() != v2.which()) {
+      WhichComparator_t c;
+      return c(v1.which(), v2.which());
+    }
+    return dispatcher_t{}(static_cast<unsigned int>(v1.which()), var_t::storage_impl(v1),
+                          helper{v2});
+  }
+};
+
+namespace detail {
+
+// Compares two values of the same type in a variant, with `operator <`
+template <typename V>
+struct three_way_helper {
+  const V & other;
+
+  template <typename T>
+  int operator()(const T & t) const {
+    const auto & l = detail::pierce_wrapper(t);
+    const auto & r = detail::pierce_wrapper(detail::same_type_value<T>(V::storage_impl(other)));
+    return (l < r) ? -1 : ((r < l) ? 1 : 0);
+  }
+};
+
+} // end namespace detail
+
+//[ strict_variant_three_way_compare
+/***
+ * Three-way comparison of variants, in the order of the default
+ * `variant_comparator`: negative if `lhs` is less than `rhs`, zero if neither
+ * is less, and positive otherwise. A value's `operator <` is called at most
+ * twice, after one dispatch.
+ */
+template <typename... Ts>
+int
+three_way_compare(const variant<Ts...> & lhs, const variant<Ts...> & rhs) {
+  using var_t = variant<Ts...>;
+  using dispatcher_t =
+    detail::visitor_dispatch<detail::true_, sizeof...(Ts), typename dispatch_strategy<var_t>::type>;
+
+  if (lhs.which() != rhs.which()) { return (lhs.which() < rhs.which()) ? -1 : 1; }
+  return dispatcher_t{}(static_cast<unsigned int>(lhs.which()), var_t::storage_impl(lhs),
+                        detail::three_way_helper<var_t>{rhs});
+}
+//]
+
+} // end namespace strict_variant
+
+namespace strict_variant {
+namespace detail {
+
+/***
+ * How `variant_transparent_equal` compares a `T` in a variant with an `Arg`.
+ * If `T == Arg` is valid it is used, otherwise the `Arg` is converted to a
+ * `T` first.
+ */
+template <typename T, typename Arg, typename = void>
+struct raw_value_equal {
+  static bool equal(const T & t, const Arg & a) { return t == T(a); }
+};
+
+template <typename T, typename Arg>
+struct raw_value_equal<T, Arg,
+                       decltype(void(std::declval<const T &>() == std::declval<const Arg &>()))> {
+  static bool equal(const T & t, const Arg & a) { return t == a; }
+};
+
+} // end namespace detail
+
+//[ strict_variant_transparent_equal
+/***
+ * `operator==` of variants, which also compares a variant with a value that
+ * is not a variant, as if it were in a variant, without constructing one.
+ * The value must be safely constructible into exactly one of the types, after
+ * the rules of `filter_overloads`. Use with `variant_transparent_hash`.
+ */
+template <typename V>
+struct variant_transparent_equal;
+
+template <typename... Ts>
+struct variant_transparent_equal<variant<Ts...>> {
+  typedef void is_transparent;
+
+  bool operator()(const variant<Ts...> & l, const variant<Ts...> & r) const { return l == r; }
+
+  template <typename Arg, typename Overload = unique_overload<const Arg &, mpl::TypeList<Ts...>>,
+            typename = mpl::enable_if_t<!is_variant<Arg>::value && Overload::value>>
+  bool operator()(const variant<Ts...> & v, const Arg & a) const {
+    using T = unwrap_type_t<mpl::Index_At<mpl::TypeList<Ts...>, Overload::index>>;
+    const T * t = strict_variant::get<Overload::index>(&v);
+    return t && detail::raw_value_equal<T, Arg>::equal(*t, a);
+  }
+
+  template <typename Arg, typename Overload = unique_overload<const Arg &, mpl::TypeList<Ts...>>,
+            typename = mpl::enable_if_t<!is_variant<Arg>::value && Overload::value>>
+  bool operator()(const Arg & a, const variant<Ts...> & v) const {
+    return (*this)(v, a);
   }
 };
+//]
 
 } // end namespace strict_variant
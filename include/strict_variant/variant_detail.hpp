@@ -5,11 +5,15 @@
 
 #pragma once
 
+#include <strict_variant/blank.hpp>
 #include <strict_variant/mpl/find_with.hpp>
+#include <strict_variant/mpl/std_traits.hpp>
 #include <strict_variant/wrapper.hpp>
 #include <strict_variant/safely_constructible.hpp>
 #include <strict_variant/variant_fwd.hpp>
 
+#include <cstddef>
+#include <cstdint>
 #include <type_traits>
 
 /***
@@ -33,6 +37,17 @@ struct same_modulo_const_ref_wrapper {
   };
 };
 
+/***
+ * Metafunction `find_which`: The index of type `Rhs` in `Ts...`, modulo const
+ * and recursive wrapper. A static_assert fails if there is no match.
+ */
+template <typename Rhs, typename... Ts>
+struct find_which {
+  static constexpr std::size_t value =
+    mpl::Find_With<same_modulo_const_ref_wrapper<Rhs>::template prop, Ts...>::value;
+  static_assert(value < sizeof...(Ts), "No match for value");
+};
+
 /***
  * Property `is_member_modulo_const_ref_wrappr` checks if an element is in a
  * list, modulo const and recursive wrapper.
@@ -75,6 +90,159 @@ struct proper_subvariant {
   static constexpr bool value = !std::is_same<A, B>::value && subvariant<A, B>::value;
 };
 
+/***
+ * Metafunction `which_type`:
+ *   The smallest unsigned integer type able to hold the `which` value of a
+ *   variant with `num_types` alternatives. This is what variant actually
+ *   stores, `variant::which()` still reports an `int`.
+ */
+template <std::size_t num_types>
+struct which_type {
+  using type = typename std::conditional<
+    (num_types <= 255u), std::uint8_t,
+    typename std::conditional<(num_types <= 65535u), std::uint16_t, std::uint32_t>::type>::type;
+};
+
+template <std::size_t num_types>
+using which_type_t = typename which_type<num_types>::type;
+
+/***
+ * Metafunction `which_bits`:
+ *   The number of bits needed to hold the `which` value.
+ */
+template <std::size_t num_types>
+struct which_bits {
+  static constexpr unsigned int value = 1u + which_bits<(num_types + 1) / 2>::value;
+};
+
+template <>
+struct which_bits<1> {
+  static constexpr unsigned int value = 0;
+};
+
+template <>
+struct which_bits<0> {
+  static constexpr unsigned int value = 0;
+};
+
+} // end namespace detail
+
+//[ strict_variant_compact_layout
+/***
+ * Trait which selects the layout of a particular variant type.
+ *
+ * Specialize it as `std::true_type` to store the `which` value in the
+ * `spare_bits` of the values, rather than in a separate integer. Then each of
+ * the value types must have enough spare bits to hold any `which` value, and
+ * the variant is no larger than its largest value type. For instance,
+ * `variant<recursive_wrapper<A>, recursive_wrapper<B>>` is then the size of a
+ * pointer.
+ *
+ * Like `dispatch_strategy`, this must be specialized before the variant type
+ * is used.
+ */
+template <typename Variant>
+struct compact_layout : std::false_type {};
+//]
+
+namespace detail {
+
+/***
+ * Metafunction `can_compact`:
+ *   Whether all of the types have enough spare bits for the `which` value.
+ */
+template <typename... Types>
+struct can_compact {
+  template <typename T>
+  struct has_room {
+    static constexpr bool value = spare_bits<T>::value >= which_bits<sizeof...(Types)>::value
+                                  && sizeof(T) >= sizeof(std::uintptr_t);
+  };
+
+  static constexpr bool value = mpl::All_Have<has_room, Types...>::value;
+};
+
+/***
+ * Metafunction `blank_index`: The index of `blank` among the types, if it is
+ * one of them.
+ */
+template <typename T>
+struct is_blank : std::is_same<T, blank> {};
+
+template <typename... Types>
+struct blank_index {
+  static constexpr std::size_t value = mpl::Find_With<is_blank, Types...>::value;
+  static constexpr bool found = value < sizeof...(Types);
+};
+
+/***
+ * Metafunction `extract_fallback`: The value a variant is left holding when a
+ * wrapped value is taken out of it. This is `blank`, if it is one of the
+ * types, and otherwise the first type which is not wrapped and is nothrow
+ * default constructible.
+ */
+template <typename T>
+struct is_extract_fallback
+  : std::integral_constant<bool, !is_wrapper<T>::value
+                                   && std::is_nothrow_default_constructible<T>::value> {};
+
+template <typename... Types>
+struct extract_fallback {
+  static constexpr std::size_t value = blank_index<Types...>::found
+                                         ? blank_index<Types...>::value
+                                         : mpl::Find_With<is_extract_fallback, Types...>::value;
+  static constexpr bool found = value < sizeof...(Types);
+};
+
+// The default for a variant which has `blank`, and with
+// `STRICT_VARIANT_POINTER_MOVE`, for every variant which has a fallback value.
+template <typename Variant>
+struct pointer_move_default : std::false_type {};
+
+struct pointer_move_everywhere {
+  static constexpr bool value =
+#ifdef STRICT_VARIANT_POINTER_MOVE
+    true;
+#else
+    false;
+#endif
+};
+
+template <typename... Types>
+struct pointer_move_default<variant<Types...>>
+  : std::integral_constant<bool, blank_index<Types...>::found
+                                   || (pointer_move_everywhere::value
+                                       && extract_fallback<Types...>::found)> {};
+
+} // end namespace detail
+
+//[ strict_variant_pointer_move
+/***
+ * Trait which selects how a particular variant type moves wrapped values.
+ *
+ * By default, moving a variant which holds a `recursive_wrapper<T>` moves the
+ * `T` into a new allocation, so that the moved-from variant still holds a `T`.
+ *
+ * Specialize it as `std::true_type` to move the heap pointer instead. The
+ * moved-from variant is then left holding a default constructed value of its
+ * first type which is not wrapped and is nothrow default constructible, which
+ * it must have. Move construction and move assignment of the variant then
+ * never allocate, and are `noexcept` if moving its other types is.
+ *
+ * This is the default for a variant type which has `blank` among its types,
+ * and then the moved-from variant is left holding `blank`. Defining
+ * `STRICT_VARIANT_POINTER_MOVE` makes this the default for every variant type
+ * that has a fallback value.
+ *
+ * Like `dispatch_strategy`, this must be specialized before the variant type
+ * is used.
+ */
+template <typename Variant>
+struct pointer_move : detail::pointer_move_default<Variant> {};
+//]
+
+namespace detail {
+
 /****
  * NOEXCEPT TRAITS
  *
@@ -146,6 +314,13 @@ struct is_nothrow_copy_assignable_impl<T, true> : std::false_type {};
 template <typename T>
 struct is_nothrow_copy_assignable : is_nothrow_copy_assignable_impl<T> {};
 
+// When wrappers are moved by pointer, they are move assigned by destroying and
+// moving, which is nothrow
+template <typename T>
+struct is_nothrow_move_assignable_or_wrapper
+  : std::integral_constant<bool, is_wrapper<T>::value || std::is_nothrow_move_assignable<T>::value> {
+};
+
 
 template <typename First, typename... Types>
 struct variant_noexcept_helper {
@@ -179,10 +354,16 @@ struct variant_noexcept_helper {
     false;
 #endif
 
-  static constexpr bool assignable =
+  // With `blank`, a throwing change of type is done in place, falling back to
+  // `blank` if it throws, so no type needs a nothrow move.
+  static constexpr bool has_blank = blank_index<First, Types...>::found;
+
+  static constexpr bool nothrow_moveable_or_wrapped =
     assume_move_nothrow
     || mpl::All_Have<detail::is_nothrow_moveable_or_wrapper, First, Types...>::value;
 
+  static constexpr bool assignable = has_blank || nothrow_moveable_or_wrapped;
+
   static constexpr bool nothrow_move_ctors =
     assume_move_nothrow || mpl::All_Have<detail::is_nothrow_moveable, First, Types...>::value;
 
@@ -194,6 +375,38 @@ struct variant_noexcept_helper {
 
   static constexpr bool nothrow_copy_assign =
     nothrow_copy_ctors && mpl::All_Have<detail::is_nothrow_copy_assignable, First, Types...>::value;
+
+  // The same, when wrappers are moved by pointer (see `pointer_move`)
+  static constexpr bool nothrow_pointer_move_ctors = nothrow_moveable_or_wrapped;
+
+  static constexpr bool nothrow_pointer_move_assign =
+    nothrow_pointer_move_ctors
+    && mpl::All_Have<detail::is_nothrow_move_assignable_or_wrapper, First, Types...>::value;
+};
+
+/****
+ * TRIVIALITY TRAITS
+ *
+ * When every type has a trivial special member function, so does the variant.
+ * Assignment may also need to destroy the old value and construct a new one,
+ * so it is only trivial when those operations are also trivial.
+ */
+
+template <typename First, typename... Types>
+struct variant_trivial_helper {
+  static constexpr bool dtor = mpl::All_Have<mpl::is_trivially_destructible, First, Types...>::value;
+
+  static constexpr bool copy_ctor =
+    mpl::All_Have<mpl::is_trivially_copy_constructible, First, Types...>::value;
+
+  static constexpr bool move_ctor =
+    mpl::All_Have<mpl::is_trivially_move_constructible, First, Types...>::value;
+
+  static constexpr bool copy_assign =
+    dtor && copy_ctor && mpl::All_Have<mpl::is_trivially_copy_assignable, First, Types...>::value;
+
+  static constexpr bool move_assign =
+    dtor && move_ctor && mpl::All_Have<mpl::is_trivially_move_assignable, First, Types...>::value;
 };
 
 } // end namespace detail
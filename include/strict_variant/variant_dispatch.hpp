@@ -32,8 +32,67 @@
 
 #endif // STRICT_VARIANT_DEBUG
 
+// Branch prediction hint, used by the weighted strategies
+#if defined(__GNUC__)
+#define STRICT_VARIANT_EXPECT(C, V) __builtin_expect(static_cast<long>(C), static_cast<long>(V))
+#else
+#define STRICT_VARIANT_EXPECT(C, V) (C)
+#endif
+
 namespace strict_variant {
 
+//[ strict_variant_dispatch_strategies
+/***
+ * Dispatch strategies:
+ *   Tags which select how a visitor is dispatched based on the `which` value.
+ *   Use them with `apply_visitor_with<Strategy>`, or specialize
+ *   `dispatch_strategy` to change the default for a particular variant type.
+ */
+namespace dispatch {
+
+// Repeatedly split the range of `which` values in half.
+struct binary_search {};
+
+// Index an array of function pointers.
+struct jump_table {};
+
+// Test each `which` value in order.
+struct linear {};
+
+// A `switch` statement, which compilers lower to a table of labels.
+struct switch_table {};
+
+// Binary search, where the range of `which` values is split so that both
+// halves have about the same total weight, rather than the same number of
+// types. There is one weight for each type, e.g. its expected frequency.
+// Heavy types end up near the root of the tree, and branches towards a
+// much heavier subtree are marked as likely.
+template <unsigned int... Weights>
+struct weighted {};
+
+// Test for each of the listed type indices first, in order, marking the first
+// test as likely. Other values are dispatched by `automatic`.
+template <unsigned int... Indices>
+struct hot_types {};
+
+// `binary_search` for up to `switch_point` types, `switch_table` above that.
+// In `bench/` with an opaque visitor, `binary_search` is faster up to fifteen
+// types, and `switch_table` from sixteen types on (gcc 12, -O3).
+struct automatic {
+  static constexpr unsigned int switch_point = 15;
+};
+
+} // end namespace dispatch
+
+/***
+ * Trait which gives the dispatch strategy used by a particular variant type.
+ */
+template <typename Variant>
+struct dispatch_strategy {
+  using type = dispatch::automatic;
+};
+//]
+
 namespace detail {
 
 /***
@@ -96,24 +155,45 @@ struct return_typer {
 /// Then we dereference the array at index `m_which` and call that function.
 /// This means we pick out the right function very quickly, but it may not be
 /// inlined by the compiler even if it is small.
+///
+/// The table is a `constexpr` static data member, so it is constant-initialized
+/// and there is no thread-safe initialization guard to check on each visit.
 
-template <typename return_t, typename Internal, typename ulist>
-struct jumptable_dispatch;
+template <typename return_t, typename Internal, typename Storage, typename Visitor, typename ulist>
+struct jumptable;
 
-template <typename return_t, typename Internal, unsigned... Indices>
-struct jumptable_dispatch<return_t, Internal, mpl::ulist<Indices...>> {
-  template <typename Storage, typename Visitor>
-  return_t operator()(const unsigned int which, Storage && storage, Visitor && visitor)
+template <typename return_t, typename Internal, typename Storage, typename Visitor,
+          unsigned... Indices>
+struct jumptable<return_t, Internal, Storage, Visitor, mpl::ulist<Indices...>> {
+  using caller_t = return_t (*)(Storage &&, Visitor &&);
 
-  {
-    using whichCaller = return_t (*)(Storage, Visitor);
+  // Adapts `visitor_caller` to the common return type, so that all entries
+  // in the table have the same type.
+  template <unsigned index>
+  static return_t call(Storage && storage, Visitor && visitor) {
+    return visitor_caller<index, Internal, Storage, Visitor>(std::forward<Storage>(storage),
+                                                             std::forward<Visitor>(visitor));
+  }
 
-    static whichCaller callers[sizeof...(Indices)] = {
-      &visitor_caller<Indices, Internal, Storage, Visitor>...};
+  static constexpr caller_t callers[sizeof...(Indices)] = {&call<Indices>...};
+};
+
+template <typename return_t, typename Internal, typename Storage, typename Visitor,
+          unsigned... Indices>
+constexpr typename jumptable<return_t, Internal, Storage, Visitor, mpl::ulist<Indices...>>::caller_t
+  jumptable<return_t, Internal, Storage, Visitor,
+            mpl::ulist<Indices...>>::callers[sizeof...(Indices)];
+
+template <typename return_t, typename Internal, unsigned int num_types>
+struct jumptable_dispatch {
+  template <typename Storage, typename Visitor>
+  return_t operator()(const unsigned int which, Storage && storage, Visitor && visitor) {
+    using table_t = jumptable<return_t, Internal, Storage, Visitor, mpl::count_t<num_types>>;
 
-    STRICT_VARIANT_ASSERT(which < static_cast<unsigned int>(sizeof...(Indices)));
+    STRICT_VARIANT_ASSERT(which < num_types);
 
-    return (*callers[which])(std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+    return (*table_t::callers[which])(std::forward<Storage>(storage),
+                                      std::forward<Visitor>(visitor));
   }
 };
 
@@ -160,14 +240,314 @@ struct binary_search_dispatch<return_t, Internal, base, 1u> {
   }
 };
 
-/// Choose the jumptable dispatch strategy when the number of types is > switch
-/// point
-/// choose the binary search dispatch for less than that.
-/// Tentatively choosing 4 for switch point, potentially 8 is better... ?
-/// Needs more rigorous benchmarking
-template <typename Internal, size_t num_types>
+/// Weighted strategy: the same as `binary_search_dispatch`, except for the
+/// point at which the range is split.
+///
+/// `weights` is a `weight_list`, which computes the split point for a range
+/// of types as a constant expression.
+
+template <unsigned int... Ws>
+struct weight_list;
+
+template <>
+struct weight_list<> {
+  static constexpr unsigned long long at(unsigned int) { return 0; }
+};
+
+template <unsigned int W, unsigned int... Ws>
+struct weight_list<W, Ws...> {
+  static constexpr unsigned long long at(unsigned int i) {
+    return i == 0 ? W : weight_list<Ws...>::at(i - 1);
+  }
+
+  // Total weight of types [base, base + n)
+  static constexpr unsigned long long sum(unsigned int base, unsigned int n) {
+    return n == 0 ? 0 : at(base) + sum(base + 1, n - 1);
+  }
+
+  // Difference of weights of [base, base + k) and [base + k, base + n), times two
+  static constexpr unsigned long long imbalance(unsigned int base, unsigned int n,
+                                                unsigned int k) {
+    return 2 * sum(base, k) >= sum(base, n) ? 2 * sum(base, k) - sum(base, n)
+                                            : sum(base, n) - 2 * sum(base, k);
+  }
+
+  // Number of types in the left part of the split of [base, base + n).
+  // This is the first k for which the left part weighs at least half,
+  // or the one before it, if that is better balanced.
+  static constexpr unsigned int split(unsigned int base, unsigned int n, unsigned int k = 1) {
+    return (k + 1 >= n || 2 * sum(base, k) >= sum(base, n))
+             ? ((k > 1 && imbalance(base, n, k - 1) < imbalance(base, n, k)) ? k - 1 : k)
+             : split(base, n, k + 1);
+  }
+
+  // Which side of the split of [base, base + n) to predict:
+  // 1 if left, 0 if right, -1 for no prediction.
+  // We only predict a side weighing at least twice the other.
+  static constexpr int hint(unsigned int base, unsigned int n) {
+    return sum(base, split(base, n)) >= 2 * sum(base + split(base, n), n - split(base, n))
+             ? 1
+             : (sum(base + split(base, n), n - split(base, n)) >= 2 * sum(base, split(base, n))
+                  ? 0
+                  : -1);
+  }
+};
+
+template <typename return_t, typename Internal, typename weights, unsigned int base,
+          unsigned int num_types>
+struct weighted_dispatch {
+  static_assert(num_types >= 2, "Something wrong with weighted dispatch");
+
+  static constexpr unsigned int split = weights::split(base, num_types);
+  static constexpr int hint = weights::hint(base, num_types);
+
+  template <typename Storage, typename Visitor>
+  return_t operator()(const unsigned int which, Storage && storage, Visitor && visitor) {
+
+    if (hint < 0 ? (which < base + split) : STRICT_VARIANT_EXPECT(which < base + split, hint)) {
+      return weighted_dispatch<return_t, Internal, weights, base, split>{}(
+        which, std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+    } else {
+      return weighted_dispatch<return_t, Internal, weights, base + split, num_types - split>{}(
+        which, std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+    }
+  }
+};
+
+template <typename return_t, typename Internal, typename weights, unsigned int base>
+struct weighted_dispatch<return_t, Internal, weights, base, 1u> {
+  template <typename Storage, typename Visitor>
+  return_t operator()(const unsigned int which, Storage && storage, Visitor && visitor) {
+    STRICT_VARIANT_ASSERT(which == base);
+
+    return visitor_caller<base, Internal, Storage, Visitor>(std::forward<Storage>(storage),
+                                                            std::forward<Visitor>(visitor));
+  }
+};
+
+/// Hot types strategy: test the listed indices in order, then fall back to
+/// `fallback_t` (the automatic strategy).
+
+template <typename return_t, typename Internal, typename fallback_t, unsigned int... Indices>
+struct hot_types_dispatch;
+
+template <typename return_t, typename Internal, typename fallback_t>
+struct hot_types_dispatch<return_t, Internal, fallback_t> {
+  template <typename Storage, typename Visitor>
+  return_t operator()(const unsigned int which, Storage && storage, Visitor && visitor) {
+    return fallback_t{}(which, std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+  }
+};
+
+template <typename return_t, typename Internal, typename fallback_t, unsigned int index,
+          unsigned int... Indices>
+struct hot_types_dispatch<return_t, Internal, fallback_t, index, Indices...> {
+  template <typename Storage, typename Visitor>
+  return_t operator()(const unsigned int which, Storage && storage, Visitor && visitor) {
+    if (which == index) {
+      return visitor_caller<index, Internal, Storage, Visitor>(std::forward<Storage>(storage),
+                                                               std::forward<Visitor>(visitor));
+    } else {
+      return hot_types_dispatch<return_t, Internal, fallback_t, Indices...>{}(
+        which, std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+    }
+  }
+};
+
+/// Linear strategy: test each value of "which" in turn, in order.
+///
+/// This is the best choice when the first few types are much more common than
+/// the others, and the visitor calls can always be inlined.
+
+template <typename return_t, typename Internal, unsigned int base, unsigned int num_types>
+struct linear_dispatch {
+  template <typename Storage, typename Visitor>
+  return_t operator()(const unsigned int which, Storage && storage, Visitor && visitor) {
+    if (which == base) {
+      return visitor_caller<base, Internal, Storage, Visitor>(std::forward<Storage>(storage),
+                                                              std::forward<Visitor>(visitor));
+    } else {
+      return linear_dispatch<return_t, Internal, base + 1, num_types - 1>{}(
+        which, std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+    }
+  }
+};
+
+template <typename return_t, typename Internal, unsigned int base>
+struct linear_dispatch<return_t, Internal, base, 1u> {
+  template <typename Storage, typename Visitor>
+  return_t operator()(const unsigned int which, Storage && storage, Visitor && visitor) {
+    STRICT_VARIANT_ASSERT(which == base);
+
+    return visitor_caller<base, Internal, Storage, Visitor>(std::forward<Storage>(storage),
+                                                            std::forward<Visitor>(visitor));
+  }
+};
+
+/// Switch strategy: a `switch` statement over "which", with one case per type.
+///
+/// Compilers lower a dense `switch` to a jump table of labels rather than of
+/// functions, so unlike `jumptable_dispatch`, the visitor calls can be inlined.
+///
+/// Since we can't generate `case` labels from a parameter pack, each `switch`
+/// handles a block of `switch_width` types, and the `default` label moves on to
+/// the next block. Labels past the end of the type list are unreachable, they
+/// are mapped onto the last type so that they are well-formed.
+
+static constexpr unsigned int switch_width = 16;
+
+constexpr unsigned int
+switch_case_index(unsigned int index, unsigned int num_types) {
+  return index < num_types ? index : num_types - 1;
+}
+
+template <typename return_t, typename Internal, unsigned int base, unsigned int num_types,
+          bool has_next_block = (base + switch_width < num_types)>
+struct switch_dispatch;
+
+template <typename return_t, typename Internal, unsigned int base, unsigned int num_types,
+          bool has_next_block>
+struct switch_dispatch_default {
+  template <typename Storage, typename Visitor>
+  return_t operator()(const unsigned int which, Storage && storage, Visitor && visitor) {
+    return switch_dispatch<return_t, Internal, base + switch_width, num_types>{}(
+      which, std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+  }
+};
+
+template <typename return_t, typename Internal, unsigned int base, unsigned int num_types>
+struct switch_dispatch_default<return_t, Internal, base, num_types, false> {
+  template <typename Storage, typename Visitor>
+  return_t operator()(const unsigned int which, Storage && storage, Visitor && visitor) {
+    STRICT_VARIANT_ASSERT(which < num_types);
+
+    return visitor_caller<num_types - 1, Internal, Storage, Visitor>(
+      std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+  }
+};
+
+template <typename return_t, typename Internal, unsigned int base, unsigned int num_types,
+          bool has_next_block>
+struct switch_dispatch {
+  template <typename Storage, typename Visitor>
+  return_t operator()(const unsigned int which, Storage && storage, Visitor && visitor) {
+
+#define STRICT_VARIANT_SWITCH_CASE(N)                                                              \
+  case N:                                                                                          \
+    return visitor_caller<switch_case_index(base + N, num_types), Internal, Storage, Visitor>(     \
+      std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+
+    switch (which - base) {
+      STRICT_VARIANT_SWITCH_CASE(0)
+      STRICT_VARIANT_SWITCH_CASE(1)
+      STRICT_VARIANT_SWITCH_CASE(2)
+      STRICT_VARIANT_SWITCH_CASE(3)
+      STRICT_VARIANT_SWITCH_CASE(4)
+      STRICT_VARIANT_SWITCH_CASE(5)
+      STRICT_VARIANT_SWITCH_CASE(6)
+      STRICT_VARIANT_SWITCH_CASE(7)
+      STRICT_VARIANT_SWITCH_CASE(8)
+      STRICT_VARIANT_SWITCH_CASE(9)
+      STRICT_VARIANT_SWITCH_CASE(10)
+      STRICT_VARIANT_SWITCH_CASE(11)
+      STRICT_VARIANT_SWITCH_CASE(12)
+      STRICT_VARIANT_SWITCH_CASE(13)
+      STRICT_VARIANT_SWITCH_CASE(14)
+      STRICT_VARIANT_SWITCH_CASE(15)
+      default:
+        return switch_dispatch_default<return_t, Internal, base, num_types, has_next_block>{}(
+          which, std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+    }
+
+#undef STRICT_VARIANT_SWITCH_CASE
+  }
+};
+
+/// Metafunction which maps a strategy tag to the dispatcher which implements it.
+
+template <unsigned int num_types>
+struct is_hot_index {
+  template <typename T>
+  struct prop : std::integral_constant<bool, (T::value < num_types)> {};
+};
+
+template <typename Strategy, typename return_t, typename Internal, unsigned int num_types>
+struct choose_dispatch;
+
+template <typename return_t, typename Internal, unsigned int num_types>
+struct choose_dispatch<dispatch::binary_search, return_t, Internal, num_types> {
+  using type = binary_search_dispatch<return_t, Internal, 0, num_types>;
+};
+
+template <typename return_t, typename Internal, unsigned int num_types>
+struct choose_dispatch<dispatch::jump_table, return_t, Internal, num_types> {
+  using type = jumptable_dispatch<return_t, Internal, num_types>;
+};
+
+template <typename return_t, typename Internal, unsigned int num_types>
+struct choose_dispatch<dispatch::linear, return_t, Internal, num_types> {
+  using type = linear_dispatch<return_t, Internal, 0, num_types>;
+};
+
+template <typename return_t, typename Internal, unsigned int num_types>
+struct choose_dispatch<dispatch::switch_table, return_t, Internal, num_types> {
+  using type = switch_dispatch<return_t, Internal, 0, num_types>;
+};
+
+template <unsigned int... Weights, typename return_t, typename Internal, unsigned int num_types>
+struct choose_dispatch<dispatch::weighted<Weights...>, return_t, Internal, num_types> {
+  static_assert(sizeof...(Weights) == num_types,
+                "dispatch::weighted needs exactly one weight for each type in the variant");
+
+  using type = weighted_dispatch<return_t, Internal, weight_list<Weights...>, 0, num_types>;
+};
+
+template <unsigned int... Weights, typename return_t, typename Internal>
+struct choose_dispatch<dispatch::weighted<Weights...>, return_t, Internal, 1u> {
+  static_assert(sizeof...(Weights) == 1,
+                "dispatch::weighted needs exactly one weight for each type in the variant");
+
+  using type = linear_dispatch<return_t, Internal, 0, 1>;
+};
+
+template <unsigned int first, unsigned int... Indices, typename return_t, typename Internal,
+          unsigned int num_types>
+struct choose_dispatch<dispatch::hot_types<first, Indices...>, return_t, Internal, num_types> {
+  static_assert(mpl::All_Have<is_hot_index<num_types>::template prop,
+                              std::integral_constant<unsigned int, first>,
+                              std::integral_constant<unsigned int, Indices>...>::value,
+                "dispatch::hot_types index out of range");
+
+  using fallback_t = typename choose_dispatch<dispatch::automatic, return_t, Internal,
+                                              num_types>::type;
+
+  // The first hot type gets the branch hint, the rest are tested in order.
+  struct type {
+    template <typename Storage, typename Visitor>
+    return_t operator()(const unsigned int which, Storage && storage, Visitor && visitor) {
+      if (STRICT_VARIANT_EXPECT(which == first, 1)) {
+        return visitor_caller<first, Internal, Storage, Visitor>(std::forward<Storage>(storage),
+                                                                 std::forward<Visitor>(visitor));
+      } else {
+        return hot_types_dispatch<return_t, Internal, fallback_t, Indices...>{}(
+          which, std::forward<Storage>(storage), std::forward<Visitor>(visitor));
+      }
+    }
+  };
+};
+
+/// The automatic strategy uses the binary search when there are few types,
+/// and the switch above the switch point.
+template <typename return_t, typename Internal, unsigned int num_types>
+struct choose_dispatch<dispatch::automatic, return_t, Internal, num_types>
+  : choose_dispatch<typename std::conditional<(num_types > dispatch::automatic::switch_point),
+                                              dispatch::switch_table,
+                                              dispatch::binary_search>::type,
+                    return_t, Internal, num_types> {};
+
+/// Dispatch a visitor to the storage, using the given strategy.
+template <typename Internal, size_t num_types, typename Strategy = dispatch::automatic>
 struct visitor_dispatch {
-  // static constexpr unsigned int switch_point = 4;
 
   // Helper which takes the conjunction of a typelist of `std::integral_constant<bool>`.
   template <typename T>
@@ -202,16 +582,8 @@ struct visitor_dispatch {
     typename call_helper<Storage, Visitor>::return_type {
 
     using return_t = typename call_helper<Storage, Visitor>::return_type;
-
-    // using chosen_dispatch_t = jumptable_dispatch<return_t, Internal, mpl::count_t<num_types>>;
-
-    // using chosen_dispatch_t =
-    //  typename std::conditional<(num_types > switch_point),
-    //  jumptable_dispatch<return_t, Internal,  mpl::count_t<num_types>>,
-    //                            binary_search_dispatch<return_t, Internal, 0,
-    //                             num_types>>::type;
-
-    using chosen_dispatch_t = binary_search_dispatch<return_t, Internal, 0, num_types>;
+    using chosen_dispatch_t = typename choose_dispatch<Strategy, return_t, Internal,
+                                                       static_cast<unsigned int>(num_types)>::type;
 
     return chosen_dispatch_t{}(which, std::forward<Storage>(storage),
                                std::forward<Visitor>(visitor));
@@ -223,3 +595,4 @@ struct visitor_dispatch {
 } // end namespace strict_variant
 
 #undef STRICT_VARIANT_ASSERT
+#undef STRICT_VARIANT_EXPECT
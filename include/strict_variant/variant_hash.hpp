@@ -6,8 +6,123 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <strict_variant/filter_overloads.hpp>
 #include <strict_variant/variant.hpp>
+#include <type_traits>
+
+#if __cplusplus >= 201703L
+#include <string>
+#include <string_view>
+#endif
+
+namespace strict_variant {
+namespace detail {
+
+/***
+ * Combines the `which` value of a variant with the hash of its value, by
+ * xoring in a large constant per type. So values of different types with the
+ * same hash don't collide, as they did when `31 * which` was added, and the
+ * hashes of the values of each type keep their spread. (With a hash table whose
+ * bucket count is prime, like those of libstdc++, the identity hash of
+ * integers spreads consecutive keys over consecutive buckets, which measures
+ * faster than a hash which mixes them, see `bench/strict_variant_hash.cpp`.)
+ */
+inline std::size_t
+hash_salt(std::uint64_t which) noexcept {
+  return static_cast<std::size_t>(which * 0x9e3779b97f4a7c15ull);
+}
+
+/***
+ * 64-bit finalizer in the style of murmur3, after which every bit of the input
+ * affects every bit of the result. See `mixed_hash`.
+ */
+inline std::size_t
+hash_mix(std::uint64_t h) noexcept {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return static_cast<std::size_t>(h);
+}
+
+/***
+ * Metafunction `is_trivially_hashable`: Whether a value is hashed as its
+ * bytes, which `hash_range` can then read without dispatching on its type.
+ * (For integers and pointers, that is what std::hash does in libstdc++ and
+ * libc++.) Floating point types are not, since 0.0 == -0.0.
+ */
+template <typename T>
+struct is_trivially_hashable
+  : std::integral_constant<bool, (std::is_integral<T>::value || std::is_enum<T>::value
+                                  || std::is_pointer<T>::value)
+                                   && sizeof(T) <= sizeof(std::uint64_t)> {};
+
+// The bytes of `t`, zero-extended
+template <typename T>
+inline std::uint64_t
+trivial_hash_bits(const T & t) noexcept {
+  std::uint64_t x = 0;
+  std::memcpy(&x, &t, sizeof(T));
+  return x;
+}
+
+/***
+ * How `std::hash` of a variant hashes a value of one of its types. A wrapper
+ * is pierced and its value hashed, unless this is specialized for it, e.g. to
+ * use a hash computed in advance.
+ */
+template <typename T, bool = is_wrapper<T>::value, bool = is_trivially_hashable<T>::value>
+struct value_hash {
+  static std::size_t hash(const T & t) { return std::hash<T>{}(t); }
+};
+
+template <typename T>
+struct value_hash<T, false, true> {
+  static std::uint64_t hash(const T & t) noexcept { return trivial_hash_bits(t); }
+};
+
+template <typename T>
+struct value_hash<T, true, false> {
+  static std::size_t hash(const T & t) {
+    return static_cast<std::size_t>(value_hash<typename T::value_type>::hash(t.get()));
+  }
+};
+
+/***
+ * How `variant_transparent_hash` hashes an `Arg` which would be stored as a
+ * `T`, without storing it. This must agree with `value_hash<T>`. By default
+ * the `Arg` is converted to a `T` first, unless it is one. Specialize it for
+ * types whose hash can be computed from the `Arg` directly.
+ */
+template <typename T, typename Arg, typename = void>
+struct raw_value_hash {
+  static std::size_t hash(const Arg & a) { return value_hash<T>::hash(T(a)); }
+};
+
+template <typename T>
+struct raw_value_hash<T, T, void> {
+  static std::size_t hash(const T & t) { return value_hash<T>::hash(t); }
+};
+
+#if __cplusplus >= 201703L
+// A string is hashed like a string_view of its characters
+template <typename C, typename Arg>
+struct raw_value_hash<
+  std::basic_string<C>, Arg,
+  mpl::enable_if_t<!std::is_same<Arg, std::basic_string<C>>::value
+                   && std::is_convertible<const Arg &, std::basic_string_view<C>>::value>> {
+  static std::size_t hash(const Arg & a) {
+    return std::hash<std::basic_string_view<C>>{}(std::basic_string_view<C>(a));
+  }
+};
+#endif
+
+} // end namespace detail
+} // end namespace strict_variant
 
 //- hash support:
 namespace std {
@@ -19,18 +134,125 @@ struct hash<strict_variant::variant<Ts...>> {
   using result_type = std::size_t;
 
 private:
+  // Does not pierce wrappers, see `value_hash`
   struct hasher {
-    using result_type = std::size_t;
+    using result_type = std::uint64_t;
     template <typename Arg>
-    std::size_t operator()(const Arg & arg) const {
-      return std::hash<Arg>{}(arg);
+    std::uint64_t operator()(const Arg & arg) const {
+      return strict_variant::detail::value_hash<Arg>::hash(arg);
     }
   }; // hasher
 
+  using dispatcher_t =
+    strict_variant::detail::visitor_dispatch<strict_variant::detail::true_, sizeof...(Ts),
+                                             typename strict_variant::dispatch_strategy<
+                                               argument_type>::type>;
+
 public:
   std::size_t operator()(const argument_type & v) const {
-    return strict_variant::apply_visitor(hasher{}, v) + (31 * v.which());
+    return static_cast<std::size_t>(dispatcher_t{}(static_cast<unsigned int>(v.which()),
+                                                   argument_type::storage_impl(v), hasher{}))
+           ^ strict_variant::detail::hash_salt(static_cast<std::uint64_t>(v.which()));
   }
 }; // hash<strict_variant::variant<Ts...>>
 
 } // namespace std
+
+namespace strict_variant {
+
+//[ strict_variant_hash_range
+/***
+ * Writes `std::hash` of each variant in `[first, last)` to `out`.
+ *
+ * Values of trivially hashable types are hashed in one branch-free pass,
+ * which reads the first bytes of each variant's storage, masks off the ones
+ * past the end of its value, and combines in its `which` value. Values of the
+ * other types are hashed in a second pass, as by `std::hash`.
+ */
+template <typename... Ts>
+void
+hash_range(const variant<Ts...> * first, const variant<Ts...> * last, std::size_t * out) {
+  using var_t = variant<Ts...>;
+  using storage_t = mpl::remove_reference_t<decltype(var_t::storage_impl(*first))>;
+
+  constexpr std::size_t num_types = sizeof...(Ts);
+  constexpr std::size_t read_size =
+    sizeof(storage_t) < sizeof(std::uint64_t) ? sizeof(storage_t) : sizeof(std::uint64_t);
+  constexpr bool all_trivial = mpl::All_Have<detail::is_trivially_hashable, Ts...>::value;
+
+  // With compact_layout, the which value is in the bytes of the value
+  if (compact_layout<var_t>::value) {
+    for (; first != last; ++first, ++out) {
+      *out = std::hash<var_t>{}(*first);
+    }
+    return;
+  }
+
+  const bool trivial[num_types] = {detail::is_trivially_hashable<Ts>::value...};
+  const std::size_t sizes[num_types] = {
+    (detail::is_trivially_hashable<Ts>::value ? sizeof(Ts) : 0)...};
+
+  // The bytes of a value of each type, within the first `read_size` bytes
+  std::uint64_t masks[num_types];
+  std::size_t salts[num_types];
+  for (std::size_t i = 0; i < num_types; ++i) {
+    unsigned char bytes[sizeof(std::uint64_t)] = {};
+    std::memset(bytes, 0xff, sizes[i]);
+    std::memcpy(&masks[i], bytes, sizeof(std::uint64_t));
+    salts[i] = detail::hash_salt(i);
+  }
+
+  const std::size_t n = static_cast<std::size_t>(last - first);
+  for (std::size_t i = 0; i < n; ++i) {
+    const unsigned int w = static_cast<unsigned int>(first[i].which());
+    std::uint64_t bits = 0;
+    std::memcpy(&bits, var_t::storage_impl(first[i]).address(), read_size);
+    out[i] = static_cast<std::size_t>(bits & masks[w]) ^ salts[w];
+  }
+
+  if (!all_trivial) {
+    for (std::size_t i = 0; i < n; ++i) {
+      if (!trivial[first[i].which()]) { out[i] = std::hash<var_t>{}(first[i]); }
+    }
+  }
+}
+//]
+
+//[ strict_variant_mixed_hash
+/***
+ * `std::hash` of a variant, passed through `hash_mix`. For a hash table whose
+ * bucket count is a power of two, which uses only the low bits of the hash.
+ */
+template <typename V>
+struct mixed_hash {
+  std::size_t operator()(const V & v) const { return detail::hash_mix(std::hash<V>{}(v)); }
+};
+//]
+
+//[ strict_variant_transparent_hash
+/***
+ * `std::hash` of a variant, which also hashes a value that is not a variant,
+ * as a variant constructed from it would hash, without constructing one. The
+ * value must be safely constructible into exactly one of the types, after the
+ * rules of `filter_overloads`. Use with `variant_transparent_equal`.
+ */
+template <typename V>
+struct variant_transparent_hash;
+
+template <typename... Ts>
+struct variant_transparent_hash<variant<Ts...>> {
+  typedef void is_transparent;
+
+  std::size_t operator()(const variant<Ts...> & v) const { return std::hash<variant<Ts...>>{}(v); }
+
+  template <typename Arg, typename Overload = unique_overload<const Arg &, mpl::TypeList<Ts...>>,
+            typename = mpl::enable_if_t<!is_variant<Arg>::value && Overload::value>>
+  std::size_t operator()(const Arg & a) const {
+    using T = unwrap_type_t<mpl::Index_At<mpl::TypeList<Ts...>, Overload::index>>;
+    return static_cast<std::size_t>(detail::raw_value_hash<T, mpl::decay_t<const Arg>>::hash(a))
+           ^ detail::hash_salt(Overload::index);
+  }
+};
+//]
+
+} // end namespace strict_variant
@@ -108,8 +108,9 @@ struct storage {
   }
 
   template <size_t index>
-  unwrap_type_t<value_t<index>> && get_value(detail::false_) && {
-    return std::move(detail::pierce_wrapper(this->get_value<index>(detail::true_{})));
+  auto get_value(detail::false_) && -> decltype(
+    detail::pierce_expiring_wrapper(std::declval<value_t<index> &>())) {
+    return detail::pierce_expiring_wrapper(this->get_value<index>(detail::true_{}));
   }
 };
 
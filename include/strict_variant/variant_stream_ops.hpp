@@ -25,6 +25,9 @@ struct printer_visitor {
     m_ss << t;
   }
 
+  // Prints nothing
+  void operator()(const blank &) const {}
+
 private:
   std::ostream & m_ss;
 };
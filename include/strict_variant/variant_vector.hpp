@@ -0,0 +1,401 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * `variant_vector` is a sequence container of `variant<Types...>` values,
+ * stored "column-wise": the `which` values are kept in a dense array, and the
+ * values themselves in one `std::vector` per type.
+ *
+ * This uses much less memory than `std::vector<variant<...>>` when the types
+ * have different sizes, and `for_each_by_type` can run a visitor over all the
+ * values with no dispatch at all.
+ *
+ * The price is that elements can't change type in place, and iterating in
+ * insertion order needs an indirection through the offset of each element in
+ * its pool.
+ */
+
+#include <strict_variant/mpl/std_traits.hpp>
+#include <strict_variant/mpl/ulist.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_detail.hpp>
+#include <strict_variant/variant_dispatch.hpp>
+#include <strict_variant/variant_storage.hpp>
+#include <strict_variant/wrapper.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace strict_variant {
+
+namespace detail {
+
+/***
+ * `std::vector<bool>` packs its values into bits, and has no `bool &` to give
+ * out, so a pool of `bool` holds these instead.
+ */
+struct pooled_bool {
+  bool value;
+
+  pooled_bool() noexcept
+    : value(false) {}
+  explicit pooled_bool(bool b) noexcept
+    : value(b) {}
+};
+
+template <typename T>
+struct pool_element {
+  using type = T;
+};
+
+template <>
+struct pool_element<bool> {
+  using type = pooled_bool;
+};
+
+// Reports a pool whose offsets would overflow. (Aborts if exceptions are
+// disabled, so that the container can still be used with -fno-exceptions.)
+[[noreturn]] inline void
+variant_vector_pool_full() {
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+  throw std::length_error("strict_variant::variant_vector pool is full");
+#else
+  std::abort();
+#endif
+}
+
+// The value held by an element of a pool
+template <typename T>
+T &
+pooled_value(T & t) noexcept {
+  return t;
+}
+
+inline bool &
+pooled_value(pooled_bool & b) noexcept {
+  return b.value;
+}
+
+inline const bool &
+pooled_value(const pooled_bool & b) noexcept {
+  return b.value;
+}
+
+} // end namespace detail
+
+//[ strict_variant_variant_vector
+template <typename First, typename... Types>
+class variant_vector {
+public:
+  using value_type = variant<First, Types...>;
+  using size_type = std::size_t;
+
+  template <bool is_const>
+  class basic_reference;
+
+  using reference = basic_reference<false>;
+  using const_reference = basic_reference<true>;
+
+private:
+  static constexpr std::size_t num_types = 1 + sizeof...(Types);
+
+  // Index -> type mapping is the same as that of the variant's storage
+  using storage_t = detail::storage<First, Types...>;
+
+  // The element type of the pool of a type, which is itself, unless it is `bool`
+  template <std::size_t index>
+  using pool_value_t =
+    typename detail::pool_element<typename storage_t::template value_t<index>>::type;
+
+  template <typename T>
+  using find_which = detail::find_which<T, First, Types...>;
+
+  using which_t = detail::which_type_t<num_types>;
+  using offset_t = std::uint32_t;
+  using pools_t = std::tuple<std::vector<typename detail::pool_element<First>::type>,
+                             std::vector<typename detail::pool_element<Types>::type>...>;
+
+  /***
+   * Data members
+   */
+  std::vector<which_t> m_tags;
+  std::vector<offset_t> m_offsets;
+  pools_t m_pools;
+
+  /***
+   * Plays the role of a variant's storage for the dispatcher, for the element
+   * at a particular offset in its pool.
+   */
+  template <typename Pools>
+  struct element_storage {
+    Pools & pools;
+    offset_t offset;
+
+    template <std::size_t index>
+    auto get_value(detail::true_) const
+      -> decltype(detail::pooled_value(std::get<index>(pools)[offset])) {
+      return detail::pooled_value(std::get<index>(pools)[offset]);
+    }
+
+    template <std::size_t index>
+    auto get_value(detail::false_) const
+      -> decltype(detail::pierce_wrapper(detail::pooled_value(std::get<index>(pools)[offset]))) {
+      return detail::pierce_wrapper(detail::pooled_value(std::get<index>(pools)[offset]));
+    }
+  };
+
+  template <typename Internal, typename Strategy = typename dispatch_strategy<value_type>::type>
+  using dispatcher_t = detail::visitor_dispatch<Internal, num_types, Strategy>;
+
+  /***
+   * Visitors used to implement push_back and pop_back
+   */
+  struct pusher;
+  struct popper;
+
+  /***
+   * Helper for for_each_by_type
+   */
+  template <typename Pools, typename Visitor, unsigned... us>
+  static void for_each_by_type_impl(Pools & pools, Visitor & visitor, mpl::ulist<us...>) {
+    using swallow = int[];
+    static_cast<void>(swallow{0, (for_each_in_pool(std::get<us>(pools), visitor), 0)...});
+  }
+
+  template <typename Pool, typename Visitor>
+  static void for_each_in_pool(Pool & pool, Visitor & visitor) {
+    for (auto & value : pool) {
+      visitor(detail::pierce_wrapper(detail::pooled_value(value)));
+    }
+  }
+
+public:
+  /***
+   * Size and capacity
+   */
+  size_type size() const noexcept { return m_tags.size(); }
+  bool empty() const noexcept { return m_tags.empty(); }
+
+  // Reserves space for the which values and offsets. The pools grow as needed.
+  void reserve(size_type n) {
+    m_tags.reserve(n);
+    m_offsets.reserve(n);
+  }
+
+  void clear() noexcept {
+    m_tags.clear();
+    m_offsets.clear();
+    m_pools = pools_t{};
+  }
+
+  /***
+   * Insertion at the end. This gives the strong exception-safety guarantee.
+   */
+  template <std::size_t index, typename... Args>
+  reference emplace_back(Args &&... args) {
+    static_assert(index < num_types, "Index out of bounds!");
+
+    auto & pool = std::get<index>(m_pools);
+    if (pool.size() >= static_cast<size_type>(std::numeric_limits<offset_t>::max())) {
+      detail::variant_vector_pool_full();
+    }
+
+    // Makes room for the which value and offset first, so that once the value
+    // is in its pool, nothing can throw. (No try / catch, since some projects
+    // use -fno-exceptions.)
+    if (m_tags.size() == m_tags.capacity() || m_offsets.size() == m_offsets.capacity()) {
+      this->reserve(size() ? 2 * size() : 8);
+    }
+
+    const offset_t offset = static_cast<offset_t>(pool.size());
+    pool.emplace_back(std::forward<Args>(args)...);
+    m_tags.push_back(static_cast<which_t>(index));
+    m_offsets.push_back(offset);
+
+    return (*this)[size() - 1];
+  }
+
+  template <typename T, typename... Args>
+  reference emplace_back(Args &&... args) {
+    return this->emplace_back<find_which<T>::value>(std::forward<Args>(args)...);
+  }
+
+  // Push one of the value types (modulo const and recursive_wrapper)
+  template <typename T, typename = mpl::enable_if_t<
+                          !std::is_same<value_type, mpl::remove_const_t<mpl::remove_reference_t<
+                                                      T>>>::value>>
+  void push_back(T && t) {
+    this->emplace_back<find_which<mpl::remove_reference_t<T>>::value>(std::forward<T>(t));
+  }
+
+  // Push the value contained in a variant
+  void push_back(const value_type & v) { apply_visitor(pusher{*this}, v); }
+  void push_back(value_type && v) { apply_visitor(pusher{*this}, std::move(v)); }
+
+  void pop_back() noexcept {
+    popper p{*this};
+    dispatcher_t<detail::true_>{}(m_tags.back(),
+                                  element_storage<pools_t>{m_pools, m_offsets.back()}, p);
+    m_offsets.pop_back();
+    m_tags.pop_back();
+  }
+
+  /***
+   * Random access, through a proxy which refers to the element
+   */
+  reference operator[](size_type i) noexcept { return reference{this, i}; }
+  const_reference operator[](size_type i) const noexcept { return const_reference{this, i}; }
+
+  reference back() noexcept { return (*this)[size() - 1]; }
+  const_reference back() const noexcept { return (*this)[size() - 1]; }
+
+  /***
+   * Access to the pool of values of one type, in insertion order. A pool of
+   * `bool` holds `detail::pooled_bool`, since `std::vector<bool>` is packed.
+   */
+  template <typename T>
+  const std::vector<pool_value_t<find_which<T>::value>> & pool() const noexcept {
+    return std::get<find_which<T>::value>(m_pools);
+  }
+
+  /***
+   * Apply a visitor to every value, one pool at a time, in order of the types.
+   * Within each pool the values are in insertion order. There is no dispatch
+   * on `which`, the visitor must accept each of the value types.
+   */
+  template <typename Visitor>
+  void for_each_by_type(Visitor && visitor) {
+    for_each_by_type_impl(m_pools, visitor, mpl::count_t<num_types>{});
+  }
+
+  template <typename Visitor>
+  void for_each_by_type(Visitor && visitor) const {
+    for_each_by_type_impl(m_pools, visitor, mpl::count_t<num_types>{});
+  }
+};
+//]
+
+/***
+ * Reference proxy
+ *
+ * Refers to an element of a variant_vector. It can be visited (using
+ * `apply_visitor`, or `visit`), and the value can be obtained using `get`,
+ * or copied out into a variant using `to_variant`. If the reference isn't
+ * const, the value can be modified in place, but it can't change type.
+ *
+ * It is invalidated by any operation that invalidates the pools' iterators.
+ */
+template <typename First, typename... Types>
+template <bool is_const>
+class variant_vector<First, Types...>::basic_reference {
+  friend class variant_vector;
+
+  using container_t = typename std::conditional<is_const, const variant_vector, variant_vector>::type;
+  using pools_ref_t = typename std::conditional<is_const, const pools_t, pools_t>::type;
+
+  container_t * m_container;
+  size_type m_index;
+
+  basic_reference(container_t * c, size_type i) noexcept
+    : m_container(c)
+    , m_index(i) {}
+
+  element_storage<pools_ref_t> storage() const noexcept {
+    return {m_container->m_pools, m_container->m_offsets[m_index]};
+  }
+
+public:
+  // A reference can be converted to a const reference
+  template <bool c = is_const, typename = mpl::enable_if_t<c>>
+  basic_reference(const basic_reference<false> & other) noexcept
+    : m_container(other.m_container)
+    , m_index(other.m_index) {}
+
+  int which() const noexcept { return static_cast<int>(m_container->m_tags[m_index]); }
+
+  // Same semantics as `variant::get`
+  template <typename T>
+  auto get() const noexcept
+    -> decltype(&std::declval<element_storage<pools_ref_t>>().template get_value<find_which<T>::value>(
+      detail::false_{})) {
+    constexpr std::size_t index = find_which<T>::value;
+    if (static_cast<std::size_t>(m_container->m_tags[m_index]) == index) {
+      return &this->storage().template get_value<index>(detail::false_{});
+    } else {
+      return nullptr;
+    }
+  }
+
+  value_type to_variant() const { return apply_visitor(to_variant_visitor{}, *this); }
+
+  // Implementation details for apply_visitor
+  // private:
+#define APPLY_VISITOR_IMPL_BODY                                                                    \
+  dispatcher_t<detail::false_, Strategy>{}(static_cast<unsigned>(visitable.which()),               \
+                                           visitable.storage(), std::forward<Visitor>(visitor))
+
+  // Visitable is assumed to be, forwarding reference to this type.
+  template <typename Strategy = typename dispatch_strategy<value_type>::type, typename Visitor,
+            typename Visitable>
+  static auto apply_visitor_impl(Visitor && visitor,
+                                 Visitable && visitable) noexcept(noexcept(APPLY_VISITOR_IMPL_BODY))
+    -> decltype(APPLY_VISITOR_IMPL_BODY) {
+    return APPLY_VISITOR_IMPL_BODY;
+  }
+
+#undef APPLY_VISITOR_IMPL_BODY
+
+  // public:
+  template <typename V>
+  auto visit(V && v) const -> decltype(apply_visitor(std::forward<V>(v), *this)) {
+    return apply_visitor(std::forward<V>(v), *this);
+  }
+
+private:
+  struct to_variant_visitor {
+    template <typename T>
+    value_type operator()(const T & t) const {
+      return value_type{emplace_tag<T>{}, t};
+    }
+  };
+};
+
+/***
+ * pusher: pushes the value contained in a variant
+ */
+template <typename First, typename... Types>
+struct variant_vector<First, Types...>::pusher {
+  variant_vector & m_self;
+
+  template <typename T>
+  void operator()(T && t) const {
+    m_self.template emplace_back<find_which<mpl::remove_reference_t<T>>::value>(std::forward<T>(t));
+  }
+};
+
+/***
+ * popper: pops the last value of a pool. It is given the (unpierced) last
+ * element, just to learn its type.
+ */
+template <typename First, typename... Types>
+struct variant_vector<First, Types...>::popper {
+  variant_vector & m_self;
+
+  template <typename T>
+  void operator()(T &) const noexcept {
+    std::get<find_which<T>::value>(m_self.m_pools).pop_back();
+  }
+};
+
+} // end namespace strict_variant
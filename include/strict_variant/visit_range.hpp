@@ -0,0 +1,199 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Visitation of a whole range of variants at once.
+ *
+ * Visiting variants one at a time, in a sequence where the types are mixed,
+ * costs a (usually mispredicted) branch per element. `apply_visitor_range`
+ * instead first sorts the elements into buckets by `which`, using a counting
+ * sort, and then runs one loop per type, in which the visitor is always called
+ * with the same type. The dispatch is thus paid once per type, rather than
+ * once per element.
+ */
+
+#include <strict_variant/mpl/std_traits.hpp>
+#include <strict_variant/mpl/ulist.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace strict_variant {
+namespace detail {
+
+template <typename V>
+struct range_num_types;
+
+template <typename... Types>
+struct range_num_types<variant<Types...>> {
+  static constexpr unsigned int value = sizeof...(Types);
+};
+
+/***
+ * The elements of a range, grouped by `which`. Bucket `i` is
+ * `elements[starts[i]] ... elements[starts[i + 1] - 1]`, in their original
+ * order. If requested, `positions` holds the original position of each of them.
+ * (Positions are 32 bits, since writing them is a large part of the cost.)
+ */
+template <typename Ref>
+struct range_buckets {
+  using variant_t = mpl::remove_reference_t<Ref>;
+  using num_types = range_num_types<typename std::remove_cv<variant_t>::type>;
+
+  std::vector<variant_t *> elements;
+  std::vector<std::uint32_t> positions;
+  std::vector<std::size_t> starts;
+
+  template <typename ForwardIt>
+  range_buckets(ForwardIt first, ForwardIt last, bool record_positions)
+    : starts(num_types::value + 1, 0) {
+    // Count the elements of each type
+    std::size_t n = 0;
+    for (ForwardIt it = first; it != last; ++it, ++n) {
+      ++starts[static_cast<std::size_t>(it->which()) + 1];
+    }
+    for (std::size_t i = 0; i < num_types::value; ++i) {
+      starts[i + 1] += starts[i];
+    }
+
+    // Put them in their buckets
+    if (record_positions && n > std::numeric_limits<std::uint32_t>::max()) {
+      throw std::length_error("strict_variant::apply_visitor_range: range is too long");
+    }
+    elements.resize(n);
+    if (record_positions) { positions.resize(n); }
+
+    std::vector<std::size_t> next(starts.begin(), starts.end() - 1);
+    std::size_t pos = 0;
+    for (ForwardIt it = first; it != last; ++it, ++pos) {
+      auto && element = *it;
+      std::size_t & k = next[static_cast<std::size_t>(element.which())];
+      elements[k] = std::addressof(element);
+      if (record_positions) { positions[k] = static_cast<std::uint32_t>(pos); }
+      ++k;
+    }
+  }
+
+  // The value of the k'th element, known to have type `index`
+  template <unsigned index>
+  auto get(std::size_t k) const noexcept
+    -> decltype(variant_t::storage_impl(static_cast<Ref>(*elements[k]))
+                  .template get_value<index>(false_{})) {
+    return variant_t::storage_impl(static_cast<Ref>(*elements[k]))
+      .template get_value<index>(false_{});
+  }
+};
+
+// Visits each bucket in turn, discarding the results
+template <unsigned index, typename Ref, typename Visitor>
+void
+visit_bucket(const range_buckets<Ref> & b, Visitor & visitor) {
+  const std::size_t end = b.starts[index + 1];
+  for (std::size_t k = b.starts[index]; k < end; ++k) {
+    visitor(b.template get<index>(k));
+  }
+}
+
+template <typename Ref, typename Visitor, unsigned... us>
+void
+visit_buckets(const range_buckets<Ref> & b, Visitor & visitor, mpl::ulist<us...>) {
+  using swallow = int[];
+  static_cast<void>(swallow{0, (visit_bucket<us>(b, visitor), 0)...});
+}
+
+// Visits each bucket in turn, storing each result at the original position
+template <unsigned index, typename Ref, typename Visitor, typename RandomIt>
+void
+visit_bucket_into(const range_buckets<Ref> & b, Visitor & visitor, RandomIt results) {
+  const std::size_t end = b.starts[index + 1];
+  for (std::size_t k = b.starts[index]; k < end; ++k) {
+    results[b.positions[k]] = visitor(b.template get<index>(k));
+  }
+}
+
+template <typename Ref, typename Visitor, typename RandomIt, unsigned... us>
+void
+visit_buckets_into(const range_buckets<Ref> & b, Visitor & visitor, RandomIt results,
+                   mpl::ulist<us...>) {
+  using swallow = int[];
+  static_cast<void>(swallow{0, (visit_bucket_into<us>(b, visitor, results), 0)...});
+}
+
+
+// Random access output is written to directly
+template <typename Result, typename Ref, typename Visitor, typename OutputIt>
+OutputIt
+range_output(const range_buckets<Ref> & b, Visitor & visitor, OutputIt out,
+             std::random_access_iterator_tag) {
+  visit_buckets_into(b, visitor, out, mpl::count_t<range_buckets<Ref>::num_types::value>{});
+  return out + static_cast<typename std::iterator_traits<OutputIt>::difference_type>(
+                 b.elements.size());
+}
+
+// Otherwise, results are buffered
+template <typename Result, typename Ref, typename Visitor, typename OutputIt, typename Tag>
+OutputIt
+range_output(const range_buckets<Ref> & b, Visitor & visitor, OutputIt out, Tag) {
+  const std::size_t n = b.elements.size();
+  std::unique_ptr<Result[]> results{new Result[n]()};
+  visit_buckets_into(b, visitor, results.get(), mpl::count_t<range_buckets<Ref>::num_types::value>{});
+  return std::move(results.get(), results.get() + n, out);
+}
+
+} // end namespace detail
+
+//[ strict_variant_apply_visitor_range
+/***
+ * Apply a visitor to each variant in [first, last). The elements are visited
+ * grouped by type, in order of `which`, and in their original order within
+ * each type.
+ *
+ * ForwardIt must be a forward iterator whose reference type is a reference to
+ * a variant.
+ */
+template <typename Visitor, typename ForwardIt>
+void
+apply_visitor_range(Visitor && visitor, ForwardIt first, ForwardIt last) {
+  using ref_t = typename std::iterator_traits<ForwardIt>::reference;
+  using buckets_t = detail::range_buckets<ref_t>;
+
+  const buckets_t buckets{first, last, false};
+  detail::visit_buckets(buckets, visitor, mpl::count_t<buckets_t::num_types::value>{});
+}
+
+/***
+ * Apply a visitor to each variant in [first, last), as above, and write the
+ * results to `out` in the original order of the elements. Returns the output
+ * iterator one past the last result.
+ *
+ * If `out` is not a random access iterator, the results are buffered, and the
+ * (decayed) result type must be default constructible and move assignable.
+ */
+template <typename Visitor, typename ForwardIt, typename OutputIt>
+OutputIt
+apply_visitor_range(Visitor && visitor, ForwardIt first, ForwardIt last, OutputIt out) {
+  using ref_t = typename std::iterator_traits<ForwardIt>::reference;
+  using buckets_t = detail::range_buckets<ref_t>;
+  using result_t = mpl::decay_t<decltype(apply_visitor(visitor, std::declval<ref_t>()))>;
+  static_assert(!std::is_void<result_t>::value,
+                "apply_visitor_range with an output iterator requires a non-void visitor");
+
+  const buckets_t buckets{first, last, true};
+  return detail::range_output<result_t>(buckets, visitor, out,
+                                        typename std::iterator_traits<OutputIt>::iterator_category{});
+}
+//]
+
+} // end namespace strict_variant
@@ -6,6 +6,8 @@
 #pragma once
 
 #include <strict_variant/mpl/std_traits.hpp>
+#include <cstddef>
+#include <cstdint>
 #include <type_traits>
 #include <utility>
 
@@ -26,6 +28,19 @@ struct is_wrapper : std::false_type {};
 } // end namespace detail
 //]
 
+namespace detail {
+
+/***
+ * Trait to identify wrappers whose copies share one value, like
+ * `shared_wrapper`. When a variant holding one is copy assigned, the wrapper
+ * is copied, rather than the value.
+ */
+
+template <typename T>
+struct is_shared_wrapper : std::false_type {};
+
+} // end namespace detail
+
 //[ strict_variant_pierce_wrapper
 namespace detail {
 
@@ -48,6 +63,25 @@ pierce_wrapper(T && t)
   return std::forward<T>(t).get();
 }
 
+/***
+ * Pierces a wrapper whose variant is an rvalue, through the wrapper's `get() &&`.
+ * That moves the value, unless the wrapper can't give it up, as when copies of
+ * an `arena_wrapper` share it.
+ */
+
+template <typename T>
+inline auto
+pierce_expiring_wrapper(T & t) -> mpl::enable_if_t<!is_wrapper<T>::value, T &&> {
+  return std::move(t);
+}
+
+template <typename T>
+inline auto
+pierce_expiring_wrapper(T & t)
+  -> mpl::enable_if_t<is_wrapper<T>::value, decltype(std::move(t).get())> {
+  return std::move(t).get();
+}
+
 } // end namespace detail
   //]
 
@@ -70,5 +104,56 @@ struct unwrap_type<T, true> {
 template <typename T>
 using unwrap_type_t = typename unwrap_type<T>::type;
 
+//[ strict_variant_spare_bits
+/***
+ * Trait which advertises that the low `value` bits of the first pointer-sized
+ * word of `T`'s object representation are spare. That is, `T` masks them out
+ * whenever it uses that word, and leaves them alone when it is moved from.
+ * (Typically that word is a pointer to suitably aligned memory.)
+ *
+ * A variant with `compact_layout` stores its `which` value in these bits.
+ * Specialize this trait for wrappers and other types which meet the
+ * requirements.
+ */
+template <typename T>
+struct spare_bits : std::integral_constant<unsigned int, 0> {};
+//]
+
+namespace detail {
+
+// Number of low bits which are always zero in an address aligned to `align`
+constexpr unsigned int
+alignment_bits(std::size_t align) {
+  return align <= 1 ? 0u : 1u + alignment_bits(align / 2);
+}
+
+/***
+ * A pointer, together with spare low bits which belong to someone else.
+ * Used by the wrappers, so that they can advertise `spare_bits`.
+ * The pointer must be aligned to `align`.
+ */
+template <typename T, std::size_t align>
+class tagged_pointer {
+  std::uintptr_t m_bits;
+
+public:
+  static constexpr unsigned int num_spare_bits = alignment_bits(align);
+  static constexpr std::uintptr_t spare_mask = (std::uintptr_t{1} << num_spare_bits) - 1;
+
+  explicit tagged_pointer(T * t) noexcept
+    : m_bits(reinterpret_cast<std::uintptr_t>(t)) {}
+
+  T * get() const noexcept { return reinterpret_cast<T *>(m_bits & ~spare_mask); }
+
+  // Sets the pointer, keeping the spare bits
+  void set(T * t) noexcept { m_bits = reinterpret_cast<std::uintptr_t>(t) | (m_bits & spare_mask); }
+
+  bool is_aligned(T * t) const noexcept {
+    return (reinterpret_cast<std::uintptr_t>(t) & spare_mask) == 0;
+  }
+};
+
+} // end namespace detail
+
 } // end namespace strict_variant
 
@@ -68,6 +68,146 @@ UNIT_TEST(std_allocator) {
   TEST_EQ(b.which(), 1);
 }
 
+// A variant of alloc_wrapper's can use the compact layout
+
+namespace test_two {
+
+using var_t =
+  variant<alloc_wrapper<A, std::allocator<A>>, alloc_wrapper<std::string, std::allocator<std::string>>>;
+
+} // end namespace test_two
+
+namespace strict_variant {
+
+template <>
+struct compact_layout<test_two::var_t> : std::true_type {};
+
+} // end namespace strict_variant
+
+static_assert(spare_bits<alloc_wrapper<A, std::allocator<A>>>::value >= 3, "failed a unit test");
+static_assert(sizeof(test_two::var_t) == sizeof(void *), "failed a unit test");
+
+UNIT_TEST(compact_std_allocator) {
+  test_two::var_t b = "foo";
+  TEST_EQ(b.which(), 1);
+  b = A{};
+  TEST_EQ(b.which(), 0);
+  test_two::var_t c{b};
+  TEST_EQ(c.which(), 0);
+  b.emplace<std::string>("bar");
+  TEST_EQ(b.which(), 1);
+  c = std::move(b);
+  TEST_EQ(c.which(), 1);
+  TEST_EQ(*get<std::string>(&c), "bar");
+}
+
+// A stateful allocator, which counts the live allocations in its arena
+
+struct arena {
+  int live = 0;
+  int total = 0;
+};
+
+arena default_arena;
+
+template <typename T>
+struct counting_allocator {
+  typedef T value_type;
+
+  arena * m_arena;
+
+  counting_allocator() noexcept
+    : m_arena(&default_arena) {}
+
+  explicit counting_allocator(arena & a) noexcept
+    : m_arena(&a) {}
+
+  template <typename U>
+  counting_allocator(const counting_allocator<U> & other) noexcept
+    : m_arena(other.m_arena) {}
+
+  T * allocate(std::size_t n) {
+    ++m_arena->live;
+    ++m_arena->total;
+    return std::allocator<T>{}.allocate(n);
+  }
+
+  void deallocate(T * p, std::size_t n) noexcept {
+    --m_arena->live;
+    std::allocator<T>{}.deallocate(p, n);
+  }
+};
+
+template <typename T, typename U>
+bool
+operator==(const counting_allocator<T> & a, const counting_allocator<U> & b) noexcept {
+  return a.m_arena == b.m_arena;
+}
+
+template <typename T, typename U>
+bool
+operator!=(const counting_allocator<T> & a, const counting_allocator<U> & b) noexcept {
+  return a.m_arena != b.m_arena;
+}
+
+namespace test_three {
+
+using wrapper_t = alloc_wrapper<std::string, counting_allocator<std::string>>;
+using var_t = variant<int, wrapper_t>;
+
+} // end namespace test_three
+
+// An empty allocator takes no space, a stateful one is stored after the pointer
+static_assert(sizeof(alloc_wrapper<A, std::allocator<A>>) == sizeof(void *), "failed a unit test");
+static_assert(sizeof(test_three::wrapper_t) == 2 * sizeof(void *), "failed a unit test");
+static_assert(spare_bits<test_three::wrapper_t>::value == 0, "failed a unit test");
+
+UNIT_TEST(stateful_allocator) {
+  arena a;
+  {
+    // Constructed from a value, the default allocator is used
+    test_three::var_t v{std::string{"foo"}};
+    TEST_EQ(default_arena.live, 1);
+    TEST_EQ(a.live, 0);
+
+    // With std::allocator_arg, the given allocator is used
+    test_three::var_t w{emplace_tag<std::string>{}, std::allocator_arg,
+                        counting_allocator<std::string>{a}, "bar"};
+    TEST_EQ(*get<std::string>(&w), "bar");
+    TEST_EQ(a.live, 1);
+
+    v.emplace<std::string>(std::allocator_arg, counting_allocator<std::string>{a}, 3u, 'x');
+    TEST_EQ(*get<std::string>(&v), "xxx");
+    TEST_EQ(default_arena.live, 0);
+    TEST_EQ(a.live, 2);
+
+    // Copies use the allocator of the source
+    test_three::var_t c{w};
+    TEST_EQ(a.live, 3);
+    TEST_EQ(default_arena.live, 0);
+
+    // Moving a variant moves the value, into a new allocation from a default
+    // constructed allocator
+    test_three::var_t m{std::move(c)};
+    TEST_EQ(*get<std::string>(&m), "bar");
+    TEST_EQ(a.live, 3);
+    TEST_EQ(default_arena.live, 1);
+
+    m = 5;
+    TEST_EQ(default_arena.live, 0);
+  }
+  TEST_EQ(a.live, 0);
+  TEST_EQ(default_arena.live, 0);
+
+  // Moving a wrapper steals the pointer, and the allocator with it
+  test_three::wrapper_t w{std::allocator_arg, counting_allocator<std::string>{a}, "baz"};
+  TEST_TRUE(w.get_allocator() == counting_allocator<std::string>{a});
+  test_three::wrapper_t w2{std::move(w)};
+  TEST_EQ(a.total, 4);
+  TEST_TRUE(w2.get_allocator() == counting_allocator<std::string>{a});
+  TEST_EQ(w2.get(), "baz");
+}
+
 int
 main() {
 
@@ -0,0 +1,171 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <strict_variant/arena_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+using namespace strict_variant;
+
+struct add;
+struct neg;
+
+using expr = variant<int, arena_wrapper<add>, arena_wrapper<neg>>;
+
+struct add {
+  expr lhs;
+  expr rhs;
+};
+
+struct neg {
+  expr arg;
+};
+
+static_assert(detail::is_wrapper<arena_wrapper<add>>::value, "failed a unit test");
+static_assert(sizeof(arena_wrapper<add>) == 4, "failed a unit test");
+static_assert(sizeof(expr) == 8, "failed a unit test");
+static_assert(std::is_trivially_copyable<expr>::value, "failed a unit test");
+static_assert(std::is_trivially_copyable<add>::value, "failed a unit test");
+
+struct evaluator {
+  int operator()(int i) const { return i; }
+  int operator()(const add & a) const {
+    return apply_visitor(*this, a.lhs) + apply_visitor(*this, a.rhs);
+  }
+  int operator()(const neg & n) const { return -apply_visitor(*this, n.arg); }
+};
+
+int
+eval(const expr & e) {
+  return apply_visitor(evaluator{}, e);
+}
+
+// 1 + -(2 + 3)
+expr
+make_expr() {
+  return expr{add{expr{1}, expr{neg{expr{add{expr{2}, expr{3}}}}}}};
+}
+
+UNIT_TEST(arena_wrapper_basic) {
+  node_arena<add> adds;
+  node_arena<neg> negs;
+  node_arena<add>::scope s1{adds};
+  node_arena<neg>::scope s2{negs};
+
+  const expr e = make_expr();
+  TEST_EQ(eval(e), -4);
+  TEST_EQ(adds.size(), 2u);
+  TEST_EQ(negs.size(), 1u);
+
+  // Copies share the node
+  expr f{e};
+  TEST_TRUE(get<add>(&f) == get<add>(&e));
+  TEST_EQ(adds.size(), 2u);
+
+  // Assigning a value makes a new node
+  f = add{expr{5}, expr{6}};
+  TEST_EQ(eval(f), 11);
+  TEST_EQ(eval(e), -4);
+  TEST_EQ(adds.size(), 3u);
+
+  // Mutable access changes the node, for every copy
+  const expr g{f};
+  get<add>(&f)->lhs = 7;
+  TEST_EQ(eval(g), 13);
+}
+
+UNIT_TEST(arena_wrapper_scope) {
+  node_arena<add> outer;
+  node_arena<add> inner;
+  node_arena<neg> negs;
+  node_arena<neg>::scope s{negs};
+
+  node_arena<add>::scope s1{outer};
+  {
+    node_arena<add>::scope s2{inner};
+    TEST_TRUE(node_arena<add>::current() == &inner);
+    expr e{add{expr{1}, expr{2}}};
+    TEST_EQ(inner.size(), 1u);
+  }
+  TEST_TRUE(node_arena<add>::current() == &outer);
+  TEST_EQ(outer.size(), 0u);
+}
+
+// The nodes are trivially copyable, and the indices mean the same thing in a copy
+UNIT_TEST(arena_wrapper_memcpy) {
+  node_arena<add> adds;
+  node_arena<neg> negs;
+  expr e;
+  {
+    node_arena<add>::scope s1{adds};
+    node_arena<neg>::scope s2{negs};
+    e = make_expr();
+  }
+
+  node_arena<add> adds_copy;
+  node_arena<neg> negs_copy;
+  for (std::size_t i = 0; i < adds.size(); ++i) {
+    adds_copy.emplace();
+  }
+  negs_copy.emplace();
+  std::memcpy(adds_copy.data(), adds.data(), adds.size() * sizeof(add));
+  std::memcpy(negs_copy.data(), negs.data(), negs.size() * sizeof(neg));
+  adds.clear();
+  negs.clear();
+
+  expr e_copy;
+  std::memcpy(&e_copy, &e, sizeof(expr));
+
+  node_arena<add>::scope s1{adds_copy};
+  node_arena<neg>::scope s2{negs_copy};
+  TEST_EQ(eval(e_copy), -4);
+}
+
+// Nodes which own memory, to check that visiting an rvalue doesn't move them
+struct named;
+
+using named_expr = variant<int, arena_wrapper<named>>;
+
+struct named {
+  std::string name;
+  named_expr arg;
+};
+
+struct sink_by_value {
+  std::string operator()(int) const { return ""; }
+  std::string operator()(named n) const { return n.name; }
+};
+
+struct is_const_ref {
+  bool operator()(int &&) const { return false; }
+  bool operator()(const named &) const { return true; }
+};
+
+UNIT_TEST(arena_wrapper_rvalue_visit) {
+  node_arena<named> nodes;
+  node_arena<named>::scope s{nodes};
+
+  const named_expr a{named{std::string(40, 'x'), named_expr{1}}};
+  named_expr b{a};
+  TEST_EQ(apply_visitor(sink_by_value{}, std::move(b)), std::string(40, 'x'));
+  TEST_EQ(get<named>(&a)->name, std::string(40, 'x'));
+
+  named_expr c{a};
+  TEST_TRUE(apply_visitor(is_const_ref{}, std::move(c)));
+}
+
+int
+main() {
+  std::cout << "Arena wrapper tests:" << std::endl;
+  return test_registrar::run_tests();
+}
@@ -0,0 +1,199 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <strict_variant/atomic_variant.hpp>
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace strict_variant;
+
+enum class error_code : std::uint8_t { none, timeout, refused };
+
+struct pair32 {
+  std::int32_t a;
+  std::int32_t b;
+
+  bool operator==(const pair32 & o) const { return a == o.a && b == o.b; }
+};
+
+struct triple64 {
+  std::int64_t x;
+  std::int64_t y;
+  std::int64_t z;
+
+  bool operator==(const triple64 & o) const { return x == o.x && y == o.y && z == o.z; }
+};
+
+// One word, two words, and four words
+using small_t = variant<std::int32_t, float, error_code>;
+using medium_t = variant<std::int8_t, std::int64_t, pair32>;
+using large_t = variant<std::int8_t, std::int64_t, triple64>;
+
+static_assert(sizeof(small_t) == 8, "failed a unit test");
+static_assert(sizeof(medium_t) == 16, "failed a unit test");
+static_assert(sizeof(large_t) == 32, "failed a unit test");
+
+static_assert(atomic_variant<std::int32_t, float, error_code>::is_always_lock_free,
+              "failed a unit test");
+static_assert(!atomic_variant<std::int8_t, std::int64_t, triple64>::is_always_lock_free,
+              "failed a unit test");
+
+// Integer types are ambiguous for the constructor
+template <typename V, typename T>
+V
+make(T t) {
+  V v;
+  v.template emplace<T>(t);
+  return v;
+}
+
+template <typename A>
+struct atomic_of;
+
+template <typename... Ts>
+struct atomic_of<variant<Ts...>> {
+  using type = atomic_variant<Ts...>;
+};
+
+template <typename V>
+using atomic_t = typename atomic_of<V>::type;
+
+UNIT_TEST(atomic_variant_load_store) {
+  atomic_t<small_t> s;
+  TEST_TRUE(s.load() == small_t{0});
+  s.store(small_t{1.5f});
+  TEST_TRUE(s.load() == small_t{1.5f});
+  TEST_TRUE(s.exchange(small_t{error_code::timeout}) == small_t{1.5f});
+  TEST_TRUE(s.load() == small_t{error_code::timeout});
+
+  atomic_t<medium_t> m{make<medium_t>(pair32{3, 4})};
+  const medium_t pair = m.load();
+  TEST_TRUE(get<pair32>(&pair)->b == 4);
+  m.store(make<medium_t>(std::int64_t{-5}));
+  TEST_TRUE(m.load() == make<medium_t>(std::int64_t{-5}));
+  TEST_TRUE(m.exchange(make<medium_t>(std::int8_t{7})) == make<medium_t>(std::int64_t{-5}));
+  TEST_TRUE(m.load() == make<medium_t>(std::int8_t{7}));
+
+  atomic_t<large_t> l;
+  l.store(make<large_t>(triple64{1, 2, 3}));
+  const large_t triple = l.load();
+  TEST_TRUE(get<triple64>(&triple)->z == 3);
+  TEST_TRUE(l.exchange(make<large_t>(std::int8_t{9})).which() == 2);
+  TEST_TRUE(l.load() == make<large_t>(std::int8_t{9}));
+}
+
+template <typename V, typename T, typename U>
+void
+check_compare_exchange(T t, U u) {
+  atomic_t<V> a{make<V>(t)};
+
+  V expected = make<V>(u);
+  TEST_FALSE(a.compare_exchange_strong(expected, make<V>(u)));
+  TEST_TRUE(expected == make<V>(t));
+
+  TEST_TRUE(a.compare_exchange_strong(expected, make<V>(u)));
+  TEST_TRUE(a.load() == make<V>(u));
+
+  // The bytes of the storage past an `int8_t`, and the padding, are not
+  // compared: here they are left over from `t`
+  V leftover = make<V>(t);
+  leftover.template emplace<std::int8_t>(std::int8_t{1});
+  a.store(leftover);
+  expected = make<V>(std::int8_t{1});
+  TEST_TRUE(a.compare_exchange_strong(expected, make<V>(t)));
+
+  expected = make<V>(t);
+  while (!a.compare_exchange_weak(expected, make<V>(u))) {
+    TEST_TRUE(expected == make<V>(t));
+  }
+  TEST_TRUE(a.load() == make<V>(u));
+}
+
+UNIT_TEST(atomic_variant_compare_exchange) {
+  {
+    atomic_t<small_t> a{small_t{0.0f}};
+    small_t expected{-0.0f};
+    TEST_FALSE(a.compare_exchange_strong(expected, small_t{1}));
+    TEST_TRUE(a.compare_exchange_strong(expected, small_t{1}));
+    TEST_TRUE(a.load() == small_t{1});
+  }
+
+  check_compare_exchange<medium_t>(std::int64_t{-1}, pair32{1, 2});
+  check_compare_exchange<large_t>(triple64{-1, -2, -3}, std::int64_t{4});
+}
+
+// Each thread adds to the value many times, with compare-and-swap loops,
+// alternating between the two integer types
+template <typename V, typename Small, typename Big>
+void
+check_contention() {
+  constexpr int num_threads = 4;
+  constexpr int num_adds = 20000;
+
+  atomic_t<V> a{make<V>(Small{0})};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&a]() {
+      for (int n = 0; n < num_adds; ++n) {
+        V expected = a.load();
+        V desired;
+        do {
+          const Big current = get<Small>(&expected) ? Big{*get<Small>(&expected)}
+                                                    : *get<Big>(&expected);
+          if (current < 100) {
+            desired = make<V>(static_cast<Small>(current + 1));
+          } else {
+            desired = make<V>(static_cast<Big>(current + 1));
+          }
+        } while (!a.compare_exchange_weak(expected, desired));
+      }
+    });
+  }
+  for (std::thread & t : threads) {
+    t.join();
+  }
+
+  TEST_TRUE(a.load() == make<V>(Big{num_threads * num_adds}));
+}
+
+UNIT_TEST(atomic_variant_contention) {
+  check_contention<small_t, std::int32_t, std::int32_t>();
+  check_contention<medium_t, std::int8_t, std::int64_t>();
+  check_contention<large_t, std::int8_t, std::int64_t>();
+}
+
+// A reader never sees a value which was only partly written
+UNIT_TEST(atomic_variant_torn_reads) {
+  atomic_t<large_t> a{make<large_t>(triple64{0, 0, 0})};
+  std::thread writer([&a]() {
+    for (std::int64_t i = 1; i <= 20000; ++i) {
+      a.store(make<large_t>(triple64{i, -i, i}));
+      a.store(make<large_t>(std::int8_t{static_cast<std::int8_t>(i)}));
+    }
+  });
+
+  bool consistent = true;
+  for (int n = 0; n < 20000; ++n) {
+    const large_t v = a.load();
+    if (const triple64 * t = get<triple64>(&v)) {
+      consistent = consistent && t->y == -t->x && t->z == t->x;
+    }
+  }
+  writer.join();
+  TEST_TRUE(consistent);
+}
+
+int
+main() {
+  std::cout << "Atomic variant tests:" << std::endl;
+  return test_registrar::run_tests();
+}
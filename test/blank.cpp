@@ -0,0 +1,210 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <strict_variant/extract.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_hash.hpp>
+#include <strict_variant/variant_stream_ops.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace strict_variant;
+
+// Has a throwing move, and a ctor which throws on request
+struct fragile {
+  static int copies;
+
+  std::string s;
+
+  explicit fragile(std::string str)
+    : s(std::move(str)) {
+    if (s == "throw") { throw std::runtime_error{"fragile"}; }
+  }
+  fragile(const fragile & other)
+    : s(other.s) {
+    ++copies;
+  }
+  fragile(fragile && other) noexcept(false)
+    : s(std::move(other.s)) {}
+  fragile & operator=(const fragile &) = default;
+  fragile & operator=(fragile && other) noexcept(false) {
+    s = std::move(other.s);
+    return *this;
+  }
+};
+
+int fragile::copies = 0;
+
+// Whether calling `f` throws
+template <typename F>
+bool
+throws(F && f) {
+  try {
+    f();
+  } catch (std::runtime_error &) { return true; }
+  return false;
+}
+
+static_assert(!std::is_nothrow_move_constructible<fragile>::value, "failed a unit test");
+
+// Held in place, and assignable, since it can fall back to blank
+using inline_t = variant<blank, int, fragile>;
+
+static_assert(std::is_same<typename std::remove_reference<decltype(
+                             *get<fragile>(static_cast<inline_t *>(nullptr)))>::type,
+                           fragile>::value,
+              "failed a unit test");
+static_assert(std::is_move_assignable<inline_t>::value, "failed a unit test");
+static_assert(!std::is_nothrow_move_constructible<inline_t>::value, "failed a unit test");
+
+// Wrapped, and then moved by pointer
+using easy_t = easy_variant<blank, std::string, fragile>;
+
+static_assert(pointer_move<easy_t>::value, "failed a unit test");
+static_assert(std::is_nothrow_move_constructible<easy_t>::value, "failed a unit test");
+static_assert(std::is_nothrow_move_assignable<easy_t>::value, "failed a unit test");
+static_assert(!std::is_nothrow_move_constructible<easy_variant<std::string, fragile>>::value,
+              "failed a unit test");
+
+// blank is preferred as the fallback value
+static_assert(detail::extract_fallback<int, recursive_wrapper<fragile>, blank>::value == 2,
+              "failed a unit test");
+
+UNIT_TEST(blank_fallback_on_throw) {
+  inline_t v{5};
+  TEST_TRUE(throws([&v]() { v.emplace<fragile>("throw"); }));
+  TEST_EQ(v.which(), 0);
+
+  v = fragile{"foo"};
+  TEST_EQ(get<fragile>(&v)->s, "foo");
+
+  v = 5;
+  TEST_TRUE(throws([&v]() { v = fragile{"throw"}; }));
+  TEST_EQ(v.which(), 1);
+
+  // Constructed in place
+  v.emplace<fragile>("bar");
+  TEST_EQ(get<fragile>(&v)->s, "bar");
+  TEST_TRUE(throws([&v]() { v.emplace<fragile>("throw"); }));
+  TEST_EQ(v.which(), 0);
+}
+
+UNIT_TEST(blank_pointer_move) {
+  easy_t a{fragile{"foo"}};
+  const fragile * address = get<fragile>(&a);
+
+  easy_t b{std::move(a)};
+  TEST_TRUE(get<fragile>(&b) == address);
+  TEST_EQ(a.which(), 0);
+
+  // Not the first nothrow default constructible type
+  using var_t = variant<int, blank, recursive_wrapper<fragile>>;
+  var_t c{fragile{"bar"}};
+  var_t d{std::move(c)};
+  TEST_EQ(c.which(), 1);
+  TEST_EQ(get<fragile>(&d)->s, "bar");
+
+  struct {
+    void operator()(std::unique_ptr<fragile> &&) const {}
+    void operator()(int &&) const {}
+    void operator()(blank &&) const {}
+  } vis;
+  apply_visitor_extract(vis, std::move(d));
+  TEST_EQ(d.which(), 1);
+}
+
+// A tree node, whose children are moved by pointer because of blank
+struct tree_node;
+using tree_t = variant<blank, int, recursive_wrapper<tree_node>>;
+
+struct tree_node {
+  tree_t child;
+  std::string name;
+};
+
+static_assert(pointer_move<tree_t>::value, "failed a unit test");
+
+UNIT_TEST(blank_pointer_move_aliasing) {
+  tree_node leaf;
+  leaf.child = 2;
+  leaf.name = "leaf";
+  tree_node root;
+  root.child = std::move(leaf);
+  root.name = "root";
+  tree_t t{std::move(root)};
+  const tree_node * address = get<tree_node>(&get<tree_node>(&t)->child);
+
+  // Replace a node with its own child
+  t = std::move(get<tree_node>(&t)->child);
+  TEST_TRUE(get<tree_node>(&t) == address);
+  TEST_EQ(get<tree_node>(&t)->name, "leaf");
+  TEST_EQ(*get<int>(&get<tree_node>(&t)->child), 2);
+}
+
+// A node named by a string, which is one of the variant's types
+struct named_node;
+using named_t = variant<blank, std::string, recursive_wrapper<named_node>>;
+
+struct named_node {
+  named_t child;
+  std::string name;
+};
+
+UNIT_TEST(blank_copy_aliasing) {
+  named_node n;
+  n.child = std::string{"child"};
+  n.name = std::string(100, 'x');
+  named_t v{std::move(n)};
+
+  // Replace a node with a copy of its name
+  v = get<named_node>(&v)->name;
+  TEST_EQ(*get<std::string>(&v), std::string(100, 'x'));
+
+  // And with a copy of its child
+  named_node m;
+  m.child = std::string{"child"};
+  v = std::move(m);
+  v = get<named_node>(&v)->child;
+  TEST_EQ(*get<std::string>(&v), "child");
+}
+
+UNIT_TEST(blank_vector_growth) {
+  std::vector<easy_t> vec;
+  fragile::copies = 0;
+  for (int i = 0; i < 100; ++i) {
+    vec.emplace_back(fragile{"foo"});
+  }
+  TEST_EQ(fragile::copies, 0);
+  TEST_EQ(get<fragile>(&vec.back())->s, "foo");
+}
+
+UNIT_TEST(blank_ops) {
+  TEST_TRUE(blank{} == blank{});
+  TEST_TRUE(!(blank{} < blank{}));
+
+  inline_t v;
+  TEST_EQ(v.which(), 0);
+
+  std::ostringstream ss;
+  ss << variant<blank, int>{} << variant<blank, int>{5};
+  TEST_EQ(ss.str(), "5");
+
+  using hash_t = std::hash<variant<blank, int>>;
+  TEST_EQ(hash_t{}(variant<blank, int>{}), hash_t{}(variant<blank, int>{}));
+}
+
+int
+main() {
+  std::cout << "Blank tests:" << std::endl;
+  return test_registrar::run_tests();
+}
@@ -0,0 +1,124 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <strict_variant/alloc_wrapper.hpp>
+#include <strict_variant/compact_variant.hpp>
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+using namespace strict_variant;
+
+static_assert(detail::size_median<4>::value == 4, "failed a unit test");
+static_assert(detail::size_median<8, 1, 200>::value == 8, "failed a unit test");
+static_assert(detail::size_median<8, 1, 200, 8>::value == 8, "failed a unit test");
+static_assert(detail::size_median<16, 4, 8, 200>::value == 8, "failed a unit test");
+static_assert(detail::size_min<16, 4, 8, 200>::value == 4, "failed a unit test");
+
+// Messages, with a rare large payload
+struct ping {
+  std::uint32_t seq;
+};
+
+struct ack {
+  std::uint32_t seq;
+  std::uint32_t status;
+};
+
+struct snapshot {
+  char data[200];
+};
+
+using plain_t = variant<ping, ack, snapshot>;
+using compact_t = compact_variant<ping, ack, snapshot>;
+
+static_assert(std::is_same<compact_t, variant<ping, ack, recursive_wrapper<snapshot>>>::value,
+              "failed a unit test");
+static_assert(sizeof(compact_t) * 8 < sizeof(plain_t), "failed a unit test");
+
+// Budget
+static_assert(std::is_same<bounded_variant<100>::type<ping, snapshot>,
+                           variant<ping, recursive_wrapper<snapshot>>>::value,
+              "failed a unit test");
+static_assert(std::is_same<bounded_variant<200>::type<ping, snapshot>,
+                           variant<ping, snapshot>>::value,
+              "failed a unit test");
+
+// Not larger than the wrapper, so not wrapped
+static_assert(std::is_same<bounded_variant<1>::type<ping, ack>, variant<ping, ack>>::value,
+              "failed a unit test");
+
+// Throwing moves are still wrapped, and wrapped types are left alone
+struct throwing_move {
+  throwing_move() = default;
+  throwing_move(throwing_move &&) noexcept(false) {}
+};
+
+static_assert(std::is_same<bounded_variant<1000>::type<int, throwing_move>,
+                           variant<int, recursive_wrapper<throwing_move>>>::value,
+              "failed a unit test");
+static_assert(std::is_same<compact_variant<int, recursive_wrapper<snapshot>>,
+                           variant<int, recursive_wrapper<snapshot>>>::value,
+              "failed a unit test");
+
+// Other wrappers
+template <typename T>
+using std_alloc_wrapper = alloc_wrapper<T, std::allocator<T>>;
+
+static_assert(
+  std::is_same<median_bounded_variant<4, std_alloc_wrapper>::type<ping, ack, snapshot>,
+               variant<ping, ack, alloc_wrapper<snapshot, std::allocator<snapshot>>>>::value,
+  "failed a unit test");
+
+// Layout report
+using report_t = layout_report<plain_t>;
+
+static_assert(report_t::num_types == 3, "failed a unit test");
+static_assert(report_t::size == sizeof(plain_t), "failed a unit test");
+static_assert(report_t::sizes[1] == sizeof(ack), "failed a unit test");
+static_assert(report_t::wasted(0) == sizeof(plain_t) - sizeof(ping), "failed a unit test");
+static_assert(report_t::max_wasted == report_t::wasted(0), "failed a unit test");
+static_assert(report_t::min_wasted == report_t::wasted(2), "failed a unit test");
+static_assert(layout_report<compact_t>::wrapped[2], "failed a unit test");
+static_assert(layout_report<compact_t>::max_wasted < report_t::min_wasted + 16,
+              "failed a unit test");
+
+UNIT_TEST(compact_variant) {
+  compact_t v{snapshot{}};
+  get<snapshot>(&v)->data[0] = 'x';
+  compact_t w{v};
+  TEST_EQ(get<snapshot>(&w)->data[0], 'x');
+
+  w = ack{1, 2};
+  TEST_EQ(get<ack>(&w)->status, 2u);
+}
+
+UNIT_TEST(layout_report) {
+  std::ostringstream ss;
+  layout_report<variant<std::uint32_t, recursive_wrapper<snapshot>>>::print(ss);
+
+  std::ostringstream expected;
+  const std::size_t size = sizeof(variant<std::uint32_t, recursive_wrapper<snapshot>>);
+  const std::size_t wrapper_size = sizeof(recursive_wrapper<snapshot>);
+  expected << "variant of 2 types: " << size << " bytes, " << size - wrapper_size << " to "
+           << size - 4 << " wasted\n"
+           << "  0: 4 bytes, " << size - 4 << " wasted\n"
+           << "  1: " << wrapper_size << " bytes (wrapped), " << size - wrapper_size
+           << " wasted\n";
+  TEST_EQ(ss.str(), expected.str());
+}
+
+int
+main() {
+  std::cout << "Compact variant tests:" << std::endl;
+  return test_registrar::run_tests();
+}
@@ -9,6 +9,7 @@
 
 #include "test_harness/test_harness.hpp"
 
+#include <cstdint>
 #include <functional>
 #include <set>
 #include <string>
@@ -79,6 +80,54 @@ UNIT_TEST(std_less_specialization_example) {
   TEST_FALSE(s.count(var_t(70)));
 }
 
+UNIT_TEST(three_way_compare) {
+  TEST_EQ(three_way_compare(var_t{"asdf"}, var_t{"asdf"}), 0);
+  TEST_TRUE(three_way_compare(var_t{"asdf"}, var_t{"jkl;"}) < 0);
+  TEST_TRUE(three_way_compare(var_t{"jkl;"}, var_t{"asdf"}) > 0);
+  TEST_TRUE(three_way_compare(var_t{"jkl;"}, var_t{0}) < 0);
+  TEST_TRUE(three_way_compare(var_t{1}, var_t{0}) > 0);
+  TEST_TRUE(three_way_compare(var_t{0}, var_t{"asdf"}) > 0);
+}
+
+// Wrapped values are compared by value
+UNIT_TEST(compare_wrapped) {
+  using wvar_t = variant<int, recursive_wrapper<std::string>>;
+  variant_comparator<wvar_t> less;
+
+  TEST_TRUE(less(wvar_t{1}, wvar_t{std::string{"a"}}));
+  TEST_TRUE(less(wvar_t{std::string{"a"}}, wvar_t{std::string{"b"}}));
+  TEST_TRUE(!less(wvar_t{std::string{"b"}}, wvar_t{std::string{"a"}}));
+  TEST_TRUE(wvar_t{std::string{"a"}} == wvar_t{std::string{"a"}});
+  TEST_TRUE(wvar_t{std::string{"a"}} != wvar_t{std::string{"b"}});
+  TEST_EQ(three_way_compare(wvar_t{std::string{"b"}}, wvar_t{std::string{"a"}}), 1);
+}
+
+// A struct without padding, which is compared by its bytes
+struct point {
+  std::int32_t x;
+  std::int32_t y;
+};
+
+namespace strict_variant {
+namespace detail {
+
+template <>
+struct is_trivially_comparable<point> : std::true_type {};
+
+} // end namespace detail
+} // end namespace strict_variant
+
+UNIT_TEST(trivially_comparable) {
+  using pvar_t = variant<int, point, const int *>;
+  static const int x = 0;
+
+  TEST_TRUE((pvar_t{point{1, 2}} == pvar_t{point{1, 2}}));
+  TEST_TRUE((pvar_t{point{1, 2}} != pvar_t{point{1, 3}}));
+  TEST_TRUE(pvar_t{&x} == pvar_t{&x});
+  TEST_TRUE(pvar_t{-1} != pvar_t{1});
+  TEST_TRUE((pvar_t{1} != pvar_t{point{1, 0}}));
+}
+
 int
 main() {
 
@@ -0,0 +1,247 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <strict_variant/alloc_wrapper.hpp>
+#include <strict_variant/arena_wrapper.hpp>
+#include <strict_variant/extract.hpp>
+#include <strict_variant/intern.hpp>
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/shared_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace strict_variant;
+
+using var_t = variant<int, recursive_wrapper<std::string>, double>;
+
+static_assert(detail::extract_fallback<recursive_wrapper<std::string>, std::string, int>::value == 1,
+              "failed a unit test");
+static_assert(!detail::extract_fallback<recursive_wrapper<std::string>>::found, "failed a unit test");
+
+// Records what it was given
+struct take_visitor {
+  std::string * taken;
+  std::unique_ptr<std::string> * owned;
+
+  int operator()(int && i) const { return i; }
+  int operator()(double &&) const { return -1; }
+  int operator()(std::unique_ptr<std::string> && p) const {
+    *taken = *p;
+    *owned = std::move(p);
+    return -2;
+  }
+};
+
+UNIT_TEST(extract_wrapped) {
+  std::string taken;
+  std::unique_ptr<std::string> owned;
+  take_visitor vis{&taken, &owned};
+
+  var_t v{std::string{"foo"}};
+  const std::string * address = get<std::string>(&v);
+
+  TEST_EQ(apply_visitor_extract(vis, std::move(v)), -2);
+  TEST_EQ(taken, "foo");
+
+  // The allocation was handed over, and the variant was left holding an int
+  TEST_TRUE(owned.get() == address);
+  TEST_EQ(v.which(), 0);
+  TEST_EQ(*get<int>(&v), 0);
+
+  // And it can be put back, without allocating
+  v.emplace<std::string>(std::move(owned));
+  TEST_TRUE(get<std::string>(&v) == address);
+  TEST_FALSE(owned);
+  TEST_EQ(*get<std::string>(&v), "foo");
+
+  var_t w{emplace_tag<std::string>{}, std::unique_ptr<std::string>{new std::string{"bar"}}};
+  TEST_EQ(*get<std::string>(&w), "bar");
+}
+
+UNIT_TEST(extract_inline) {
+  std::string taken;
+  std::unique_ptr<std::string> owned;
+  take_visitor vis{&taken, &owned};
+
+  var_t v{5};
+  TEST_EQ(apply_visitor_extract(vis, std::move(v)), 5);
+  TEST_EQ(v.which(), 0);
+
+  v = 1.5;
+  TEST_EQ(apply_visitor_extract(vis, std::move(v)), -1);
+  TEST_EQ(v.which(), 2);
+  TEST_TRUE(taken.empty());
+}
+
+// A visitor may assign to the source variant, which already holds the fallback
+
+struct node;
+
+using tree_t = variant<int, recursive_wrapper<node>>;
+
+struct node {
+  tree_t left;
+  tree_t right;
+};
+
+int
+sum(const tree_t & t) {
+  if (const int * i = get<int>(&t)) { return *i; }
+  const node & n = *get<node>(&t);
+  return sum(n.left) + sum(n.right);
+}
+
+// Puts an extracted value into a variant, without allocating
+struct put_back {
+  tree_t & target;
+
+  void operator()(int && i) const { target = i; }
+  void operator()(std::unique_ptr<node> && n) const { target.emplace<node>(std::move(n)); }
+};
+
+UNIT_TEST(extract_subtree) {
+  tree_t t{emplace_tag<node>{}};
+  get<node>(&t)->left.emplace<node>();
+  node & l = *get<node>(&get<node>(&t)->left);
+  l.left = 1;
+  l.right = 2;
+  get<node>(&t)->right = 4;
+  TEST_EQ(sum(t), 7);
+
+  const node * left_address = &l;
+
+  // Move the left subtree to the top, without allocating. (The old top node
+  // is freed when the visitor returns.)
+  struct {
+    tree_t & target;
+
+    void operator()(int &&) const {}
+    void operator()(std::unique_ptr<node> && top) const {
+      apply_visitor_extract(put_back{target}, std::move(top->left));
+    }
+  } lift{t};
+  apply_visitor_extract(lift, std::move(t));
+
+  TEST_EQ(sum(t), 3);
+  TEST_TRUE(get<node>(&t) == left_address);
+}
+
+// alloc_wrapper hands over its allocator in the deleter
+
+struct count_allocs {
+  static int live;
+};
+
+int count_allocs::live = 0;
+
+template <typename T>
+struct counting_allocator {
+  typedef T value_type;
+
+  counting_allocator() = default;
+  template <typename U>
+  counting_allocator(const counting_allocator<U> &) {}
+
+  T * allocate(std::size_t n) {
+    ++count_allocs::live;
+    return std::allocator<T>{}.allocate(n);
+  }
+  void deallocate(T * p, std::size_t n) {
+    --count_allocs::live;
+    std::allocator<T>{}.deallocate(p, n);
+  }
+};
+
+UNIT_TEST(extract_alloc_wrapper) {
+  using wrapper_t = alloc_wrapper<std::string, counting_allocator<std::string>>;
+  using avar_t = variant<int, wrapper_t>;
+  {
+    avar_t v{std::string{"foo"}};
+    TEST_EQ(count_allocs::live, 1);
+
+    wrapper_t::unique_ptr_type p;
+    struct {
+      wrapper_t::unique_ptr_type & p;
+      void operator()(int &&) const {}
+      void operator()(wrapper_t::unique_ptr_type && q) const { p = std::move(q); }
+    } vis{p};
+    apply_visitor_extract(vis, std::move(v));
+    TEST_EQ(v.which(), 0);
+    TEST_EQ(count_allocs::live, 1);
+    TEST_EQ(*p, "foo");
+
+    v.emplace<std::string>(std::move(p));
+    TEST_EQ(count_allocs::live, 1);
+    TEST_EQ(*get<std::string>(&v), "foo");
+
+    apply_visitor_extract(vis, std::move(v));
+    TEST_EQ(count_allocs::live, 1);
+  }
+  TEST_EQ(count_allocs::live, 0);
+}
+
+// Wrappers which can't release their value pass it as an rvalue visit does
+
+using shared_var_t = variant<int, recursive_wrapper<std::string>, shared_wrapper<std::vector<int>>,
+                             interned<std::wstring>, arena_wrapper<double>>;
+
+static_assert(detail::is_releasable_wrapper<recursive_wrapper<std::string>>::value,
+              "failed a unit test");
+static_assert(!detail::is_releasable_wrapper<shared_wrapper<std::vector<int>>>::value,
+              "failed a unit test");
+static_assert(!detail::is_releasable_wrapper<std::unique_ptr<int>>::value, "failed a unit test");
+
+struct shared_take_visitor {
+  int operator()(int && i) const { return i; }
+  int operator()(std::unique_ptr<std::string> && p) const { return static_cast<int>(p->size()); }
+  int operator()(std::vector<int> && v) const {
+    std::vector<int> taken{std::move(v)};
+    return static_cast<int>(taken.size());
+  }
+  int operator()(std::wstring && w) const {
+    std::wstring taken{std::move(w)};
+    return static_cast<int>(taken.size());
+  }
+  int operator()(const double & d) const { return static_cast<int>(d); }
+};
+
+UNIT_TEST(extract_unreleasable) {
+  node_arena<double> arena;
+  node_arena<double>::scope s{arena};
+
+  shared_var_t v{emplace_tag<int>{}, 5};
+  TEST_EQ(apply_visitor_extract(shared_take_visitor{}, std::move(v)), 5);
+
+  v.emplace<std::string>("foo");
+  TEST_EQ(apply_visitor_extract(shared_take_visitor{}, std::move(v)), 3);
+  TEST_EQ(v.which(), 0);
+
+  // A shared value is copied before it is moved from
+  v.emplace<std::vector<int>>(4u, 1);
+  const shared_var_t copy{v};
+  TEST_EQ(apply_visitor_extract(shared_take_visitor{}, std::move(v)), 4);
+  TEST_EQ(v.which(), 2);
+  TEST_EQ(get<std::vector<int>>(&copy)->size(), 4u);
+
+  v.emplace<std::wstring>(L"bar");
+  TEST_EQ(apply_visitor_extract(shared_take_visitor{}, std::move(v)), 3);
+
+  v.emplace<double>(2.5);
+  TEST_EQ(apply_visitor_extract(shared_take_visitor{}, std::move(v)), 2);
+  TEST_EQ(*get<double>(&v), 2.5);
+}
+
+int
+main() {
+  std::cout << "Extraction tests:" << std::endl;
+  return test_registrar::run_tests();
+}
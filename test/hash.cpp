@@ -1,14 +1,55 @@
 #include <strict_variant/variant.hpp>
+#include <strict_variant/variant_compare.hpp>
 #include <strict_variant/variant_hash.hpp>
 #include <strict_variant/variant_stream_ops.hpp>
 
 #include "test_harness/test_harness.hpp"
 
+#include <cstdint>
+#include <cstring>
+#include <string>
 #include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
+
+// A string type which counts how many times it is made from a C string
+struct name {
+  static int made;
+
+  std::string str;
+
+  name(const char * s)
+    : str(s) {
+    ++made;
+  }
+
+  friend bool operator==(const name & l, const name & r) { return l.str == r.str; }
+  friend bool operator==(const name & l, const char * r) { return l.str == r; }
+};
+
+int name::made = 0;
+
+namespace std {
+
+template <>
+struct hash<name> {
+  std::size_t operator()(const name & n) const { return std::hash<std::string>{}(n.str); }
+};
+
+} // end namespace std
 
 namespace strict_variant {
+namespace detail {
+
+template <>
+struct raw_value_hash<name, const char *> {
+  static std::size_t hash(const char * s) {
+    return std::hash<std::string>{}(std::string(s, std::strlen(s)));
+  }
+};
+
+} // end namespace detail
 
 UNIT_TEST(hashing) {
   using var_t = variant<std::string, int>;
@@ -65,6 +106,114 @@ UNIT_TEST(copying) {
   }
 }
 
+// The same value in two types hashes differently
+UNIT_TEST(hash_types) {
+  using var_t = variant<int, long>;
+  std::hash<var_t> h;
+
+  TEST_TRUE(h(var_t{5}) != h(var_t{5L}));
+
+  std::unordered_set<std::size_t> hashes;
+  for (int i = 0; i < 1000; ++i) {
+    hashes.insert(h(var_t{i}));
+    hashes.insert(h(var_t{static_cast<long>(i)}));
+  }
+  TEST_EQ(hashes.size(), 2000u);
+}
+
+// With mixed_hash, values which differ only in their high bits differ in the low bits
+UNIT_TEST(mixed_hash) {
+  using var_t = variant<int, long>;
+  mixed_hash<var_t> h;
+
+  std::unordered_set<std::size_t> low_bits;
+  for (int i = 0; i < 1000; ++i) {
+    low_bits.insert(h(var_t{i * 1024}) & 1023);
+  }
+  TEST_TRUE(low_bits.size() > 500u);
+}
+
+template <typename V>
+bool
+hash_range_agrees(const std::vector<V> & vec) {
+  std::vector<std::size_t> hashes(vec.size());
+  hash_range(vec.data(), vec.data() + vec.size(), hashes.data());
+  for (std::size_t i = 0; i < vec.size(); ++i) {
+    if (hashes[i] != std::hash<V>{}(vec[i])) { return false; }
+  }
+  return true;
+}
+
+enum class color : char { red, green };
+
+UNIT_TEST(hash_range) {
+  {
+    using var_t = variant<bool, char, color, int, std::uint64_t, const int *>;
+    static const int x = 0;
+    std::vector<var_t> vec{true, 'a', color::green, -7, std::uint64_t{1} << 63, &x, false, 5};
+    TEST_TRUE(hash_range_agrees(vec));
+  }
+  {
+    using var_t = variant<std::string, char, double, int>;
+    std::vector<var_t> vec{'a', 1.5, std::string{"asdf"}, 17, -0.0, std::string{}, 'b'};
+    TEST_TRUE(hash_range_agrees(vec));
+  }
+  {
+    using var_t = variant<char, bool>;
+    std::vector<var_t> vec{'a', true, 'b'};
+    TEST_TRUE(hash_range_agrees(vec));
+  }
+}
+
+UNIT_TEST(transparent_lookup) {
+  using var_t = variant<std::int64_t, std::string>;
+  variant_transparent_hash<var_t> h;
+  variant_transparent_equal<var_t> eq;
+
+  const var_t i{std::int64_t{5}};
+  const var_t s{std::string{"asdf"}};
+
+  TEST_EQ(h(5), h(i));
+  TEST_EQ(h("asdf"), h(s));
+  TEST_EQ(h(std::string{"asdf"}), h(s));
+  TEST_EQ(h(s), std::hash<var_t>{}(s));
+  TEST_TRUE(eq(i, 5));
+  TEST_TRUE(eq(5, i));
+  TEST_TRUE(!eq(i, 6));
+  TEST_TRUE(eq(s, "asdf"));
+  TEST_TRUE(!eq(i, "asdf"));
+  TEST_TRUE(eq(i, var_t{std::int64_t{5}}));
+
+  std::unordered_set<var_t, variant_transparent_hash<var_t>, variant_transparent_equal<var_t>>
+    table{i, s};
+  TEST_EQ(table.size(), 2u);
+  TEST_TRUE(table.count(var_t{"asdf"}));
+
+#if __cplusplus >= 201703L
+  // A string is hashed as a string_view, without making one
+  TEST_EQ(h(std::string_view{"asdf"}), h(s));
+  TEST_TRUE(eq(s, std::string_view{"asdf"}));
+#endif
+}
+
+// With `raw_value_hash` specialized, a value is neither hashed nor compared by making one
+UNIT_TEST(transparent_lookup_no_conversion) {
+  using var_t = variant<std::int64_t, recursive_wrapper<name>>;
+  variant_transparent_hash<var_t> h;
+  variant_transparent_equal<var_t> eq;
+
+  const var_t n{name{"qwer"}};
+  const char * qwer = "qwer";
+
+  name::made = 0;
+  TEST_EQ(h(qwer), h(n));
+  TEST_EQ(h("qwer"), h(n));
+  TEST_TRUE(eq(n, qwer));
+  TEST_TRUE(eq("qwer", n));
+  TEST_TRUE(!eq(n, "asdf"));
+  TEST_EQ(name::made, 0);
+}
+
 } // end namespace strict_variant
 
 int
@@ -0,0 +1,169 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <strict_variant/extract.hpp>
+#include <strict_variant/inline_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace strict_variant;
+
+// Named while incomplete
+struct small;
+struct large;
+struct node;
+
+using msg_t = variant<int, inline_wrapper<small>, inline_wrapper<large>>;
+using tree_t = variant<int, inline_wrapper<node>>;
+
+struct small {
+  int x;
+  int y;
+};
+
+struct large {
+  char data[200];
+};
+
+struct node {
+  std::vector<tree_t> children;
+};
+
+// Has a throwing move, so is never held in place
+struct fragile {
+  int x;
+
+  fragile() = default;
+  fragile(const fragile &) = default;
+  fragile(fragile && other) noexcept(false)
+    : x(other.x) {}
+};
+
+static_assert(detail::is_wrapper<inline_wrapper<small>>::value, "failed a unit test");
+static_assert(inline_wrapper<small>::holds_inline(), "failed a unit test");
+static_assert(!inline_wrapper<large>::holds_inline(), "failed a unit test");
+static_assert(inline_wrapper<large, 256>::holds_inline(), "failed a unit test");
+static_assert(!inline_wrapper<fragile>::holds_inline(), "failed a unit test");
+static_assert(sizeof(inline_wrapper<large>) == 4 * sizeof(void *), "failed a unit test");
+static_assert(sizeof(inline_wrapper<small, 1>) == sizeof(void *), "failed a unit test");
+static_assert(inline_wrapper<node>::holds_inline(), "failed a unit test");
+
+static_assert(std::is_nothrow_move_constructible<inline_wrapper<fragile>>::value,
+              "failed a unit test");
+// Like recursive_wrapper, the variant moves the value, which may allocate,
+// unless it moves wrappers by pointer
+static_assert(!std::is_nothrow_move_constructible<msg_t>::value, "failed a unit test");
+static_assert(std::is_nothrow_move_constructible<variant<blank, inline_wrapper<large>>>::value,
+              "failed a unit test");
+
+// Pierced transparently
+static_assert(std::is_same<decltype(get<small>(static_cast<msg_t *>(nullptr))), small *>::value,
+              "failed a unit test");
+
+UNIT_TEST(inline_wrapper_placement) {
+  inline_wrapper<small> s{small{1, 2}};
+  TEST_TRUE(static_cast<const void *>(&s.get()) == static_cast<const void *>(&s));
+
+  inline_wrapper<large> l{};
+  TEST_TRUE(static_cast<const void *>(&l.get()) != static_cast<const void *>(&l));
+
+  // A heap-held value is moved by pointer
+  l.get().data[0] = 'x';
+  const large * address = &l.get();
+  inline_wrapper<large> m{std::move(l)};
+  TEST_TRUE(&m.get() == address);
+  TEST_EQ(m.get().data[0], 'x');
+
+  // And copied by value
+  inline_wrapper<large> n{m};
+  TEST_TRUE(&n.get() != address);
+  TEST_EQ(n.get().data[0], 'x');
+}
+
+UNIT_TEST(inline_wrapper_variant) {
+  msg_t v{small{3, 4}};
+  TEST_EQ(get<small>(&v)->y, 4);
+
+  v = large{};
+  get<large>(&v)->data[1] = 'y';
+  msg_t w{v};
+  TEST_EQ(get<large>(&w)->data[1], 'y');
+
+  w = small{5, 6};
+  TEST_EQ(get<small>(&w)->x, 5);
+  v = std::move(w);
+  TEST_EQ(get<small>(&v)->x, 5);
+}
+
+UNIT_TEST(inline_wrapper_recursive) {
+  tree_t t{node{}};
+  get<node>(&t)->children.emplace_back(5);
+  get<node>(&t)->children.emplace_back(node{});
+  get<node>(&get<node>(&t)->children.back())->children.emplace_back(6);
+
+  tree_t u{t};
+  TEST_EQ(get<node>(&u)->children.size(), 2u);
+  TEST_EQ(*get<int>(&get<node>(&get<node>(&u)->children.back())->children[0]), 6);
+}
+
+UNIT_TEST(inline_wrapper_release) {
+  // Held in place: moved out to the heap
+  inline_wrapper<small> s{small{1, 2}};
+  std::unique_ptr<small> p = s.release();
+  TEST_EQ(p->y, 2);
+
+  // And adopted back
+  inline_wrapper<small> t{std::move(p)};
+  TEST_FALSE(p);
+  TEST_EQ(t.get().x, 1);
+
+  // Held on the heap: handed over
+  inline_wrapper<large> l{};
+  const large * address = &l.get();
+  std::unique_ptr<large> q = l.release();
+  TEST_TRUE(q.get() == address);
+
+  inline_wrapper<large> m{std::move(q)};
+  TEST_TRUE(&m.get() == address);
+}
+
+struct extract_visitor {
+  std::unique_ptr<large> * owned;
+
+  int operator()(int && i) const { return i; }
+  int operator()(std::unique_ptr<small> && p) const { return p->x; }
+  int operator()(std::unique_ptr<large> && p) const {
+    *owned = std::move(p);
+    return -1;
+  }
+};
+
+UNIT_TEST(inline_wrapper_extract) {
+  std::unique_ptr<large> owned;
+  extract_visitor vis{&owned};
+
+  msg_t v{large{}};
+  const large * address = get<large>(&v);
+  TEST_EQ(apply_visitor_extract(vis, std::move(v)), -1);
+  TEST_TRUE(owned.get() == address);
+  TEST_EQ(v.which(), 0);
+
+  v = small{7, 8};
+  TEST_EQ(apply_visitor_extract(vis, std::move(v)), 7);
+  TEST_EQ(v.which(), 0);
+}
+
+int
+main() {
+  std::cout << "Inline wrapper tests:" << std::endl;
+  return test_registrar::run_tests();
+}
@@ -0,0 +1,165 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <strict_variant/intern.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_hash.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace strict_variant;
+
+struct expr;
+
+namespace std {
+
+template <>
+struct hash<expr> {
+  std::size_t operator()(const expr & e) const;
+};
+
+} // end namespace std
+
+using term = variant<int, interned<expr>>;
+
+// Counts deep comparisons
+struct expr {
+  static std::atomic<int> compares;
+
+  char op;
+  term left;
+  term right;
+
+  friend bool operator==(const expr & l, const expr & r) {
+    ++compares;
+    return l.op == r.op && l.left == r.left && l.right == r.right;
+  }
+};
+
+std::atomic<int> expr::compares{0};
+
+std::size_t
+std::hash<expr>::operator()(const expr & e) const {
+  std::hash<term> h;
+  return (h(e.left) * 31 + h(e.right)) * 31 + static_cast<std::size_t>(e.op);
+}
+
+using table_t = intern_table<expr>;
+
+static_assert(detail::is_wrapper<interned<expr>>::value, "failed a unit test");
+static_assert(detail::is_shared_wrapper<interned<expr>>::value, "failed a unit test");
+static_assert(std::is_nothrow_copy_constructible<interned<expr>>::value, "failed a unit test");
+static_assert(std::is_nothrow_move_constructible<interned<expr>>::value, "failed a unit test");
+
+// A full tree of the given depth, with all leaves equal
+term
+make_tree(int depth) {
+  if (!depth) { return term{1}; }
+  return term{expr{'+', make_tree(depth - 1), make_tree(depth - 1)}};
+}
+
+const expr *
+as_expr(const term & t) {
+  return get<expr>(&t);
+}
+
+UNIT_TEST(intern_sharing) {
+  {
+    const term a = make_tree(10);
+    const term b = make_tree(10);
+
+    // A full tree of 2^10 - 1 nodes, with one distinct node per level
+    TEST_EQ(table_t::instance().size(), 10u);
+
+    // Equal subtrees are the same object
+    TEST_TRUE(as_expr(a) == as_expr(b));
+    TEST_TRUE(as_expr(as_expr(a)->left) == as_expr(as_expr(a)->right));
+
+    // Comparing them doesn't compare the nodes
+    const term d = make_tree(9);
+    expr::compares = 0;
+    TEST_TRUE(a == b);
+    TEST_TRUE(!(a == d));
+    TEST_EQ(expr::compares.load(), 0);
+
+    // Equal values hash equal
+    TEST_EQ(std::hash<term>{}(a), std::hash<term>{}(b));
+
+    const term c{expr{'*', term{2}, term{3}}};
+    TEST_TRUE(!(a == c));
+    TEST_EQ(table_t::instance().size(), 11u);
+  }
+
+  // The last reference removes a value
+  TEST_EQ(table_t::instance().size(), 0u);
+}
+
+UNIT_TEST(intern_copy_on_write) {
+  term a{expr{'+', term{1}, term{2}}};
+  const term b{expr{'+', term{1}, term{2}}};
+  TEST_TRUE(as_expr(a) == as_expr(b));
+
+  // Mutable access gives a private copy, and leaves the table alone
+  expr * e = get<expr>(&a);
+  TEST_TRUE(e != as_expr(b));
+  e->op = '-';
+  TEST_EQ(as_expr(b)->op, '+');
+  TEST_EQ(table_t::instance().size(), 1u);
+
+  // A private copy is compared by value
+  TEST_TRUE(!(a == b));
+  e->op = '+';
+  TEST_TRUE(a == b);
+  TEST_EQ(std::hash<term>{}(a), std::hash<term>{}(b));
+
+  // Assigning a value interns it again
+  a = expr{'+', term{1}, term{2}};
+  TEST_TRUE(as_expr(a) == as_expr(b));
+}
+
+UNIT_TEST(intern_threads) {
+  const int num_threads = 4;
+  std::vector<std::vector<term>> results(num_threads);
+
+  {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i) {
+      threads.emplace_back([&results, i]() {
+        for (int j = 0; j < 200; ++j) {
+          results[i].push_back(make_tree(j % 6));
+          if (j % 3) { results[i].erase(results[i].begin()); }
+        }
+      });
+    }
+    for (auto & t : threads) {
+      t.join();
+    }
+  }
+
+  // Every thread got the same canonical values
+  for (int i = 1; i < num_threads; ++i) {
+    TEST_EQ(results[i].size(), results[0].size());
+    for (std::size_t j = 0; j < results[0].size(); ++j) {
+      TEST_TRUE(as_expr(results[i][j]) == as_expr(results[0][j]));
+    }
+  }
+
+  results.clear();
+  TEST_EQ(table_t::instance().size(), 0u);
+}
+
+int
+main() {
+  std::cout << "Intern tests:" << std::endl;
+  return test_registrar::run_tests();
+}
@@ -0,0 +1,261 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <strict_variant/iterative_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace strict_variant;
+
+// A list, long enough to overflow the stack if it were destroyed recursively
+struct cons;
+
+using list_t = variant<blank, int, iterative_wrapper<cons>>;
+
+struct cons {
+  int head;
+  list_t tail;
+};
+
+static_assert(detail::is_wrapper<iterative_wrapper<cons>>::value, "failed a unit test");
+static_assert(pointer_move<list_t>::value, "failed a unit test");
+
+static constexpr int list_length = 1000000;
+
+list_t
+make_list(int length) {
+  list_t result{0};
+  for (int i = 1; i < length; ++i) {
+    list_t next{cons{i, std::move(result)}};
+    result = std::move(next);
+  }
+  return result;
+}
+
+// The sum of the list, and its length
+int
+list_length_of(const list_t & l, long long * sum) {
+  int length = 0;
+  const list_t * p = &l;
+  while (const cons * c = get<cons>(p)) {
+    *sum += c->head;
+    ++length;
+    p = &c->tail;
+  }
+  if (const int * i = get<int>(p)) {
+    *sum += *i;
+    ++length;
+  }
+  return length;
+}
+
+UNIT_TEST(iterative_destroy) {
+  list_t l = make_list(list_length);
+  long long sum = 0;
+  TEST_EQ(list_length_of(l, &sum), list_length);
+
+  l = 5;
+  TEST_EQ(*get<int>(&l), 5);
+}
+
+UNIT_TEST(iterative_copy) {
+  const list_t l = make_list(list_length);
+
+  list_t copy{l};
+  long long sum = 0;
+  long long copy_sum = 0;
+  TEST_EQ(list_length_of(l, &sum), list_length);
+  TEST_EQ(list_length_of(copy, &copy_sum), list_length);
+  TEST_EQ(sum, copy_sum);
+  TEST_TRUE(get<cons>(&l) != get<cons>(&copy));
+
+  // Copying the value rather than the wrapper
+  list_t copy2{*get<cons>(&l)};
+  copy_sum = 0;
+  TEST_EQ(list_length_of(copy2, &copy_sum), list_length);
+}
+
+// A tree, whose nodes may throw when copied
+struct node;
+
+using tree_t = variant<int, iterative_wrapper<node>>;
+
+struct node {
+  static int copies_left;
+
+  std::vector<tree_t> children;
+
+  node() = default;
+  node(const node & other)
+    : children(other.children) {
+    if (copies_left-- == 0) { throw std::runtime_error{"node"}; }
+  }
+};
+
+int node::copies_left = -1;
+
+tree_t
+make_tree(int depth) {
+  node n;
+  for (int i = 0; i < 3; ++i) {
+    if (depth) {
+      n.children.emplace_back(make_tree(depth - 1));
+    } else {
+      n.children.emplace_back(i);
+    }
+  }
+  return tree_t{std::move(n)};
+}
+
+int
+tree_sum(const tree_t & t) {
+  if (const int * i = get<int>(&t)) { return *i; }
+  int result = 0;
+  for (const tree_t & c : get<node>(&t)->children) {
+    result += tree_sum(c);
+  }
+  return result;
+}
+
+UNIT_TEST(iterative_copy_tree) {
+  const tree_t t = make_tree(6);
+  const int sum = tree_sum(t);
+  TEST_EQ(sum, 729 * 3);
+
+  tree_t u{t};
+  TEST_EQ(tree_sum(u), sum);
+
+  u = make_tree(2);
+  TEST_EQ(tree_sum(u), 9 * 3);
+}
+
+UNIT_TEST(iterative_copy_throws) {
+  const tree_t t = make_tree(4);
+
+  // Throws partway through, the partial copy is cleaned up (checked by ASan)
+  node::copies_left = 50;
+  bool thrown = false;
+  try {
+    tree_t u{t};
+  } catch (std::runtime_error &) { thrown = true; }
+  TEST_TRUE(thrown);
+
+  // And the next copy works
+  node::copies_left = -1;
+  tree_t u{t};
+  TEST_EQ(tree_sum(u), tree_sum(t));
+}
+
+// Nodes whose copy ctor copies each child into a vector which grows, so that
+// the children whose copies are deferred are moved, or copied, by the parent.
+// Then it reads them, which copies them right away.
+struct bush;
+
+using bush_t = variant<blank, int, iterative_wrapper<bush>>;
+
+struct bush {
+  std::vector<bush_t> children;
+  int size = 1;
+
+  bush() = default;
+  bush(const bush & other) {
+    for (const bush_t & c : other.children) {
+      children.push_back(c);
+    }
+    for (const bush_t & c : children) {
+      if (const bush * b = get<bush>(&c)) { size += b->size; }
+    }
+  }
+};
+
+// Moved by pointer, so the deferred copies follow the children
+static_assert(pointer_move<bush_t>::value, "failed a unit test");
+
+template <typename Tree, typename Node>
+Tree
+make_grown_tree(int depth) {
+  Node n;
+  for (int i = 0; i < 5; ++i) {
+    if (depth) {
+      n.children.push_back(make_grown_tree<Tree, Node>(depth - 1));
+    } else {
+      n.children.push_back(Tree{i});
+    }
+  }
+  return Tree{std::move(n)};
+}
+
+template <typename Tree, typename Node>
+int
+grown_tree_sum(const Tree & t) {
+  if (const int * i = get<int>(&t)) { return *i; }
+  int result = 0;
+  for (const Tree & c : get<Node>(&t)->children) {
+    result += grown_tree_sum<Tree, Node>(c);
+  }
+  return result;
+}
+
+// The same, moved by value, so the children are copied when the vector grows
+struct hedge;
+
+using hedge_t = variant<int, iterative_wrapper<hedge>>;
+
+struct hedge {
+  std::vector<hedge_t> children;
+
+  hedge() = default;
+  hedge(const hedge & other) {
+    for (const hedge_t & c : other.children) {
+      children.push_back(c);
+    }
+  }
+};
+
+static_assert(!pointer_move<hedge_t>::value, "failed a unit test");
+
+UNIT_TEST(iterative_copy_pending_children) {
+  const bush_t b = make_grown_tree<bush_t, bush>(4);
+  const int sum = grown_tree_sum<bush_t, bush>(b);
+  TEST_EQ(sum, 625 * 10);
+
+  bush_t b2{b};
+  TEST_EQ((grown_tree_sum<bush_t, bush>(b2)), sum);
+  TEST_EQ(get<bush>(&b2)->size, 1 + 5 + 25 + 125 + 625);
+
+  const hedge_t h = make_grown_tree<hedge_t, hedge>(4);
+  hedge_t h2{h};
+  TEST_EQ((grown_tree_sum<hedge_t, hedge>(h2)), sum);
+}
+
+// A node with many children, each of which is moved several times while its
+// copy is pending, as the parent's vector grows
+UNIT_TEST(iterative_copy_wide) {
+  constexpr int width = 50000;
+  bush root;
+  for (int i = 0; i < width; ++i) {
+    bush leaf;
+    leaf.children.push_back(bush_t{1});
+    root.children.push_back(bush_t{std::move(leaf)});
+  }
+  const bush_t b{std::move(root)};
+
+  bush_t b2{b};
+  TEST_EQ((grown_tree_sum<bush_t, bush>(b2)), width);
+  TEST_EQ(get<bush>(&b2)->size, 1 + width);
+}
+
+int
+main() {
+  std::cout << "Iterative wrapper tests:" << std::endl;
+  return test_registrar::run_tests();
+}
@@ -0,0 +1,161 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <strict_variant/monotonic_allocator.hpp>
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace strict_variant;
+
+static_assert(detail::is_wrapper<monotonic_wrapper<std::string>>::value, "failed a unit test");
+static_assert(std::is_same<std::allocator_traits<monotonic_allocator<int>>::rebind_alloc<double>,
+                           monotonic_allocator<double>>::value,
+              "failed a unit test");
+
+// The wrapper carries a pointer to its buffer
+static_assert(sizeof(monotonic_wrapper<std::string>) == 2 * sizeof(void *), "failed a unit test");
+
+UNIT_TEST(monotonic_buffer) {
+  monotonic_buffer buf{64};
+  void * p = buf.allocate(1);
+  void * q = buf.allocate(1);
+  TEST_EQ(reinterpret_cast<std::uintptr_t>(p) % monotonic_buffer::align, 0u);
+  TEST_EQ(reinterpret_cast<std::uintptr_t>(q) % monotonic_buffer::align, 0u);
+  TEST_EQ(static_cast<char *>(q) - static_cast<char *>(p),
+          static_cast<std::ptrdiff_t>(monotonic_buffer::align));
+
+  // Larger than a chunk
+  void * r = buf.allocate(1000);
+  TEST_TRUE(r != nullptr);
+  buf.release();
+  void * s = buf.allocate(8);
+  TEST_TRUE(s != nullptr);
+
+  TEST_TRUE(monotonic_buffer::current() == nullptr);
+  {
+    monotonic_buffer::scope sc{buf};
+    TEST_EQ(monotonic_buffer::current(), &buf);
+    {
+      monotonic_buffer inner;
+      monotonic_buffer::scope sc2{inner};
+      TEST_EQ(monotonic_buffer::current(), &inner);
+    }
+    TEST_EQ(monotonic_buffer::current(), &buf);
+  }
+  TEST_TRUE(monotonic_buffer::current() == nullptr);
+}
+
+// A request-scoped list in a buffer
+
+struct cell;
+
+using list_t = variant<int, monotonic_wrapper<cell>>;
+
+struct cell {
+  int head;
+  list_t tail;
+};
+
+// Builds the list 1, 2, ..., length, ending in 0
+list_t
+make_list(int length) {
+  list_t l{0};
+  for (int i = length; i > 0; --i) {
+    list_t next{cell{i, std::move(l)}};
+    l = std::move(next);
+  }
+  return l;
+}
+
+// The sum of the list, and the address of each cell
+int
+list_sum(const list_t & l, std::vector<const cell *> * cells) {
+  int sum = 0;
+  const list_t * p = &l;
+  while (const cell * c = get<cell>(p)) {
+    if (cells) { cells->push_back(c); }
+    sum += c->head;
+    p = &c->tail;
+  }
+  return sum + *get<int>(p);
+}
+
+UNIT_TEST(monotonic_list) {
+  monotonic_buffer buf;
+  monotonic_buffer other;
+
+  list_t l;
+  {
+    monotonic_buffer::scope sc{buf};
+    l = make_list(10);
+  }
+  std::vector<const cell *> cells;
+  TEST_EQ(list_sum(l, &cells), 55);
+
+  // The cells are packed into the buffer, with nothing between them
+  constexpr std::size_t align = monotonic_buffer::align;
+  constexpr std::ptrdiff_t stride = (sizeof(cell) + align - 1) / align * align;
+  TEST_EQ(cells.size(), 10u);
+  std::sort(cells.begin(), cells.end(), std::less<const cell *>{});
+  for (std::size_t i = 1; i < cells.size(); ++i) {
+    const char * prev = reinterpret_cast<const char *>(cells[i - 1]);
+    TEST_EQ(reinterpret_cast<const char *>(cells[i]) - prev, stride);
+  }
+
+  // A copy comes from the same buffer, even outside of the scope
+  list_t copy{l};
+  TEST_EQ(list_sum(copy, nullptr), 55);
+
+  monotonic_wrapper<std::string> w{std::allocator_arg, monotonic_allocator<std::string>{buf}, "x"};
+  monotonic_wrapper<std::string> w2{w};
+  TEST_EQ(w2.get_allocator().buffer(), &buf);
+
+  // Explicitly placed in another buffer
+  list_t u{emplace_tag<cell>{}, std::allocator_arg, monotonic_allocator<cell>{other}};
+  TEST_EQ(u.which(), 1);
+  get<cell>(&u)->head = 3;
+  get<cell>(&u)->tail = copy;
+  TEST_EQ(list_sum(u, nullptr), 58);
+
+  // Without a scope, the heap is used
+  list_t h = make_list(3);
+  TEST_EQ(list_sum(h, nullptr), 6);
+}
+
+UNIT_TEST(monotonic_variant) {
+  struct throwing_move {
+    throwing_move() = default;
+    throwing_move(const throwing_move &) {}
+    throwing_move(throwing_move &&) {}
+    throwing_move & operator=(const throwing_move &) { return *this; }
+  };
+
+  static_assert(std::is_same<monotonic_variant<int, throwing_move>,
+                             variant<int, monotonic_wrapper<throwing_move>>>::value,
+                "failed a unit test");
+
+  monotonic_buffer buf;
+  monotonic_buffer::scope sc{buf};
+  monotonic_variant<int, throwing_move> v{5};
+  v = throwing_move{};
+  TEST_EQ(v.which(), 1);
+}
+
+int
+main() {
+  std::cout << "Monotonic allocator tests:" << std::endl;
+  return test_registrar::run_tests();
+}
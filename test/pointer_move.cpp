@@ -0,0 +1,161 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Every variant type with a fallback value moves wrappers by pointer in this test
+#define STRICT_VARIANT_POINTER_MOVE
+
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+using namespace strict_variant;
+
+// Has a throwing move, so it has to be wrapped
+struct big {
+  std::string s;
+
+  big() = default;
+  explicit big(std::string str)
+    : s(std::move(str)) {}
+  big(const big &) = default;
+  big(big && other) noexcept(false)
+    : s(std::move(other.s)) {}
+  big & operator=(const big &) = default;
+  big & operator=(big && other) noexcept(false) {
+    s = std::move(other.s);
+    return *this;
+  }
+};
+
+using var_t = variant<recursive_wrapper<big>, int>;
+
+static_assert(pointer_move<var_t>::value, "failed a unit test");
+static_assert(std::is_nothrow_move_constructible<var_t>::value, "failed a unit test");
+static_assert(std::is_nothrow_move_assignable<var_t>::value, "failed a unit test");
+static_assert(std::is_nothrow_move_assignable<easy_variant<big, std::string, int>>::value,
+              "failed a unit test");
+
+// No fallback value, so the macro does not apply
+using no_fallback_t = variant<recursive_wrapper<big>, recursive_wrapper<std::string>>;
+
+static_assert(!pointer_move<no_fallback_t>::value, "failed a unit test");
+static_assert(!std::is_nothrow_move_constructible<no_fallback_t>::value, "failed a unit test");
+
+// Opted out
+using value_move_t = variant<int, recursive_wrapper<big>, double>;
+
+namespace strict_variant {
+template <>
+struct pointer_move<value_move_t> : std::false_type {};
+} // end namespace strict_variant
+
+static_assert(!std::is_nothrow_move_constructible<value_move_t>::value, "failed a unit test");
+
+UNIT_TEST(pointer_move_ctor) {
+  var_t a{big{"foo"}};
+  const big * address = get<big>(&a);
+
+  var_t b{std::move(a)};
+  TEST_TRUE(get<big>(&b) == address);
+  TEST_EQ(get<big>(&b)->s, "foo");
+
+  // The moved-from variant holds the fallback value
+  TEST_EQ(a.which(), 1);
+  TEST_EQ(*get<int>(&a), 0);
+
+  // Values held in place are moved as usual
+  var_t c{std::move(a)};
+  TEST_EQ(c.which(), 1);
+  TEST_EQ(a.which(), 1);
+}
+
+UNIT_TEST(pointer_move_assign) {
+  var_t a{big{"foo"}};
+  var_t b{big{"bar"}};
+  const big * address = get<big>(&a);
+
+  // Same type
+  b = std::move(a);
+  TEST_TRUE(get<big>(&b) == address);
+  TEST_EQ(get<big>(&b)->s, "foo");
+  TEST_EQ(a.which(), 1);
+
+  // Different type
+  a = 5;
+  a = std::move(b);
+  TEST_TRUE(get<big>(&a) == address);
+  TEST_EQ(b.which(), 1);
+
+  b = 7;
+  a = std::move(b);
+  TEST_EQ(*get<int>(&a), 7);
+  TEST_EQ(b.which(), 1);
+
+  // Self move assignment leaves the value alone
+  a = big{"baz"};
+  address = get<big>(&a);
+  var_t & alias = a;
+  a = std::move(alias);
+  TEST_TRUE(get<big>(&a) == address);
+  TEST_EQ(get<big>(&a)->s, "baz");
+}
+
+// A node whose child is held inside it
+struct node;
+using node_var_t = variant<int, recursive_wrapper<node>>;
+
+struct node {
+  node_var_t child;
+  std::unique_ptr<int> payload;
+};
+
+static_assert(pointer_move<node_var_t>::value, "failed a unit test");
+
+node_var_t
+make_node(int leaf, int payload) {
+  node n;
+  n.child = leaf;
+  n.payload.reset(new int(payload));
+  return node_var_t{std::move(n)};
+}
+
+UNIT_TEST(pointer_move_aliasing) {
+  // The right hand side is inside the value being replaced
+  node_var_t a{make_node(0, 1)};
+  get<node>(&a)->child = make_node(2, 3);
+  const node * address = get<node>(&get<node>(&a)->child);
+
+  a = std::move(get<node>(&a)->child);
+  TEST_TRUE(get<node>(&a) == address);
+  TEST_EQ(*get<node>(&a)->payload, 3);
+  TEST_EQ(*get<int>(&get<node>(&a)->child), 2);
+}
+
+UNIT_TEST(pointer_move_opt_out) {
+  value_move_t a{big{"foo"}};
+  const big * address = get<big>(&a);
+
+  value_move_t b{std::move(a)};
+  TEST_TRUE(get<big>(&b) != address);
+  TEST_EQ(get<big>(&b)->s, "foo");
+  TEST_EQ(a.which(), 1);
+
+  no_fallback_t c{big{"bar"}};
+  no_fallback_t d{std::move(c)};
+  TEST_EQ(get<big>(&d)->s, "bar");
+  TEST_EQ(c.which(), 0);
+}
+
+int
+main() {
+  std::cout << "Pointer move tests:" << std::endl;
+  return test_registrar::run_tests();
+}
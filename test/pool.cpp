@@ -0,0 +1,275 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <strict_variant/pool_allocator.hpp>
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace strict_variant;
+
+// Pooled wrappers are wrappers
+
+static_assert(detail::is_wrapper<pool_wrapper<std::string>>::value, "failed a unit test");
+static_assert(std::is_same<unwrap_type_t<pool_wrapper<std::string>>, std::string>::value,
+              "failed a unit test");
+static_assert(spare_bits<pool_wrapper<std::string>>::value
+                == spare_bits<recursive_wrapper<std::string>>::value,
+              "failed a unit test");
+
+// Rebinding
+
+static_assert(std::is_same<std::allocator_traits<pool_allocator<int>>::rebind_alloc<double>,
+                           pool_allocator<double>>::value,
+              "failed a unit test");
+
+// pool_variant wraps types with throwing moves, like easy_variant
+
+struct throwing_move {
+  throwing_move() = default;
+  throwing_move(const throwing_move &) {}
+  throwing_move(throwing_move &&) {}
+  throwing_move & operator=(const throwing_move &) { return *this; }
+};
+
+static_assert(std::is_same<pool_variant<int, throwing_move>,
+                           variant<int, pool_wrapper<throwing_move>>>::value,
+              "failed a unit test");
+
+UNIT_TEST(pool_allocator_reuse) {
+  pool_allocator<std::string> a;
+
+  std::string * p = a.allocate(1);
+  TEST_EQ(reinterpret_cast<std::uintptr_t>(p) % alignof(std::max_align_t), 0u);
+  a.deallocate(p, 1);
+
+  // The free list is LIFO
+  std::string * q = a.allocate(1);
+  TEST_EQ(p, q);
+
+  // Blocks of a slab are handed out in address order
+  std::string * r = a.allocate(1);
+  TEST_TRUE(r != q);
+  a.deallocate(r, 1);
+  a.deallocate(q, 1);
+
+  // Arrays don't come from the pool
+  std::string * arr = a.allocate(3);
+  TEST_TRUE(arr != nullptr);
+  a.deallocate(arr, 3);
+
+  pool_allocator<int> b{a};
+  TEST_TRUE(a == b);
+  TEST_TRUE(!(a != b));
+}
+
+// A tree of pooled nodes
+
+struct node;
+
+using tree_t = variant<int, pool_wrapper<node>>;
+
+struct node {
+  tree_t left;
+  tree_t right;
+};
+
+struct sum_visitor {
+  int operator()(int i) const { return i; }
+  int operator()(const node & n) const {
+    return apply_visitor(*this, n.left) + apply_visitor(*this, n.right);
+  }
+};
+
+void
+fill(tree_t & t, int depth) {
+  if (!depth) {
+    t = 1;
+    return;
+  }
+  t.emplace<node>();
+  fill(get<node>(&t)->left, depth - 1);
+  fill(get<node>(&t)->right, depth - 1);
+}
+
+UNIT_TEST(pool_wrapper_tree) {
+  tree_t t;
+  fill(t, 10);
+  TEST_EQ(t.which(), 1);
+  TEST_EQ(apply_visitor(sum_visitor{}, t), 1024);
+
+  tree_t copy{t};
+  TEST_EQ(apply_visitor(sum_visitor{}, copy), 1024);
+
+  get<node>(&copy)->left = 5;
+  TEST_EQ(apply_visitor(sum_visitor{}, copy), 517);
+  TEST_EQ(apply_visitor(sum_visitor{}, t), 1024);
+
+  t = std::move(copy);
+  TEST_EQ(apply_visitor(sum_visitor{}, t), 517);
+
+  t = 3;
+  TEST_EQ(apply_visitor(sum_visitor{}, t), 3);
+}
+
+UNIT_TEST(pool_variant) {
+  pool_variant<int, std::string, throwing_move> v{5};
+  TEST_EQ(v.which(), 0);
+  v = throwing_move{};
+  TEST_EQ(v.which(), 2);
+  TEST_TRUE(get<throwing_move>(&v));
+  v = std::string{"foo"};
+  TEST_EQ(v.which(), 1);
+}
+
+// Blocks may be freed by a different thread from the one that allocated them
+
+UNIT_TEST(pool_threads) {
+  std::vector<tree_t> trees(4);
+  std::vector<std::thread> threads;
+  for (tree_t & t : trees) {
+    threads.emplace_back([&t]() { fill(t, 8); });
+  }
+  for (std::thread & th : threads) {
+    th.join();
+  }
+  threads.clear();
+
+  for (const tree_t & t : trees) {
+    TEST_EQ(apply_visitor(sum_visitor{}, t), 256);
+  }
+
+  std::thread freer{[&trees]() { trees.clear(); }};
+  freer.join();
+
+  tree_t t;
+  fill(t, 8);
+  TEST_EQ(apply_visitor(sum_visitor{}, t), 256);
+}
+
+// The free blocks of a thread which exits are reused by other threads
+
+struct exit_probe {
+  int x;
+};
+
+UNIT_TEST(pool_thread_exit) {
+  pool_allocator<exit_probe> a;
+  exit_probe * p = nullptr;
+  exit_probe * q = nullptr;
+
+  std::thread first{[&]() {
+    p = a.allocate(1);
+    a.deallocate(p, 1);
+  }};
+  first.join();
+
+  std::thread second{[&]() {
+    q = a.allocate(1);
+    a.deallocate(q, 1);
+  }};
+  second.join();
+
+  TEST_TRUE(p != nullptr);
+  TEST_EQ(p, q);
+}
+
+// A block freed by a thread_local destructor, after the thread's free blocks
+// have been given up, is given up too
+
+struct late_probe {
+  int x;
+};
+
+struct late_holder {
+  late_probe * p = nullptr;
+
+  ~late_holder() {
+    if (p) { pool_allocator<late_probe>{}.deallocate(p, 1); }
+  }
+};
+
+UNIT_TEST(pool_thread_exit_late_free) {
+  pool_allocator<late_probe> a;
+  late_probe * p = nullptr;
+  late_probe * q = nullptr;
+
+  std::thread first{[&]() {
+    // Constructed before the pool is used, so destroyed after it gives up
+    static thread_local late_holder h;
+    h.p = p = a.allocate(1);
+  }};
+  first.join();
+
+  std::thread second{[&]() {
+    q = a.allocate(1);
+    a.deallocate(q, 1);
+  }};
+  second.join();
+
+  TEST_TRUE(p != nullptr);
+  TEST_EQ(p, q);
+}
+
+// Blocks allocated by one thread and freed by another are passed back, so the
+// pool doesn't grow
+
+struct hop {
+  char c[40];
+};
+
+UNIT_TEST(pool_cross_thread) {
+  using pool_t = detail::type_pool<hop>;
+  constexpr int rounds = 20;
+  constexpr std::size_t batch_size = 2000;
+
+  pool_allocator<hop> a;
+  std::vector<hop *> batch;
+  std::atomic<int> turn{0};
+
+  std::thread producer{[&]() {
+    for (int r = 0; r < rounds; ++r) {
+      while (turn.load() != 2 * r) {
+        std::this_thread::yield();
+      }
+      for (std::size_t i = 0; i < batch_size; ++i) {
+        batch.push_back(a.allocate(1));
+      }
+      turn.store(2 * r + 1);
+    }
+  }};
+
+  std::set<hop *> distinct;
+  for (int r = 0; r < rounds; ++r) {
+    while (turn.load() != 2 * r + 1) {
+      std::this_thread::yield();
+    }
+    for (hop * p : batch) {
+      distinct.insert(p);
+      a.deallocate(p, 1);
+    }
+    batch.clear();
+    turn.store(2 * r + 2);
+  }
+  producer.join();
+
+  TEST_TRUE(distinct.size() <= batch_size + 4 * pool_t::blocks_per_slab);
+}
+
+int
+main() {
+  std::cout << "Pool allocator tests:" << std::endl;
+  return test_registrar::run_tests();
+}
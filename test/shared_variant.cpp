@@ -0,0 +1,215 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/shared_variant.hpp>
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace strict_variant;
+
+// Counts the values alive
+struct tracked {
+  static int live;
+
+  int value;
+
+  explicit tracked(int v)
+    : value(v) {
+    ++live;
+  }
+  tracked(const tracked & o)
+    : value(o.value) {
+    ++live;
+  }
+  tracked(tracked && o) noexcept
+    : value(o.value) {
+    ++live;
+  }
+  ~tracked() { --live; }
+
+  tracked & operator=(const tracked &) = default;
+  tracked & operator=(tracked &&) = default;
+};
+
+int tracked::live = 0;
+
+struct describe {
+  std::string operator()(int i) const { return "int " + std::to_string(i); }
+  std::string operator()(const std::string & s) const { return "string " + s; }
+};
+
+struct address_of_string {
+  const std::string * operator()(int) const { return nullptr; }
+  const std::string * operator()(const std::string & s) const { return &s; }
+};
+
+UNIT_TEST(shared_variant_read_store) {
+  using var_t = easy_variant<int, std::string>;
+  shared_variant<var_t> cell{var_t{5}};
+
+  {
+    auto snap = cell.read();
+    TEST_EQ(snap->which(), 0);
+    TEST_EQ(*get<int>(&*snap), 5);
+    TEST_EQ(apply_visitor(describe{}, snap), "int 5");
+  }
+
+  cell.store(var_t{std::string{"foo"}});
+  TEST_EQ(apply_visitor(describe{}, cell), "string foo");
+
+  // The value is visited in place
+  auto snap = cell.read();
+  TEST_TRUE(apply_visitor(address_of_string{}, snap) == get<std::string>(&*snap));
+}
+
+using tracked_var = variant<int, tracked>;
+
+// `tracked` is explicitly constructible from int
+tracked_var
+make_int(int i) {
+  tracked_var v{tracked{0}};
+  v.emplace<int>(i);
+  return v;
+}
+
+UNIT_TEST(shared_variant_reclaim) {
+  using var_t = tracked_var;
+  {
+    shared_variant<var_t> cell{var_t{tracked{1}}};
+    TEST_EQ(tracked::live, 1);
+
+    // Nothing holds the old version
+    cell.store(var_t{tracked{2}});
+    TEST_EQ(tracked::live, 1);
+    TEST_EQ(cell.retired_count(), 0u);
+
+    {
+      auto snap = cell.read();
+      auto moved = std::move(snap);
+      {
+        // Nested snapshots
+        auto inner = cell.read();
+        TEST_EQ(get<tracked>(&*inner)->value, 2);
+      }
+
+      cell.store(var_t{tracked{3}});
+      cell.store(make_int(4));
+      TEST_EQ(tracked::live, 2);
+      TEST_EQ(cell.retired_count(), 2u);
+      TEST_EQ(get<tracked>(&*moved)->value, 2);
+    }
+
+    cell.collect();
+    TEST_EQ(cell.retired_count(), 0u);
+    TEST_EQ(tracked::live, 0);
+
+    // Still held by a snapshot at the last store, freed by the destructor
+    cell.store(var_t{tracked{5}});
+    auto snap = cell.read();
+    cell.store(make_int(6));
+    TEST_EQ(tracked::live, 1);
+  }
+  TEST_EQ(tracked::live, 0);
+}
+
+// A tree whose leaves all hold the version number
+struct tree;
+using tree_t = variant<int, recursive_wrapper<tree>>;
+
+struct tree {
+  std::vector<tree_t> children;
+};
+
+tree_t
+make_tree(int version, int depth) {
+  if (!depth) { return tree_t{version}; }
+  tree t;
+  for (int i = 0; i < 3; ++i) {
+    t.children.push_back(make_tree(version, depth - 1));
+  }
+  return tree_t{std::move(t)};
+}
+
+// Returns the version of the leaves, or -1 if they differ
+struct leaf_version {
+  int operator()(int i) const { return i; }
+  int operator()(const tree & t) const {
+    int result = apply_visitor(*this, t.children[0]);
+    for (const tree_t & c : t.children) {
+      if (apply_visitor(*this, c) != result) { return -1; }
+    }
+    return result;
+  }
+};
+
+UNIT_TEST(shared_variant_threads) {
+  constexpr int num_readers = 4;
+  constexpr int num_versions = 500;
+
+  shared_variant<tree_t> cell{make_tree(0, 4)};
+  std::atomic<bool> done{false};
+  std::atomic<int> errors{0};
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < num_readers; ++i) {
+    readers.emplace_back([&]() {
+      int last = 0;
+      while (!done.load()) {
+        const int v = apply_visitor(leaf_version{}, cell);
+        // Each reader sees the versions in order
+        if (v < last) { ++errors; }
+        last = v;
+      }
+    });
+  }
+
+  for (int v = 1; v <= num_versions; ++v) {
+    cell.store(make_tree(v, 4));
+  }
+  done = true;
+  for (std::thread & t : readers) {
+    t.join();
+  }
+
+  TEST_EQ(errors.load(), 0);
+  TEST_EQ(apply_visitor(leaf_version{}, cell), num_versions);
+  cell.collect();
+  TEST_EQ(cell.retired_count(), 0u);
+}
+
+// A thread's record is given back when it exits, and reused
+UNIT_TEST(shared_variant_records) {
+  shared_variant<variant<int>> cell{variant<int>{1}};
+
+  auto count_records = []() {
+    std::size_t n = 0;
+    for (detail::rcu_record * r = detail::rcu_global().head.load(); r; r = r->next) {
+      ++n;
+    }
+    return n;
+  };
+
+  std::thread{[&cell]() { cell.read(); }}.join();
+  const std::size_t before = count_records();
+  for (int i = 0; i < 50; ++i) {
+    std::thread{[&cell]() { cell.read(); }}.join();
+  }
+  TEST_EQ(count_records(), before);
+}
+
+int
+main() {
+  std::cout << "Shared variant tests:" << std::endl;
+  return test_registrar::run_tests();
+}
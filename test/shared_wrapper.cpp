@@ -0,0 +1,164 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <strict_variant/shared_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace strict_variant;
+
+struct node;
+
+using tree_t = variant<int, shared_wrapper<node>>;
+
+// Counts deep copies
+struct node {
+  static int copies;
+
+  std::vector<tree_t> children;
+
+  node() = default;
+  node(const node & other)
+    : children(other.children) {
+    ++copies;
+  }
+  node(node &&) = default;
+  node & operator=(const node &) = default;
+  node & operator=(node &&) = default;
+};
+
+int node::copies = 0;
+
+static_assert(detail::is_wrapper<shared_wrapper<node>>::value, "failed a unit test");
+static_assert(detail::is_shared_wrapper<local_shared_wrapper<node>>::value, "failed a unit test");
+static_assert(std::is_nothrow_copy_constructible<shared_wrapper<std::string>>::value,
+              "failed a unit test");
+static_assert(std::is_same<decltype(get<node>(static_cast<tree_t *>(nullptr))), node *>::value,
+              "failed a unit test");
+
+UNIT_TEST(shared_wrapper_copy_on_write) {
+  using var_t = variant<int, local_shared_wrapper<std::string>>;
+
+  var_t a{std::string{"foo"}};
+  const var_t b{a};
+
+  // Const access is shared
+  const var_t & ca = a;
+  TEST_TRUE(get<std::string>(&ca) == get<std::string>(&b));
+
+  // Mutable access copies, once
+  std::string * s = get<std::string>(&a);
+  TEST_TRUE(s != get<std::string>(&b));
+  TEST_TRUE(get<std::string>(&a) == s);
+  *s = "bar";
+  TEST_EQ(*get<std::string>(&b), "foo");
+  TEST_EQ(*get<std::string>(&a), "bar");
+
+  // A unique value is not copied
+  var_t c{std::string{"baz"}};
+  const std::string * t = get<std::string>(&static_cast<const var_t &>(c));
+  TEST_TRUE(get<std::string>(&c) == t);
+}
+
+// Only reads, but takes a mutable reference from a non-const variant
+struct count_children_visitor {
+  std::size_t operator()(int) const { return 0; }
+  std::size_t operator()(const node & n) const { return n.children.size(); }
+};
+
+UNIT_TEST(shared_wrapper_visit) {
+  node n;
+  n.children.emplace_back(1);
+  tree_t a{std::move(n)};
+  const tree_t b{a};
+  node::copies = 0;
+
+  // Visiting a const variant reads the shared value
+  const tree_t & ca = a;
+  TEST_EQ(apply_visitor(count_children_visitor{}, ca), 1u);
+  TEST_EQ(node::copies, 0);
+  TEST_TRUE(get<node>(&ca) == get<node>(&b));
+
+  // Visiting a non-const variant copies it, even to read it
+  TEST_EQ(apply_visitor(count_children_visitor{}, a), 1u);
+  TEST_EQ(node::copies, 1);
+  TEST_TRUE(get<node>(&ca) != get<node>(&b));
+}
+
+UNIT_TEST(shared_wrapper_assign) {
+  using var_t = variant<int, local_shared_wrapper<std::string>>;
+
+  var_t a{std::string{"foo"}};
+  var_t b{5};
+  var_t c{std::string{"bar"}};
+
+  // Copy assignment shares, whatever the old type
+  b = a;
+  c = a;
+  const var_t & ca = a;
+  TEST_TRUE(get<std::string>(&static_cast<const var_t &>(b)) == get<std::string>(&ca));
+  TEST_TRUE(get<std::string>(&static_cast<const var_t &>(c)) == get<std::string>(&ca));
+
+  a = a;
+  TEST_EQ(*get<std::string>(&ca), "foo");
+
+  b = 7;
+  TEST_EQ(*get<int>(&b), 7);
+  TEST_EQ(*get<std::string>(&c), "foo");
+}
+
+UNIT_TEST(shared_wrapper_tree) {
+  tree_t root{node{}};
+  for (int i = 0; i < 10; ++i) {
+    node n;
+    n.children.emplace_back(i);
+    n.children.emplace_back(node{});
+    get<node>(&root)->children.emplace_back(std::move(n));
+  }
+
+  node::copies = 0;
+  tree_t copy{root};
+  std::vector<tree_t> copies(10, root);
+  TEST_EQ(node::copies, 0);
+
+  // Changing one child of the copy copies the root, which shares the other children
+  node * child = get<node>(&get<node>(&copy)->children[3]);
+  child->children.emplace_back(42);
+  TEST_EQ(node::copies, 2);
+  TEST_EQ(get<node>(&get<node>(&root)->children[3])->children.size(), 2u);
+  TEST_EQ(get<node>(&get<node>(&copy)->children[3])->children.size(), 3u);
+}
+
+UNIT_TEST(shared_wrapper_threads) {
+  using var_t = variant<int, shared_wrapper<std::string>>;
+
+  const var_t a{std::string{"foo"}};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([a]() {
+      for (int j = 0; j < 1000; ++j) {
+        var_t b{a};
+        b = a;
+      }
+    });
+  }
+  for (auto & t : threads) {
+    t.join();
+  }
+  TEST_EQ(*get<std::string>(&a), "foo");
+}
+
+int
+main() {
+  std::cout << "Shared wrapper tests:" << std::endl;
+  return test_registrar::run_tests();
+}
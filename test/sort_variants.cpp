@@ -0,0 +1,126 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/sort_variants.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_compare.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace strict_variant;
+
+using var_t =
+  variant<std::int8_t, std::uint16_t, int, std::int64_t, float, double, std::string,
+          recursive_wrapper<std::vector<int>>>;
+
+// Integer and floating point types are ambiguous for the constructor
+template <typename T>
+var_t
+make(T t) {
+  var_t v;
+  v.emplace<T>(t);
+  return v;
+}
+
+// Enough of each type to be radix sorted, with duplicates, negative numbers
+// and extreme values
+std::vector<var_t>
+make_sequence(std::size_t n) {
+  std::mt19937 rng{12345};
+  std::vector<var_t> result;
+  for (std::size_t i = 0; i < n; ++i) {
+    const std::uint32_t x = static_cast<std::uint32_t>(rng());
+    const int v = static_cast<int>(x >> 4) % 2000 - 1000;
+    switch (x % 8) {
+      case 0: result.push_back(make(static_cast<std::int8_t>(v))); break;
+      case 1: result.push_back(make(static_cast<std::uint16_t>(x >> 16))); break;
+      case 2:
+        result.push_back(make((x & 0x100) ? v : std::numeric_limits<int>::min() + (v & 0xff)));
+        break;
+      case 3: result.push_back(make(static_cast<std::int64_t>(v) * (std::int64_t{1} << 40))); break;
+      case 4: result.push_back(make(static_cast<float>(v) / 7)); break;
+      case 5: result.push_back(make((x & 0x100) ? static_cast<double>(v) * 1e300 : -0.0)); break;
+      case 6: result.emplace_back(std::to_string(v)); break;
+      default: result.emplace_back(std::vector<int>{v, v % 3}); break;
+    }
+  }
+  return result;
+}
+
+UNIT_TEST(sort_variants) {
+  for (std::size_t n : {0u, 1u, 2u, 100u, 10000u}) {
+    std::vector<var_t> expected = make_sequence(n);
+    std::vector<var_t> actual = expected;
+
+    std::sort(expected.begin(), expected.end(), variant_comparator<var_t>{});
+    sort_variants(actual.begin(), actual.end());
+    TEST_TRUE(expected == actual);
+  }
+}
+
+UNIT_TEST(sort_variants_comparator) {
+  using greater_t = variant_comparator<var_t, std::greater>;
+
+  std::vector<var_t> expected = make_sequence(10000);
+  std::vector<var_t> actual = expected;
+
+  std::sort(expected.begin(), expected.end(), greater_t{});
+  sort_variants(actual.begin(), actual.end(), greater_t{});
+  TEST_TRUE(expected == actual);
+}
+
+UNIT_TEST(unique_variants) {
+  std::vector<var_t> expected = make_sequence(10000);
+  sort_variants(expected.begin(), expected.end());
+  std::vector<var_t> actual = expected;
+
+  expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+  actual.erase(unique_variants(actual.begin(), actual.end()), actual.end());
+  TEST_TRUE(expected == actual);
+  TEST_TRUE(actual.size() < 10000u);
+
+  // Also when equal values are not sorted
+  const var_t one = make(1);
+  const var_t two = make(2.0);
+  const var_t a{std::string{"a"}};
+  std::vector<var_t> v{one, one, two, two, one, a, a, one};
+  v.erase(unique_variants(v.begin(), v.end()), v.end());
+  TEST_TRUE((v == std::vector<var_t>{one, two, one, a, one}));
+}
+
+UNIT_TEST(lower_bound_variants) {
+  std::vector<var_t> sorted = make_sequence(10000);
+  sort_variants(sorted.begin(), sorted.end());
+  variant_comparator<var_t> less;
+
+  std::vector<var_t> probes = make_sequence(500);
+  probes.push_back(make(std::numeric_limits<int>::max()));
+  probes.push_back(var_t{std::string{"zzz"}});
+  probes.push_back(make(std::int8_t{-128}));
+  for (const var_t & p : probes) {
+    auto expected = std::lower_bound(sorted.begin(), sorted.end(), p, less);
+    auto actual = lower_bound_variants(sorted.begin(), sorted.end(), p);
+    TEST_EQ(expected - sorted.begin(), actual - sorted.begin());
+  }
+
+  const std::vector<var_t> empty;
+  TEST_TRUE(lower_bound_variants(empty.begin(), empty.end(), make(1)) == empty.end());
+}
+
+int
+main() {
+  std::cout << "Sort variants tests:" << std::endl;
+  return test_registrar::run_tests();
+}
@@ -6,12 +6,16 @@
 #include <strict_variant/multivisit.hpp>
 #include <strict_variant/variant.hpp>
 #include <strict_variant/variant_stream_ops.hpp>
+#include <strict_variant/visit_range.hpp>
 
 #include "test_harness/test_harness.hpp"
 
 #include <algorithm>
+#include <iterator>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 namespace strict_variant {
 
@@ -182,6 +186,39 @@ static_assert(std::is_nothrow_destructible<variant<int, double>>::value, "failed
 static_assert(std::is_nothrow_move_constructible<variant<int, double>>::value,
               "failed a unit test");
 
+// Check size of discriminator
+static_assert(std::is_same<detail::which_type_t<2>, std::uint8_t>::value, "failed a unit test");
+static_assert(std::is_same<detail::which_type_t<255>, std::uint8_t>::value, "failed a unit test");
+static_assert(std::is_same<detail::which_type_t<256>, std::uint16_t>::value, "failed a unit test");
+static_assert(sizeof(variant<char, bool>) == 2, "failed a unit test");
+static_assert(sizeof(variant<short, char>) == 2 * sizeof(short), "failed a unit test");
+static_assert(sizeof(variant<int, float>) == 2 * sizeof(int), "failed a unit test");
+static_assert(std::is_same<int, decltype(std::declval<variant<char, bool>>().which())>::value,
+              "failed a unit test");
+
+// Check that special member functions are trivial when they can be
+struct trivial_point {
+  int x;
+  int y;
+};
+
+static_assert(std::is_trivially_copyable<variant<int, double, trivial_point>>::value,
+              "failed a unit test");
+static_assert(std::is_trivially_destructible<variant<int, double, trivial_point>>::value,
+              "failed a unit test");
+static_assert(std::is_trivially_copy_constructible<variant<int, float>>::value,
+              "failed a unit test");
+static_assert(std::is_trivially_move_assignable<variant<int, float>>::value, "failed a unit test");
+static_assert(!std::is_trivially_copyable<variant<int, std::string>>::value, "failed a unit test");
+static_assert(!std::is_trivially_destructible<variant<int, std::string>>::value,
+              "failed a unit test");
+static_assert(!std::is_trivially_copyable<variant<int, recursive_wrapper<int>>>::value,
+              "failed a unit test");
+static_assert(std::is_nothrow_move_constructible<variant<int, std::string>>::value,
+              "failed a unit test");
+static_assert(!std::is_nothrow_move_constructible<variant<int, recursive_wrapper<int>>>::value,
+              "failed a unit test");
+
 // Check core traits that enable construction from other types
 template <typename U, typename V>
 struct allow_variant_construction : safely_constructible<unwrap_type_t<U>, V> {};
@@ -850,6 +887,164 @@ UNIT_TEST(throwing_move) {
   TEST_EQ(v.which(), 0);
 }
 
+// Check that a throwing copy ctor doesn't cause the variant dtor to run
+struct count_dtors {
+  static int & count() {
+    static int c = 0;
+    return c;
+  }
+
+  count_dtors() = default;
+  count_dtors(const count_dtors &) { throw std::runtime_error("copy"); }
+  count_dtors(count_dtors &&) noexcept {}
+  ~count_dtors() noexcept { ++count(); }
+};
+
+UNIT_TEST(throwing_copy) {
+  using var_t = variant<int, count_dtors>;
+
+  var_t v{count_dtors{}};
+  TEST_EQ(v.which(), 1);
+  count_dtors::count() = 0;
+
+  bool caught = false;
+  try {
+    var_t v2{v};
+    static_cast<void>(v2);
+  } catch (std::runtime_error &) { caught = true; }
+
+  TEST_TRUE(caught);
+  TEST_EQ(count_dtors::count(), 0);
+  TEST_EQ(v.which(), 1);
+}
+
+// Check that variants of trivial types work in containers
+UNIT_TEST(trivial_copy) {
+  using var_t = variant<int, double, trivial_point>;
+
+  std::vector<var_t> vec;
+  for (int i = 0; i < 100; ++i) {
+    if (i % 3 == 0) {
+      vec.emplace_back(i);
+    } else if (i % 3 == 1) {
+      vec.emplace_back(static_cast<double>(i));
+    } else {
+      vec.emplace_back(trivial_point{i, -i});
+    }
+  }
+
+  std::vector<var_t> vec2(vec);
+  var_t temp;
+  for (int i = 0; i < 100; ++i) {
+    TEST_EQ(vec2[i].which(), i % 3);
+    temp = vec2[i];
+    TEST_EQ(temp.which(), i % 3);
+  }
+
+  TEST_EQ(*strict_variant::get<int>(&vec2[99]), 99);
+  TEST_EQ(*strict_variant::get<double>(&vec2[97]), 97.0);
+  TEST_EQ(strict_variant::get<trivial_point>(&vec2[98])->y, -98);
+}
+
+// Check that every dispatch strategy picks the right type. The large variant
+// spans more than one block of the switch strategy.
+template <int N>
+struct tagged {};
+
+struct tag_visitor {
+  template <int N>
+  int operator()(const tagged<N> &) const {
+    return N;
+  }
+};
+
+template <typename Strategy, typename V, int N>
+struct check_strategy {
+  static void run() {
+    check_strategy<Strategy, V, N - 1>::run();
+
+    V v{tagged<N - 1>{}};
+    TEST_EQ(N - 1, v.which());
+    TEST_EQ(N - 1, apply_visitor_with<Strategy>(tag_visitor{}, v));
+    TEST_EQ(N - 1, apply_visitor_with<Strategy>(tag_visitor{}, static_cast<const V &>(v)));
+    TEST_EQ(N - 1, apply_visitor_with<Strategy>(tag_visitor{}, std::move(v)));
+  }
+};
+
+template <typename Strategy, typename V>
+struct check_strategy<Strategy, V, 0> {
+  static void run() {}
+};
+
+template <typename Strategy>
+void
+check_all_sizes() {
+  check_strategy<Strategy, variant<tagged<0>>, 1>::run();
+  check_strategy<Strategy, variant<tagged<0>, tagged<1>, tagged<2>>, 3>::run();
+  check_strategy<Strategy,
+                 variant<tagged<0>, tagged<1>, tagged<2>, tagged<3>, tagged<4>, tagged<5>,
+                         tagged<6>, tagged<7>, tagged<8>, tagged<9>, tagged<10>, tagged<11>,
+                         tagged<12>, tagged<13>, tagged<14>, tagged<15>, tagged<16>, tagged<17>,
+                         tagged<18>, tagged<19>, tagged<20>, tagged<21>, tagged<22>, tagged<23>,
+                         tagged<24>, tagged<25>, tagged<26>, tagged<27>, tagged<28>, tagged<29>,
+                         tagged<30>, tagged<31>, tagged<32>, tagged<33>>,
+                 34>::run();
+}
+
+UNIT_TEST(dispatch_strategies) {
+  check_all_sizes<dispatch::binary_search>();
+  check_all_sizes<dispatch::jump_table>();
+  check_all_sizes<dispatch::linear>();
+  check_all_sizes<dispatch::switch_table>();
+  check_all_sizes<dispatch::automatic>();
+}
+
+// Weighted strategies
+static_assert(detail::weight_list<1, 1, 1, 1>::split(0, 4) == 2, "");
+static_assert(detail::weight_list<90, 5, 3, 1, 1>::split(0, 5) == 1, "");
+static_assert(detail::weight_list<90, 5, 3, 1, 1>::hint(0, 5) == 1, "");
+static_assert(detail::weight_list<1, 1, 1, 1>::hint(0, 4) == -1, "");
+static_assert(detail::weight_list<1, 1, 1, 10>::split(0, 4) == 3, "");
+static_assert(detail::weight_list<1, 1, 1, 10>::hint(0, 4) == 0, "");
+
+UNIT_TEST(weighted_dispatch_strategies) {
+  using var_5_t = variant<tagged<0>, tagged<1>, tagged<2>, tagged<3>, tagged<4>>;
+
+  check_strategy<dispatch::weighted<90, 5, 3, 1, 1>, var_5_t, 5>::run();
+  check_strategy<dispatch::weighted<1, 1, 1, 1, 100>, var_5_t, 5>::run();
+  check_strategy<dispatch::weighted<0, 0, 0, 0, 0>, var_5_t, 5>::run();
+  check_strategy<dispatch::weighted<7>, variant<tagged<0>>, 1>::run();
+
+  check_strategy<dispatch::hot_types<0>, var_5_t, 5>::run();
+  check_strategy<dispatch::hot_types<4, 2>, var_5_t, 5>::run();
+  check_strategy<dispatch::hot_types<0>, variant<tagged<0>>, 1>::run();
+}
+
+// Check that the strategy can be chosen for a particular variant type
+struct strategy_probe {};
+
+using probe_var_t = variant<int, strategy_probe>;
+
+template <>
+struct dispatch_strategy<probe_var_t> {
+  using type = dispatch::jump_table;
+};
+
+static_assert(std::is_same<dispatch_strategy<probe_var_t>::type, dispatch::jump_table>::value, "");
+static_assert(std::is_same<dispatch_strategy<variant<int>>::type, dispatch::automatic>::value, "");
+
+UNIT_TEST(dispatch_strategy_trait) {
+  probe_var_t v{5};
+  probe_var_t v2{v};
+  TEST_EQ(v2.which(), 0);
+  TEST_EQ(*strict_variant::get<int>(&v2), 5);
+
+  v2 = strategy_probe{};
+  TEST_EQ(v2.which(), 1);
+  v = v2;
+  TEST_EQ(v.which(), 1);
+}
+
 UNIT_TEST(easy_variant) {
   using test_a = test_throwmove<0>;
   using test_b = test_throwmove<1>;
@@ -904,6 +1099,153 @@ UNIT_TEST(multivisit) {
   TEST_EQ(true, apply_visitor(test_eq{}, v1, v2));
 }
 
+// Visitor which reports the types and value categories it was called with
+struct category_visitor {
+  // Two digits: value category (1 const lvalue, 2 lvalue, 3 rvalue), then type
+  template <typename T>
+  static int code(T && t) {
+    return 10 * (std::is_lvalue_reference<T>::value
+                   ? (std::is_const<mpl::remove_reference_t<T>>::value ? 1 : 2)
+                   : 3) +
+           type_code(t);
+  }
+
+  template <typename T>
+  static int type_code(const T &) {
+    return 0;
+  }
+  static int type_code(const int &) { return 1; }
+  static int type_code(const std::string &) { return 2; }
+
+  template <typename A, typename B, typename C>
+  int operator()(A && a, B && b, C && c) const {
+    return 10000 * code(std::forward<A>(a)) + 100 * code(std::forward<B>(b)) +
+           code(std::forward<C>(c));
+  }
+};
+
+UNIT_TEST(multivisit_flat) {
+  using var1_t = variant<int, std::string>;
+  using var2_t = variant<double, int, recursive_wrapper<std::string>>;
+  using var3_t = variant<std::string, bool, float, int>;
+
+  var1_t a{std::string{"a"}};
+  const var2_t b{5};
+  var3_t c{true};
+
+  // Every combination of which values, checked against nested visitation
+  for (int i = 0; i < 2; ++i) {
+    a = (i == 0) ? var1_t{1} : var1_t{std::string{"a"}};
+    for (int j = 0; j < 4; ++j) {
+      switch (j) {
+        case 0: c = std::string{"c"}; break;
+        case 1: c = true; break;
+        case 2: c = 1.5f; break;
+        default: c = 7; break;
+      }
+      TEST_EQ(apply_visitor(category_visitor{}, a, b, c),
+              detail::nested_multivisit_impl(category_visitor{}, a, b, c));
+      TEST_EQ(apply_visitor(category_visitor{}, std::move(a), b, std::move(c)),
+              detail::nested_multivisit_impl(category_visitor{}, std::move(a), b, std::move(c)));
+    }
+  }
+
+  // Other dispatch strategies for the combined index
+  c = 7;
+  TEST_EQ(apply_visitor(category_visitor{}, a, b, c),
+          apply_visitor_with<dispatch::switch_table>(category_visitor{}, a, b, c));
+  TEST_EQ(apply_visitor(category_visitor{}, a, b, c),
+          apply_visitor_with<dispatch::jump_table>(category_visitor{}, a, b, c));
+
+  // recursive_wrapper is pierced
+  var2_t d{std::string{"d"}};
+  TEST_EQ(313022, apply_visitor(category_visitor{}, var1_t{1}, var3_t{true}, d));
+}
+
+static_assert(detail::mixed_radix<2, 3, 4>::size == 24, "");
+static_assert(detail::mixed_radix<2, 3, 4>::digit(23, 0) == 1, "");
+static_assert(detail::mixed_radix<2, 3, 4>::digit(23, 1) == 2, "");
+static_assert(detail::mixed_radix<2, 3, 4>::digit(23, 2) == 3, "");
+static_assert(detail::mixed_radix<2, 3, 4>::digit(6, 1) == 1, "");
+
+// Records the order in which it sees values, and transforms them
+struct range_visitor {
+  std::string order;
+
+  std::string operator()(int i) {
+    order += 'i';
+    return std::to_string(i);
+  }
+  std::string operator()(const std::string & s) {
+    order += 's';
+    return s;
+  }
+  std::string operator()(std::string && s) {
+    order += 'm';
+    return std::move(s);
+  }
+  std::string operator()(double d) {
+    order += 'd';
+    return std::to_string(static_cast<int>(d));
+  }
+};
+
+UNIT_TEST(apply_visitor_range) {
+  using var_t = variant<int, std::string, recursive_wrapper<double>>;
+
+  std::vector<var_t> vec{var_t{std::string{"a"}}, var_t{1}, var_t{2.0}, var_t{std::string{"b"}},
+                         var_t{3}};
+
+  // Grouped by type, in order within each type
+  {
+    range_visitor vis;
+    apply_visitor_range(vis, vec.begin(), vec.end());
+    TEST_EQ(vis.order, "iissd");
+  }
+
+  // Results are in the original order
+  {
+    range_visitor vis;
+    std::vector<std::string> results;
+    apply_visitor_range(vis, vec.cbegin(), vec.cend(), std::back_inserter(results));
+    TEST_EQ(vis.order, "iissd");
+    TEST_EQ(results.size(), vec.size());
+    TEST_EQ(results[0], "a");
+    TEST_EQ(results[1], "1");
+    TEST_EQ(results[2], "2");
+    TEST_EQ(results[3], "b");
+    TEST_EQ(results[4], "3");
+  }
+
+  // Value category of the iterator is respected
+  {
+    range_visitor vis;
+    std::vector<std::string> results(5);
+    auto end = apply_visitor_range(vis, std::make_move_iterator(vec.begin()),
+                                   std::make_move_iterator(vec.end()), results.begin());
+    TEST_TRUE(end == results.end());
+    TEST_EQ(vis.order, "iimmd");
+    TEST_EQ(results[3], "b");
+  }
+
+  // Empty range, and bool results
+  {
+    std::vector<var_t> empty;
+    range_visitor vis;
+    apply_visitor_range(vis, empty.begin(), empty.end());
+    TEST_EQ(vis.order, "");
+
+    struct is_int {
+      bool operator()(int) const { return true; }
+      bool operator()(const std::string &) const { return false; }
+      bool operator()(double) const { return false; }
+    };
+    std::vector<bool> results;
+    apply_visitor_range(is_int{}, vec.begin(), vec.end(), std::back_inserter(results));
+    TEST_TRUE((results == std::vector<bool>{false, true, false, false, true}));
+  }
+}
+
 UNIT_TEST(generalizing_ctor) {
   using var_1_t = variant<int, bool>;
   using var_2_t = variant<bool, int>;
@@ -1161,6 +1503,131 @@ UNIT_TEST(variant_swap) {
   }
 }
 
+////////////////////
+// COMPACT LAYOUT //
+////////////////////
+
+static_assert(detail::which_bits<1>::value == 0, "failed a unit test");
+static_assert(detail::which_bits<2>::value == 1, "failed a unit test");
+static_assert(detail::which_bits<3>::value == 2, "failed a unit test");
+static_assert(detail::which_bits<4>::value == 2, "failed a unit test");
+static_assert(detail::which_bits<5>::value == 3, "failed a unit test");
+static_assert(detail::which_bits<16>::value == 4, "failed a unit test");
+
+static_assert(spare_bits<int>::value == 0, "failed a unit test");
+static_assert(spare_bits<recursive_wrapper<std::string>>::value >= 3, "failed a unit test");
+static_assert(sizeof(recursive_wrapper<std::string>) == sizeof(void *), "failed a unit test");
+
+static_assert(detail::can_compact<recursive_wrapper<int>, recursive_wrapper<std::string>>::value,
+              "failed a unit test");
+static_assert(!detail::can_compact<int, recursive_wrapper<std::string>>::value,
+              "failed a unit test");
+
+struct compact_list {
+  std::vector<std::string> items;
+
+  bool operator==(const compact_list & o) const { return items == o.items; }
+};
+
+using compact_t =
+  variant<recursive_wrapper<std::string>, recursive_wrapper<compact_list>, recursive_wrapper<int>>;
+
+template <>
+struct compact_layout<compact_t> : std::true_type {};
+
+static_assert(sizeof(compact_t) == sizeof(void *), "failed a unit test");
+static_assert(sizeof(variant<recursive_wrapper<std::string>, recursive_wrapper<int>>)
+                > sizeof(void *),
+              "failed a unit test");
+
+// A recursive type
+struct compact_node;
+using compact_expr = variant<recursive_wrapper<int>, recursive_wrapper<compact_node>>;
+
+template <>
+struct compact_layout<compact_expr> : std::true_type {};
+
+struct compact_node {
+  compact_expr lhs;
+  compact_expr rhs;
+};
+
+struct compact_sum {
+  int operator()(int i) const { return i; }
+  int operator()(const compact_node & n) const {
+    return apply_visitor(*this, n.lhs) + apply_visitor(*this, n.rhs);
+  }
+};
+
+UNIT_TEST(compact_layout) {
+  compact_t a{std::string{"foo"}};
+  TEST_EQ(a.which(), 0);
+  TEST_EQ(*get<std::string>(&a), "foo");
+  TEST_FALSE(get<int>(&a));
+
+  compact_t b{5};
+  TEST_EQ(b.which(), 2);
+  TEST_EQ(*get<int>(&b), 5);
+
+  compact_t c{compact_list{{"x", "y", "z"}}};
+  TEST_EQ(c.which(), 1);
+  TEST_EQ(get<compact_list>(&c)->items.size(), 3u);
+
+  // Copy and move
+  compact_t d{a};
+  TEST_EQ(d.which(), 0);
+  TEST_EQ(*get<std::string>(&d), "foo");
+  compact_t e{std::move(c)};
+  TEST_EQ(e.which(), 1);
+  TEST_EQ(get<compact_list>(&e)->items.size(), 3u);
+
+  // Assignment, with and without type change
+  d = std::string{"bar"};
+  TEST_EQ(d.which(), 0);
+  TEST_EQ(*get<std::string>(&d), "bar");
+  d = b;
+  TEST_EQ(d.which(), 2);
+  TEST_EQ(*get<int>(&d), 5);
+  d = std::move(e);
+  TEST_EQ(d.which(), 1);
+  TEST_EQ(get<compact_list>(&d)->items[2], "z");
+  d.emplace<std::string>("baz");
+  TEST_EQ(d.which(), 0);
+  TEST_EQ(*get<std::string>(&d), "baz");
+
+  // Swap
+  swap(a, b);
+  TEST_EQ(a.which(), 2);
+  TEST_EQ(b.which(), 0);
+  TEST_EQ(*get<int>(&a), 5);
+  TEST_EQ(*get<std::string>(&b), "foo");
+  swap(b, d);
+  TEST_EQ(*get<std::string>(&b), "baz");
+  TEST_EQ(*get<std::string>(&d), "foo");
+
+  TEST_TRUE(a == compact_t{5});
+  TEST_TRUE(a != compact_t{6});
+
+  // In a container
+  std::vector<compact_t> vec;
+  for (int i = 0; i < 100; ++i) {
+    vec.emplace_back(i);
+    vec.emplace_back(std::to_string(i));
+  }
+  for (int i = 0; i < 100; ++i) {
+    TEST_EQ(*get<int>(&vec[2 * i]), i);
+    TEST_EQ(*get<std::string>(&vec[2 * i + 1]), std::to_string(i));
+  }
+
+  // A tree
+  compact_expr tree{compact_node{compact_expr{1}, compact_expr{compact_node{2, 3}}}};
+  TEST_EQ(apply_visitor(compact_sum{}, tree), 6);
+  compact_expr tree2{tree};
+  tree = 4;
+  TEST_EQ(apply_visitor(compact_sum{}, tree), 4);
+  TEST_EQ(apply_visitor(compact_sum{}, tree2), 6);
+}
+
 } // end namespace strict_variant
 
 int
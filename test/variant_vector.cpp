@@ -0,0 +1,263 @@
+//  (C) Copyright 2016 - 2017 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <strict_variant/multivisit.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_vector.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+using namespace strict_variant;
+
+using var_t = variant<int, std::string, recursive_wrapper<double>>;
+using vec_t = variant_vector<int, std::string, recursive_wrapper<double>>;
+
+static_assert(std::is_same<vec_t::value_type, var_t>::value, "failed a unit test");
+
+struct describe_visitor {
+  std::string operator()(int i) const { return "i" + std::to_string(i); }
+  std::string operator()(const std::string & s) const { return "s" + s; }
+  std::string operator()(double d) const { return "d" + std::to_string(static_cast<int>(d)); }
+};
+
+// Sums ints and doubles, counts strings, and records the order of the types
+struct sum_visitor {
+  double sum = 0;
+  std::string order;
+
+  void operator()(int i) {
+    sum += i;
+    order += 'i';
+  }
+  void operator()(const std::string &) { order += 's'; }
+  void operator()(double d) {
+    sum += d;
+    order += 'd';
+  }
+};
+
+UNIT_TEST(variant_vector_push_back) {
+  vec_t vec;
+  TEST_TRUE(vec.empty());
+
+  vec.push_back(5);
+  vec.push_back(std::string{"foo"});
+  vec.push_back(1.5);
+  vec.push_back(var_t{7});
+  const var_t v{std::string{"bar"}};
+  vec.push_back(v);
+  vec.emplace_back<double>(2.5);
+  vec.emplace_back<1>(3u, 'a');
+
+  TEST_EQ(vec.size(), 7u);
+  TEST_FALSE(vec.empty());
+
+  TEST_EQ(vec[0].which(), 0);
+  TEST_EQ(vec[1].which(), 1);
+  TEST_EQ(vec[2].which(), 2);
+  TEST_EQ(vec[3].which(), 0);
+  TEST_EQ(vec[4].which(), 1);
+  TEST_EQ(vec[5].which(), 2);
+  TEST_EQ(vec[6].which(), 1);
+
+  TEST_EQ(apply_visitor(describe_visitor{}, vec[0]), "i5");
+  TEST_EQ(apply_visitor(describe_visitor{}, vec[1]), "sfoo");
+  TEST_EQ(apply_visitor(describe_visitor{}, vec[2]), "d1");
+  TEST_EQ(vec[3].visit(describe_visitor{}), "i7");
+  TEST_EQ(vec[4].visit(describe_visitor{}), "sbar");
+  TEST_EQ(apply_visitor_with<dispatch::jump_table>(describe_visitor{}, vec[5]), "d2");
+  TEST_EQ(apply_visitor_with<dispatch::linear>(describe_visitor{}, vec[6]), "saaa");
+
+  TEST_EQ(vec.pool<int>().size(), 2u);
+  TEST_EQ(vec.pool<std::string>().size(), 3u);
+  TEST_EQ(vec.pool<double>().size(), 2u);
+}
+
+UNIT_TEST(variant_vector_reference) {
+  vec_t vec;
+  vec.push_back(5);
+  vec.push_back(std::string{"foo"});
+  vec.push_back(1.5);
+
+  vec_t::reference r = vec[0];
+  TEST_TRUE(r.get<int>());
+  TEST_FALSE(r.get<std::string>());
+  TEST_FALSE(r.get<double>());
+  *r.get<int>() = 10;
+  TEST_EQ(*vec[0].get<int>(), 10);
+
+  vec[1].get<std::string>()->append("bar");
+  vec[2].get<double>();
+  *vec[2].get<double>() += 1.0;
+
+  const vec_t & cvec = vec;
+  vec_t::const_reference cr = cvec[1];
+  static_assert(std::is_same<decltype(cr.get<std::string>()), const std::string *>::value,
+                "failed a unit test");
+  TEST_EQ(*cr.get<std::string>(), "foobar");
+  TEST_EQ(*cvec[2].get<double>(), 2.5);
+
+  vec_t::const_reference cr2 = r;
+  TEST_EQ(cr2.which(), 0);
+
+  var_t copy = cvec[1].to_variant();
+  TEST_EQ(copy.which(), 1);
+  TEST_EQ(*get<std::string>(&copy), "foobar");
+  copy = vec[2].to_variant();
+  TEST_EQ(copy.which(), 2);
+  TEST_EQ(*get<double>(&copy), 2.5);
+}
+
+// Describes both values
+struct describe_pair_visitor {
+  template <typename A, typename B>
+  std::string operator()(const A & a, const B & b) const {
+    return describe_visitor{}(a) + describe_visitor{}(b);
+  }
+};
+
+UNIT_TEST(variant_vector_multivisit) {
+  vec_t vec;
+  vec.push_back(5);
+  vec.push_back(std::string{"foo"});
+  vec.push_back(1.5);
+
+  const var_t v{std::string{"bar"}};
+  TEST_EQ(apply_visitor(describe_pair_visitor{}, vec[0], vec[1]), "i5sfoo");
+  TEST_EQ(apply_visitor(describe_pair_visitor{}, vec[2], v), "d1sbar");
+  TEST_EQ(apply_visitor(describe_pair_visitor{}, v, vec[0]), "sbari5");
+
+  const vec_t & cvec = vec;
+  TEST_EQ(apply_visitor(describe_pair_visitor{}, cvec[1], vec[2]), "sfood1");
+}
+
+UNIT_TEST(variant_vector_pop_back) {
+  vec_t vec;
+  for (int i = 0; i < 10; ++i) {
+    vec.push_back(i);
+    vec.push_back(std::to_string(i));
+  }
+  vec.push_back(0.5);
+
+  TEST_EQ(vec.size(), 21u);
+  vec.pop_back();
+  TEST_EQ(vec.pool<double>().size(), 0u);
+  vec.pop_back();
+  TEST_EQ(vec.pool<std::string>().size(), 9u);
+  vec.pop_back();
+  TEST_EQ(vec.pool<int>().size(), 9u);
+  TEST_EQ(vec.size(), 18u);
+  TEST_EQ(vec.back().visit(describe_visitor{}), "s8");
+
+  // Offsets are reused after pop_back
+  vec.push_back(std::string{"x"});
+  TEST_EQ(vec.back().visit(describe_visitor{}), "sx");
+  TEST_EQ(vec[16].visit(describe_visitor{}), "i8");
+
+  vec.clear();
+  TEST_TRUE(vec.empty());
+  TEST_EQ(vec.pool<std::string>().size(), 0u);
+}
+
+UNIT_TEST(variant_vector_for_each_by_type) {
+  vec_t vec;
+  vec.push_back(std::string{"a"});
+  vec.push_back(1.5);
+  vec.push_back(1);
+  vec.push_back(std::string{"b"});
+  vec.push_back(2);
+
+  sum_visitor s;
+  vec.for_each_by_type(s);
+  TEST_EQ(s.sum, 4.5);
+  TEST_EQ(s.order, "iissd");
+
+  // Values can be modified in place
+  struct doubler {
+    void operator()(int & i) const { i *= 2; }
+    void operator()(std::string & s) const { s += s; }
+    void operator()(double & d) const { d *= 2; }
+  };
+  vec.for_each_by_type(doubler{});
+
+  const vec_t & cvec = vec;
+  sum_visitor s2;
+  cvec.for_each_by_type(s2);
+  TEST_EQ(s2.sum, 9);
+  TEST_EQ(*cvec[3].get<std::string>(), "bb");
+}
+
+// The pool of bool isn't a packed std::vector<bool>, so it gives out bool &
+static_assert(!std::is_constructible<detail::pooled_bool, std::string>::value,
+              "failed a unit test");
+static_assert(!std::is_convertible<bool, detail::pooled_bool>::value, "failed a unit test");
+
+UNIT_TEST(variant_vector_bool) {
+  variant_vector<int, bool> vec;
+  vec.push_back(true);
+  vec.push_back(5);
+  vec.push_back(false);
+  vec.emplace_back<bool>();
+  TEST_EQ(vec.size(), 4u);
+  TEST_EQ(vec.pool<bool>().size(), 3u);
+
+  bool * b = vec[0].get<bool>();
+  TEST_TRUE(b && *b);
+  *b = false;
+  TEST_FALSE(*vec[0].get<bool>());
+  TEST_EQ(*vec[1].get<int>(), 5);
+  TEST_TRUE(vec[3].to_variant() == (variant<int, bool>{false}));
+
+  struct flip {
+    void operator()(int &) const {}
+    void operator()(bool & b) const { b = !b; }
+  };
+  vec.for_each_by_type(flip{});
+  TEST_TRUE(*vec[0].get<bool>() && *vec[2].get<bool>() && *vec[3].get<bool>());
+
+  // The container, and the pool's elements, are copied as usual
+  variant_vector<int, bool> copy{vec};
+  TEST_TRUE(*copy[0].get<bool>());
+  TEST_EQ(*copy[1].get<int>(), 5);
+
+  vec.pop_back();
+  vec.pop_back();
+  TEST_EQ(vec.pool<bool>().size(), 1u);
+  TEST_EQ(vec.back().which(), 0);
+}
+
+// Emplacing a value whose constructor throws leaves the container unchanged
+struct thrower {
+  explicit thrower(bool b) {
+    if (b) { throw std::runtime_error("thrower"); }
+  }
+};
+
+UNIT_TEST(variant_vector_strong_guarantee) {
+  variant_vector<int, thrower> vec;
+  vec.push_back(1);
+  vec.emplace_back<thrower>(false);
+
+  bool caught = false;
+  try {
+    vec.emplace_back<thrower>(true);
+  } catch (std::runtime_error &) { caught = true; }
+
+  TEST_TRUE(caught);
+  TEST_EQ(vec.size(), 2u);
+  TEST_EQ(vec.pool<thrower>().size(), 1u);
+  TEST_EQ(vec.back().which(), 1);
+}
+
+int
+main() {
+  std::cout << "Variant vector tests:" << std::endl;
+  return test_registrar::run_tests();
+}